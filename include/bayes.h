@@ -0,0 +1,27 @@
+#pragma once
+
+#include "matrix.h"
+#include "number.h"
+#include "probability.h"
+#include "vector.h"
+
+/* Discretization of one feature of a Naive Bayes model */
+struct nn_bayes_feature {
+    int     is_binned; /* keys are bin thresholds instead of categories */
+    vector *keys;      /* sorted categories, or the thresholds between bins */
+    matrix *log_likelihood; /* (keys + 1) x classes, log P(event | class); the last row is for unseen categories */
+};
+
+/* Naive Bayes classifier trained from a probability space */
+struct nn_bayes {
+    size_t                   features;
+    struct nn_bayes_feature *feature;
+    vector                  *classes;   /* sorted class values */
+    vector                  *log_prior; /* log P(class) */
+};
+typedef struct nn_bayes bayes;
+
+bayes  *bayes_create(probability *space, char *class_field, char **feature_fields, NN_TYPE alpha);
+void    bayes_delete(bayes *model);
+matrix *bayes_log_posterior(bayes *model, matrix *samples, matrix *result);
+vector *bayes_predict(bayes *model, matrix *samples, vector *result);
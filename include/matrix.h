@@ -2,6 +2,22 @@
 
 #include "vector.h"
 
+/* Reductions of matrix_reduce_rows(), matrix_reduce_columns() and tensor_reduce() */
+enum nn_reduction {
+    NN_SUM,
+    NN_MEAN,
+    NN_MIN,
+    NN_MAX,
+    NN_ARGMIN,
+    NN_ARGMAX,
+    NN_VARIANCE,
+    NN_L1_NORM,
+    NN_L2_NORM
+};
+
+/* Largest extent reduced by argmin or argmax: the positions are tracked and
+ * returned as NN_TYPE, which holds every integer up to 2^24 exactly */
+#define MATRIX_REDUCE_POSITIONS (1 << 24)
 
 #define MATRIX(matrix, row, column)                                            \
     VECTOR(matrix->number.values, (row) * ((matrix)->columns) + (column))
@@ -16,6 +32,8 @@ inline number *number_from_matrix(matrix *A, size_t row, size_t column)
 
 matrix *matrix_create(size_t rows, size_t columns);
 matrix *matrix_seed(matrix *instance, NN_TYPE default_value);
+matrix *matrix_random_uniform(matrix *instance, NN_TYPE min, NN_TYPE max);
+matrix *matrix_random_normal(matrix *instance, NN_TYPE mean, NN_TYPE deviation);
 matrix *matrix_identity(size_t size, NN_TYPE default_value);
 matrix *matrix_create_from_list(size_t rows, size_t columns, NN_TYPE *values);
 matrix *matrix_from_vector(vector *v, size_t columns);
@@ -23,6 +41,8 @@ matrix *matrix_from_vectors(vector **vectors, size_t rows, size_t columns);
 matrix *matrix_diagonal_from_vector(vector *v);
 matrix *matrix_clone(matrix *original);
 matrix *matrix_reshape(matrix *instance, size_t rows, size_t columns);
+matrix *matrix_permute_rows(matrix *instance, const size_t *permutation);
+matrix *matrix_shuffle_rows(matrix *instance);
 
 matrix *matrix_diagonal(matrix *A, size_t row, size_t column);
 vector *matrix_column_vector(matrix *A, size_t column);
@@ -32,15 +52,35 @@ matrix *matrix_minor_matrix(matrix *A, size_t exclude_row, size_t exclude_column
 matrix *matrix_transpose(matrix *instance);
 vector *vector_transformation_by_matrix(matrix *A, vector *x);
 matrix *matrix_multiplication(matrix *A, matrix *B);
+int     matrix_gemm_values(size_t rows, size_t columns, size_t depth, const NN_TYPE *A,
+                           size_t A_row_stride, size_t A_column_stride, const NN_TYPE *B,
+                           size_t B_row_stride, size_t B_column_stride, NN_TYPE *C,
+                           size_t C_row_stride);
+matrix *matrix_addition(matrix *A, const number *w);
+matrix *matrix_subtraction(matrix *A, const number *w);
+matrix *matrix_hadamard_product(matrix *A, const number *w);
+matrix *matrix_division(matrix *A, const number *w);
 matrix *matrix_map(matrix *A, NN_TYPE operation(NN_TYPE));
+matrix *matrix_map_with(matrix *A, NN_TYPE operation(NN_TYPE, NN_TYPE), const number *w);
+matrix *matrix_map_builtin(matrix *A, enum nn_map operation, enum nn_accuracy accuracy);
+matrix *matrix_pow(matrix *A, NN_TYPE exponent, enum nn_accuracy accuracy);
+matrix *matrix_softmax_rows(matrix *A);
+matrix *matrix_log_softmax_rows(matrix *A);
+vector *matrix_log_sum_exp_rows(const matrix *A, vector *result);
+matrix *matrix_normalize_rows(matrix *A, int power);
 matrix *matrix_map_value(matrix *A, NN_TYPE operation(NN_TYPE, NN_TYPE *),
                          NN_TYPE *value);
 int matrix_lu_decomposition(matrix *A, matrix **L, matrix **U);
 
+vector *matrix_reduce_rows(const matrix *A, enum nn_reduction reduction, vector *result);
+vector *matrix_reduce_columns(const matrix *A, enum nn_reduction reduction, vector *result);
 NN_TYPE matrix_sum(matrix *A);
 NN_TYPE matrix_trace(matrix *A);
-NN_TYPE matrix_frobenius_norm(matrix *A);
-NN_TYPE matrix_frobenius_norm_by_trace(matrix *A);
+NN_TYPE matrix_frobenius_norm(const matrix *A);
+NN_TYPE matrix_frobenius_norm_by_trace(const matrix *A);
+NN_TYPE matrix_max_norm(const matrix *A);
+NN_TYPE matrix_one_norm(const matrix *A);
+NN_TYPE matrix_infinity_norm(const matrix *A);
 int   matrix_is_equal(matrix *A, matrix *B);
 NN_TYPE matrix_determinant(matrix *A);
 
@@ -1,4 +1,6 @@
 #include "number.h"
 #include "vector.h"
 #include "matrix.h"
+#include "tensor.h"
 #include "probability.h"
+#include "bayes.h"
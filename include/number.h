@@ -51,6 +51,7 @@ struct nn_number {
 struct nn_vector {
     struct nn_number number;
     size_t           length;
+    NN_TYPE         *prefix; /* cached prefix sums, see vector_prefix_cache() */
 };
 
 struct nn_text {
@@ -65,9 +66,12 @@ struct nn_matrix {
 };
 
 struct nn_tensor {
-    struct nn_number number;
+    struct nn_number number;  /* values: the vector storing the elements */
     size_t           rank;
     size_t          *shape;
+    size_t          *strides; /* elements between two indexes of every dimension */
+    size_t           offset;  /* position of the first element in the storage */
+    size_t           length;  /* number of elements */
 };
 
 
@@ -78,17 +82,42 @@ typedef struct nn_matrix matrix;
 typedef struct nn_tensor tensor;
 
 
+/* Memory layout of the samples matrix of a probability space */
+enum nn_layout {
+    NN_ROW_MAJOR,   /* one sample per row, one field per column */
+    NN_COLUMN_MAJOR /* one field per row, one sample per column */
+};
+
 struct nn_probability {
-    char  **fields;
-    matrix *samples;
+    char          **fields;
+    matrix         *samples;
+    enum nn_layout  layout;
+    size_t          first; /* retracted samples still stored before the window, see probability_retract */
 
     vector **events;
     vector **occurs;
     vector **P;
+    /* per column events of exact fields sorted by value, see probability_event_find */
+    struct nn_probability_lookup *lookups;
 
     float  *variance;
     matrix *covariance;
     matrix *correlation;
+    /* pairwise mutual information, computed on demand, see probability_mutual_information */
+    matrix *mutual_information;
+
+    /* running moments, updated by probability_append/probability_retract */
+    NN_TYPE *mean;
+    matrix  *comoment;
+
+    /* optional memoization of masses, see probability_cache_enable */
+    struct nn_probability_cache *cache;
+
+    /* per column sketches of high-cardinality fields, NULL for exact ones */
+    struct nn_sketch **sketches;
+
+    /* per column bins of continuous fields, NULL for categorical ones */
+    struct nn_bins **bins;
 };
 typedef struct nn_probability probability;
 
@@ -102,14 +131,8 @@ int     number_delete(void *number);
 number *number_ref(number *n);
 void number_unref(number *n);
 
-static inline NN_TYPE nn_random_range(NN_TYPE min, NN_TYPE max)
-{
-    NN_TYPE range  = (max - min);
-    NN_TYPE div    = (float)RAND_MAX / range;
-    NN_TYPE random = min + (rand() / div);
-
-    return random > NN_TYPE_EPSILON ? random : 0;
-}
+/* nn_random_range() */
+#include "random.h"
 
 /* Macro for number verification with logging */
 #define NUMBER_CHECK_LOG(instance, message, ...)                               \
@@ -3,10 +3,45 @@
 #include "number.h"
 #include "vector.h"
 #include "matrix.h"
+#include "sketch.h"
+
+enum nn_binning {
+    NN_BINNING_NONE,
+    NN_BINNING_WIDTH,    /* equal width bins over the range of the samples */
+    NN_BINNING_QUANTILE, /* equal count bins */
+    NN_BINNING_STREAMING /* streaming histogram of merged centroids */
+};
+
+struct nn_bins {
+    enum nn_binning binning;
+    size_t          count;
+    vector         *edges; /* count + 1 edges, NULL for streaming histograms */
+};
+
+/* Bounded LRU cache of marginal and joint masses, see probability_cache_enable() */
+struct nn_probability_cache;
+
+/* Alias table (Vose) to draw the events of a field in constant time */
+struct nn_probability_sampler {
+    size_t  length;
+    vector *events;
+    vector *threshold; /* chance to keep the event of a slot instead of its alias */
+    size_t *alias;
+};
+typedef struct nn_probability_sampler probability_sampler;
 
 // Life Cycle
 probability *probability_from_matrix(matrix *samples, char **fields);
+probability *probability_from_matrix_ref(matrix *samples, char **fields, enum nn_layout layout);
+probability *probability_from_matrix_sketched(matrix *samples, char **fields, char **sketched_fields);
+probability *probability_from_matrix_binned(matrix *samples, char **fields, char **binned_fields, enum nn_binning binning, size_t bins);
 void probability_delete(probability *space); 
+probability *probability_append(probability *space, matrix *rows);
+probability *probability_retract(probability *space, size_t count);
+probability *probability_cache_enable(probability *space, size_t capacity);
+void probability_cache_clear(probability *space);
+void probability_cache_free(probability *space);
+void probability_cache_stats(probability *space, size_t *hits, size_t *misses, size_t *size);
 //probability *probability_space_from_csv(csv *data, char **fields);
 
 // Getters
@@ -14,16 +49,32 @@ NN_TYPE probability_mass_of(probability *space, char *field, NN_TYPE value);
 NN_TYPE probability_mass_and(probability *space, char **fields, NN_TYPE *values);
 NN_TYPE probability_conditional(probability *space, char *A_field, NN_TYPE A_value, char *B_field, NN_TYPE B_value);
 NN_TYPE probability_bayes(probability *space, char *A_field, NN_TYPE A_value, char *B_field, NN_TYPE B_value);
-// //NN_TYPE probability_density(probability *space, NN_TYPE a, NN_TYPE b);
+vector *probability_mass_batch(probability *space, size_t count, char **fields, NN_TYPE *values, vector *result);
+vector *probability_conditional_batch(probability *space, size_t count, char **A_fields, NN_TYPE *A_values, char **B_fields, NN_TYPE *B_values, vector *result);
+vector *probability_bayes_batch(probability *space, size_t count, char **A_fields, NN_TYPE *A_values, char **B_fields, NN_TYPE *B_values, vector *result);
+NN_TYPE probability_density(probability *space, char *field, NN_TYPE x);
+NN_TYPE probability_density_between(probability *space, char *field, NN_TYPE a, NN_TYPE b);
+vector *probability_density_grid(probability *space, char *field, NN_TYPE from, NN_TYPE to, vector *result);
+
+// Sampling
+probability_sampler *probability_sampler_create(probability *space, char *field);
+void                 probability_sampler_delete(probability_sampler *sampler);
+vector              *probability_sampler_draw(probability_sampler *sampler, vector *result);
+matrix              *probability_draw_samples(probability *space, matrix *result);
 // 
 // // Properties
 // NN_TYPE probability_expected_value_conditional(probability *space, char *expected_field, char *related_field, NN_TYPE value);
 NN_TYPE probability_expected_value(probability *space, char *field);
 NN_TYPE probability_matrix_expected_value_of_function(probability *space, char *field, NN_TYPE operation(NN_TYPE));
+NN_TYPE *probability_matrix_expected_value_of_function_batch(probability *space, char *field, size_t count, NN_TYPE (*operations[])(NN_TYPE), NN_TYPE *result);
 NN_TYPE probability_variance(probability *space, char *field);
 NN_TYPE probability_covariance(probability *space, char *field, char *related_field);
 NN_TYPE probability_correlation(probability *space, char *field, char *related_field);
-// size_t probability_get_field_index(probability *space, char *field);
+NN_TYPE probability_entropy(probability *space, char *field);
+NN_TYPE probability_joint_entropy(probability *space, char *field, char *related_field);
+matrix *probability_mutual_information(probability *space);
+size_t  probability_distinct_count(probability *space, char *field);
+size_t  probability_get_field_index(probability *space, char *field);
 // NN_TYPE probability_matrix_expected_value(probability *space, char *);
 // NN_TYPE probability_matrix_expected_value_of_function(probability *space, NN_TYPE operation(NN_TYPE));
 // NN_TYPE probability_variance(probability *space);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "number.h"
+#include <stdint.h>
+
+/* Number of values generated by one stream of the bulk fills */
+#ifndef NN_RANDOM_BLOCK
+    #define NN_RANDOM_BLOCK 4096
+#endif
+
+/* Arrays longer than this are shuffled in parallel blocks */
+#ifndef NN_RANDOM_SHUFFLE_BLOCK
+    #define NN_RANDOM_SHUFFLE_BLOCK (1 << 18)
+#endif
+
+/* xoshiro256+ generator state */
+struct nn_random {
+    uint64_t state[4];
+};
+
+void              random_seed(struct nn_random *generator, uint64_t seed);
+uint64_t          random_next(struct nn_random *generator);
+void              random_jump(struct nn_random *generator);
+NN_TYPE           random_uniform(struct nn_random *generator, NN_TYPE min, NN_TYPE max);
+NN_TYPE           random_normal(struct nn_random *generator, NN_TYPE mean, NN_TYPE deviation);
+struct nn_random *random_thread(void);
+void              random_seed_global(uint64_t seed);
+NN_TYPE          *random_fill_uniform(NN_TYPE *values, size_t length, NN_TYPE min, NN_TYPE max, uint64_t seed);
+NN_TYPE          *random_fill_normal(NN_TYPE *values, size_t length, NN_TYPE mean, NN_TYPE deviation, uint64_t seed);
+uint64_t          random_below(struct nn_random *generator, uint64_t bound);
+void             *random_shuffle(void *values, size_t length, size_t size, uint64_t seed);
+size_t           *random_permutation(size_t *indexes, size_t length, uint64_t seed);
+
+/**
+ * Draws a uniform number in [min, max) from the generator of the calling
+ * thread, flushing values closer to 0 than NN_TYPE_EPSILON to 0.
+ */
+static inline NN_TYPE nn_random_range(NN_TYPE min, NN_TYPE max)
+{
+    NN_TYPE random = random_uniform(random_thread(), min, max);
+
+    return random > NN_TYPE_EPSILON || random < -NN_TYPE_EPSILON ? random : 0;
+}
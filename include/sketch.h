@@ -0,0 +1,39 @@
+#pragma once
+
+#include "number.h"
+
+/* Count-Min width, the mass error is at most e / width of the samples */
+#ifndef NN_SKETCH_WIDTH
+    #define NN_SKETCH_WIDTH 2048
+#endif
+
+/* Count-Min depth, the error bound fails with probability e^-depth */
+#ifndef NN_SKETCH_DEPTH
+    #define NN_SKETCH_DEPTH 5
+#endif
+
+/* HyperLogLog uses 2^precision registers, error about 1.04 / sqrt(2^precision) */
+#ifndef NN_SKETCH_PRECISION
+    #define NN_SKETCH_PRECISION 12
+#endif
+
+/* Number of heavy hitters kept as the events of a sketched column */
+#ifndef NN_SKETCH_HEAVY
+    #define NN_SKETCH_HEAVY 32
+#endif
+
+/* Fixed-memory summary of a stream of values */
+struct nn_sketch {
+    size_t         width;
+    size_t         depth;
+    long          *counts;    /* depth x width Count-Min table */
+    size_t         precision;
+    unsigned char *registers; /* HyperLogLog registers */
+};
+typedef struct nn_sketch sketch;
+
+sketch *sketch_create(size_t width, size_t depth, size_t precision);
+void    sketch_delete(sketch *instance);
+sketch *sketch_add(sketch *instance, NN_TYPE value, long delta);
+NN_TYPE sketch_count(const sketch *instance, NN_TYPE value);
+NN_TYPE sketch_distinct(const sketch *instance);
@@ -1,26 +1,207 @@
 #pragma once
 
+#include "matrix.h"
 #include "vector.h"
 #include <stdarg.h>
 
+/* Maximum number of dimensions of a tensor */
+#define TENSOR_MAX_RANK 16
+
+/* Maximum number of operands of tensor_einsum() */
+#define TENSOR_EINSUM_OPERANDS 8
+
+/* Tensor verifying */
+#define TENSOR_CHECK_LOG(tensor, message, ...)                                 \
+    {                                                                          \
+        CHECK_MEMORY(tensor);                                                  \
+        CHECK((tensor)->number.type == NN_TENSOR,                              \
+              "Wrong tensor type. " message, ##__VA_ARGS__);                   \
+        CHECK((tensor)->rank > 0, "Tensor rank doesn't set. " message,         \
+              ##__VA_ARGS__);                                                  \
+    }
+#define TENSOR_CHECK(tensor) TENSOR_CHECK_LOG(tensor, "")
+
+/* Bounds checking of the rank-specialized accessors, off in release builds */
+#ifndef TENSOR_BOUNDS_CHECK
+    #ifdef NDEBUG
+        #define TENSOR_BOUNDS_CHECK 0
+    #else
+        #define TENSOR_BOUNDS_CHECK DEBUG
+    #endif
+#endif
+
+/**
+ * Returns an index of a tensor after checking it against the rank and the
+ * shape, the program exits when it is out of bounds.
+ */
+static inline size_t tensor_index_check(const tensor *T, size_t rank, size_t axis,
+                                        size_t index)
+{
+    if (T->rank != rank || index >= T->shape[axis]) {
+        fprintf(stderr, "Index %zu out of bounds at dimension %zu of a rank %zu tensor\n",
+                index, axis, T->rank);
+        exit(EXIT_FAILURE);
+    }
+
+    return index;
+}
+
+#if TENSOR_BOUNDS_CHECK
+    #define TENSOR_INDEX(T, rank, axis, index)                                 \
+        tensor_index_check(T, rank, axis, index)
+#else
+    #define TENSOR_INDEX(T, rank, axis, index) ((size_t)(index))
+#endif
+
+/* Position of an element in the storage of a tensor of a known rank */
+#define TENSOR_AT1(T, i)                                                       \
+    ((T)->offset + TENSOR_INDEX(T, 1, 0, i) * (T)->strides[0])
+#define TENSOR_AT2(T, i, j)                                                    \
+    ((T)->offset + TENSOR_INDEX(T, 2, 0, i) * (T)->strides[0]                  \
+     + TENSOR_INDEX(T, 2, 1, j) * (T)->strides[1])
+#define TENSOR_AT3(T, i, j, k)                                                 \
+    ((T)->offset + TENSOR_INDEX(T, 3, 0, i) * (T)->strides[0]                  \
+     + TENSOR_INDEX(T, 3, 1, j) * (T)->strides[1]                              \
+     + TENSOR_INDEX(T, 3, 2, k) * (T)->strides[2])
+#define TENSOR_AT4(T, i, j, k, l)                                              \
+    ((T)->offset + TENSOR_INDEX(T, 4, 0, i) * (T)->strides[0]                  \
+     + TENSOR_INDEX(T, 4, 1, j) * (T)->strides[1]                              \
+     + TENSOR_INDEX(T, 4, 2, k) * (T)->strides[2]                              \
+     + TENSOR_INDEX(T, 4, 3, l) * (T)->strides[3])
+#define TENSOR_AT5(T, i, j, k, l, m)                                           \
+    ((T)->offset + TENSOR_INDEX(T, 5, 0, i) * (T)->strides[0]                  \
+     + TENSOR_INDEX(T, 5, 1, j) * (T)->strides[1]                              \
+     + TENSOR_INDEX(T, 5, 2, k) * (T)->strides[2]                              \
+     + TENSOR_INDEX(T, 5, 3, l) * (T)->strides[3]                              \
+     + TENSOR_INDEX(T, 5, 4, m) * (T)->strides[4])
+#define TENSOR_AT6(T, i, j, k, l, m, n)                                        \
+    ((T)->offset + TENSOR_INDEX(T, 6, 0, i) * (T)->strides[0]                  \
+     + TENSOR_INDEX(T, 6, 1, j) * (T)->strides[1]                              \
+     + TENSOR_INDEX(T, 6, 2, k) * (T)->strides[2]                              \
+     + TENSOR_INDEX(T, 6, 3, l) * (T)->strides[3]                              \
+     + TENSOR_INDEX(T, 6, 4, m) * (T)->strides[4]                              \
+     + TENSOR_INDEX(T, 6, 5, n) * (T)->strides[5])
+
+/* Elements of a tensor of a known rank, usable on both sides of an assignment */
+#define TENSOR1(T, i)             VECTOR((T)->number.values, TENSOR_AT1(T, i))
+#define TENSOR2(T, i, j)          VECTOR((T)->number.values, TENSOR_AT2(T, i, j))
+#define TENSOR3(T, i, j, k)       VECTOR((T)->number.values, TENSOR_AT3(T, i, j, k))
+#define TENSOR4(T, i, j, k, l)    VECTOR((T)->number.values, TENSOR_AT4(T, i, j, k, l))
+#define TENSOR5(T, i, j, k, l, m) VECTOR((T)->number.values, TENSOR_AT5(T, i, j, k, l, m))
+#define TENSOR6(T, i, j, k, l, m, n)                                           \
+    VECTOR((T)->number.values, TENSOR_AT6(T, i, j, k, l, m, n))
+
+/* Walks every element of a tensor of a known rank in row-major order, with
+ * its indexes and its `position` in the storage, which advances by the last
+ * stride so that the innermost loop can be vectorized. The element is
+ * VECTOR(T->number.values, position). */
+#define TENSOR_FOREACH_RUN(T, axis, index, position, from)                     \
+    for (size_t index = 0, position = (from); index < (T)->shape[axis];        \
+         index++, position += (T)->strides[axis])
+
+#define TENSOR_FOREACH1(T, i, position)                                        \
+    TENSOR_FOREACH_RUN(T, 0, i, position, (T)->offset)
+#define TENSOR_FOREACH2(T, i, j, position)                                     \
+    for (size_t i = 0; i < (T)->shape[0]; i++)                                 \
+        TENSOR_FOREACH_RUN(T, 1, j, position,                                  \
+                           (T)->offset + i * (T)->strides[0])
+#define TENSOR_FOREACH3(T, i, j, k, position)                                  \
+    for (size_t i = 0; i < (T)->shape[0]; i++)                                 \
+        for (size_t j = 0; j < (T)->shape[1]; j++)                             \
+            TENSOR_FOREACH_RUN(T, 2, k, position,                              \
+                               (T)->offset + i * (T)->strides[0]               \
+                                   + j * (T)->strides[1])
+#define TENSOR_FOREACH4(T, i, j, k, l, position)                               \
+    for (size_t i = 0; i < (T)->shape[0]; i++)                                 \
+        for (size_t j = 0; j < (T)->shape[1]; j++)                             \
+            for (size_t k = 0; k < (T)->shape[2]; k++)                         \
+                TENSOR_FOREACH_RUN(T, 3, l, position,                          \
+                                   (T)->offset + i * (T)->strides[0]           \
+                                       + j * (T)->strides[1]                   \
+                                       + k * (T)->strides[2])
+#define TENSOR_FOREACH5(T, i, j, k, l, m, position)                            \
+    for (size_t i = 0; i < (T)->shape[0]; i++)                                 \
+        for (size_t j = 0; j < (T)->shape[1]; j++)                             \
+            for (size_t k = 0; k < (T)->shape[2]; k++)                         \
+                for (size_t l = 0; l < (T)->shape[3]; l++)                     \
+                    TENSOR_FOREACH_RUN(T, 4, m, position,                      \
+                                       (T)->offset + i * (T)->strides[0]       \
+                                           + j * (T)->strides[1]               \
+                                           + k * (T)->strides[2]               \
+                                           + l * (T)->strides[3])
+#define TENSOR_FOREACH6(T, i, j, k, l, m, n, position)                         \
+    for (size_t i = 0; i < (T)->shape[0]; i++)                                 \
+        for (size_t j = 0; j < (T)->shape[1]; j++)                             \
+            for (size_t k = 0; k < (T)->shape[2]; k++)                         \
+                for (size_t l = 0; l < (T)->shape[3]; l++)                     \
+                    for (size_t m = 0; m < (T)->shape[4]; m++)                 \
+                        TENSOR_FOREACH_RUN(T, 5, n, position,                  \
+                                           (T)->offset + i * (T)->strides[0]   \
+                                               + j * (T)->strides[1]           \
+                                               + k * (T)->strides[2]           \
+                                               + l * (T)->strides[3]           \
+                                               + m * (T)->strides[4])
+
+/**
+ * Returns an element of a tensor of any rank, one index per dimension.
+ *
+ * Every index is checked against the shape of the tensor, and the program
+ * exits when one of them is out of bounds. Prefer TENSOR1() to TENSOR6() in
+ * loops.
+ */
 inline NN_TYPE TENSOR(tensor *T, ...)
 {
-    size_t index;
+    size_t  index;
     va_list args;
     va_start(args, T);
-    index = 0;
+    index = T->offset;
     for (size_t i = 0; i < T->rank; i++) {
         size_t dim_size, dim_index;
-        dim_size = T->shape[i];
+        dim_size  = T->shape[i];
         dim_index = va_arg(args, size_t);
         if (dim_index >= dim_size) {
             fprintf(stderr, "Index out of bounds\n");
             exit(EXIT_FAILURE);
         }
-        index = index * dim_size + dim_index;
+        index += dim_index * T->strides[i];
     }
     va_end(args);
     return VECTOR(T->number.values, index);
 }
 
-#define number_from_tensor(T, ...) number_create(TENSOR(T, __VA_ARGS__));
\ No newline at end of file
+#define number_from_tensor(T, ...) number_create(TENSOR(T, __VA_ARGS__));
+
+tensor *tensor_create(size_t rank, const size_t *shape);
+tensor *tensor_from_list(size_t rank, const size_t *shape, NN_TYPE *values);
+tensor *tensor_from_vector(vector *v, size_t rank, const size_t *shape);
+tensor *tensor_view(tensor *T, size_t rank, const size_t *shape,
+                    const size_t *strides, size_t offset);
+tensor *tensor_broadcast(tensor *T, size_t rank, const size_t *shape);
+tensor *tensor_permute(tensor *T, const size_t *axes);
+tensor *tensor_reshape(tensor *T, size_t rank, const size_t *shape);
+tensor *tensor_contiguous(tensor *T);
+tensor *tensor_clone(const tensor *T);
+tensor *tensor_seed(tensor *T, NN_TYPE value);
+
+int     tensor_is_contiguous(const tensor *T);
+int     tensor_is_equal(const tensor *T, const tensor *U);
+size_t  tensor_offset(const tensor *T, const size_t *indexes);
+NN_TYPE tensor_get(const tensor *T, const size_t *indexes);
+tensor *tensor_set(tensor *T, const size_t *indexes, NN_TYPE value);
+
+tensor *tensor_addition(tensor *T, const number *w);
+tensor *tensor_subtraction(tensor *T, const number *w);
+tensor *tensor_multiplication(tensor *T, const number *w);
+tensor *tensor_division(tensor *T, const number *w);
+
+tensor *tensor_map(tensor *T, NN_TYPE operation(NN_TYPE));
+tensor *tensor_map_with(tensor *T, NN_TYPE operation(NN_TYPE, NN_TYPE), const tensor *U);
+tensor *tensor_map_builtin(tensor *T, enum nn_map operation, enum nn_accuracy accuracy);
+
+tensor *tensor_reduce(const tensor *T, size_t count, const size_t *axes,
+                      enum nn_reduction reduction, int keepdims);
+
+tensor *tensor_einsum(const char *spec, size_t count, tensor **operands);
+void    tensor_einsum_cache_clear(void);
+
+void tensor_print(const tensor *T);
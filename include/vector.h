@@ -9,18 +9,46 @@
 
 #define number_from_vector(v, index) number_create(VECTOR(v, index))
 
+/* Built-in operations of vector_map_builtin() */
+enum nn_map {
+    NN_EXP,
+    NN_LOG,
+    NN_TANH,
+    NN_SIGMOID,
+    NN_SQRT
+};
+
+/* Element-wise operations of vector_operation_values() */
+enum nn_operation {
+    NN_ADDITION,
+    NN_SUBTRACTION,
+    NN_MULTIPLICATION,
+    NN_DIVISION
+};
+
+/* Accuracy of the built-in operations */
+enum nn_accuracy {
+    NN_PRECISE,
+    NN_FAST
+};
+
 vector *vector_create(size_t length);
 vector *vector_seed(vector *instance, NN_TYPE default_value);
+vector *vector_random_uniform(vector *instance, NN_TYPE min, NN_TYPE max);
+vector *vector_random_normal(vector *instance, NN_TYPE mean, NN_TYPE deviation);
 vector *vector_from_list(size_t length, NN_TYPE values[]);
 vector *vector_unique(const vector *instance);
 vector *vector_clone(const vector *original);
 vector *vector_reshape(vector *instance, size_t length);
 vector *vector_shuffle(const vector *instance);
+vector *vector_permute(vector *instance, const size_t *permutation);
 
 vector *vector_addition(vector *v, const number *w);
 vector *vector_subtraction(vector *v, const number *w);
 vector *vector_multiplication(vector *v, const number *w);
 vector *vector_division(vector *v, const number *w);
+void    vector_operation_values(enum nn_operation operation, NN_TYPE *x, size_t x_stride,
+                                const NN_TYPE *y, size_t y_stride, size_t length);
 
 NN_TYPE vector_dot_product(const vector *v, const vector *w);
 NN_TYPE vector_angle(const vector *v, const vector *w);
@@ -30,20 +58,46 @@ int     vector_is_equal(const vector *v, const vector *w);
 vector *vector_map(vector *v, NN_TYPE operation(NN_TYPE));
 vector *vector_map_value(vector *v, NN_TYPE operation(NN_TYPE, NN_TYPE *),
                          NN_TYPE *value);
+vector *vector_map_builtin(vector *v, enum nn_map operation, enum nn_accuracy accuracy);
+vector *vector_pow(vector *v, NN_TYPE exponent, enum nn_accuracy accuracy);
+void    vector_map_builtin_values(NN_TYPE *values, size_t length, enum nn_map operation,
+                                  enum nn_accuracy accuracy);
+
+NN_TYPE vector_log_sum_exp(const vector *v);
+vector *vector_softmax(vector *v);
+vector *vector_log_softmax(vector *v);
+vector *vector_normalize(vector *v, int power);
+NN_TYPE vector_log_sum_exp_values(const NN_TYPE *values, size_t length);
+void    vector_softmax_values(NN_TYPE *values, size_t length, int is_log);
+void    vector_normalize_values(NN_TYPE *values, size_t length, int power);
 
 int     vector_index_of(const vector *v, NN_TYPE needle);
+int    *vector_index_of_batch(const vector *v, const vector *needles, int *result);
+size_t  vector_lower_bound(const vector *sorted, NN_TYPE needle);
+vector *vector_eytzinger(const vector *sorted, vector *result);
+size_t  vector_eytzinger_lower_bound(const vector *layout, NN_TYPE needle);
 NN_TYPE vector_length(const vector *v);
 vector *vector_unit(const vector *v);
 
 NN_TYPE vector_sum(const vector *v);
 NN_TYPE vector_sum_to(const vector *v, size_t to_index);
 NN_TYPE vector_sum_between(const vector *v, size_t from_index, size_t to_index);
+vector *vector_scan_inclusive(const vector *v, vector *result);
+vector *vector_scan_exclusive(const vector *v, vector *result);
+vector *vector_prefix_cache(vector *v);
+void    vector_prefix_invalidate(vector *v);
 
 NN_TYPE vector_l_norm(const vector *v, int power);
 NN_TYPE vector_max_norm(const vector *v);
 size_t  vector_max_index(const vector *v);
 size_t  vector_non_zero_length(const vector *v);
 
+vector *vector_sort(vector *instance);
+size_t *vector_argsort(const vector *instance, size_t *indexes);
+NN_TYPE vector_nth(vector *instance, size_t n);
+size_t *vector_top_k(const vector *instance, size_t k, size_t *indexes);
+vector *vector_quantiles(const vector *instance, const vector *probabilities, vector *result);
+
 void vector_print(const vector *instance);
 
 
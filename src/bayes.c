@@ -0,0 +1,416 @@
+#include "bayes.h"
+#include "probability_samples.h"
+
+#include "util/error.h"
+#include <math.h>
+#include <string.h>
+
+static int bayes_value_compare(const void *left, const void *right)
+{
+    NN_TYPE a = *(const NN_TYPE *)left;
+    NN_TYPE b = *(const NN_TYPE *)right;
+
+    return (a > b) - (a < b);
+}
+
+/**
+ * Sorts the events of a column that occur at least once, leaving NaN out.
+ *
+ * @return A vector with the sorted events, or NULL on failure.
+ */
+static vector *bayes_sorted_events(probability *space, size_t column)
+{
+    vector *events = space->events[column];
+    vector *sorted = NULL;
+    size_t length  = 0;
+
+    sorted = vector_create(events->length);
+    VECTOR_CHECK(sorted);
+
+    VECTOR_FOREACH(events) {
+        if (VECTOR(space->occurs[column], index) > 0 && !isnan(VECTOR(events, index))) {
+            VECTOR(sorted, length++) = VECTOR(events, index);
+        }
+    }
+
+    qsort(&VECTOR(sorted, 0), length, sizeof(NN_TYPE), bayes_value_compare);
+    CHECK_MEMORY(vector_reshape(sorted, length));
+
+    return sorted;
+
+error:
+    if (sorted) {
+        number_delete(sorted);
+    }
+    return NULL;
+}
+
+/**
+ * Sets up the keys of a binned feature: the thresholds between its bins,
+ * so the bin of a value is the number of thresholds not above it.
+ *
+ * @return A vector with the thresholds, or NULL on failure.
+ */
+static vector *bayes_bin_thresholds(probability *space, size_t column)
+{
+    struct nn_bins *bins = space->bins[column];
+    vector *events       = space->events[column];
+    size_t count         = events->length;
+    vector *thresholds   = NULL;
+
+    thresholds = vector_create(count > 1 ? count - 1 : 1);
+    VECTOR_CHECK(thresholds);
+
+    /* A single bin holds every value */
+    VECTOR(thresholds, 0) = INFINITY;
+
+    for (size_t index = 1; index < count; index++) {
+        /* Streaming histograms assign values to their nearest centroid */
+        VECTOR(thresholds, index - 1) =
+            bins->edges ? VECTOR(bins->edges, index)
+                        : (VECTOR(events, index - 1) + VECTOR(events, index)) / 2;
+    }
+
+    return thresholds;
+
+error:
+    if (thresholds) {
+        number_delete(thresholds);
+    }
+    return NULL;
+}
+
+/**
+ * Finds the row of a value in the log-likelihood table of a feature.
+ *
+ * @return The index of the category or bin of the value, or the number of
+ *         keys for unseen categories.
+ */
+static size_t bayes_feature_code(const struct nn_bayes_feature *feature, NN_TYPE value)
+{
+    const vector *keys = feature->keys;
+    size_t begin       = 0;
+    size_t end         = keys->length;
+
+    /* Index of the first key greater than the value */
+    while (begin < end) {
+        size_t middle = (begin + end) / 2;
+
+        if (VECTOR(keys, middle) <= value) {
+            begin = middle + 1;
+        } else {
+            end = middle;
+        }
+    }
+
+    if (feature->is_binned) {
+        return begin;
+    }
+
+    return begin > 0 && VECTOR(keys, begin - 1) == value ? begin - 1 : keys->length;
+}
+
+/**
+ * Finds the index of a class value among the sorted classes.
+ *
+ * @return The index of the class, or the number of classes for values which
+ *         aren't a class, e.g. NaN.
+ */
+static size_t bayes_class_code(const bayes *model, NN_TYPE value)
+{
+    NN_TYPE *found = bsearch(&value, &VECTOR(model->classes, 0), model->classes->length,
+                             sizeof(NN_TYPE), bayes_value_compare);
+
+    return found ? (size_t)(found - &VECTOR(model->classes, 0)) : model->classes->length;
+}
+
+/**
+ * Trains a Naive Bayes classifier from the samples of a probability space.
+ *
+ * Every feature gets a table of log P(event | class) with Laplace smoothing,
+ * so predicting a sample costs one lookup and one addition across the
+ * classes per feature. Categorical features use their events, binned
+ * features their bins, sketched features are refused. Categories unseen in
+ * the training samples get the smoothed likelihood of an empty category.
+ *
+ * @param space A pointer to a probability space with the training samples.
+ * @param class_field The name of the field with the classes.
+ * @param feature_fields A NULL-terminated array with the names of the features.
+ * @param alpha The Laplace smoothing of the counts, usually 1.
+ * @return A pointer to the new model, or NULL on failure.
+ */
+bayes *bayes_create(probability *space, char *class_field, char **feature_fields, NN_TYPE alpha)
+{
+    bayes *model     = NULL;
+    size_t *columns  = NULL;
+    size_t *codes    = NULL;
+    size_t class_column;
+    size_t rows;
+    size_t classes;
+    size_t labelled  = 0;
+    NN_TYPE *class_counts = NULL;
+
+    CHECK_MEMORY(space);
+    CHECK_MEMORY(feature_fields);
+
+    rows         = PROBABILITY_ROWS(space);
+    class_column = probability_get_field_index(space, class_field);
+    CHECK(strcmp(space->fields[class_column], class_field) == 0, "Unknown class field %s", class_field);
+    CHECK(!(space->sketches && space->sketches[class_column]) && !(space->bins && space->bins[class_column]),
+          "Class field %s should be categorical", class_field);
+
+    model = calloc(1, sizeof(bayes));
+    CHECK_MEMORY(model);
+
+    while (feature_fields[model->features]) {
+        model->features++;
+    }
+
+    model->feature = calloc(model->features, sizeof(struct nn_bayes_feature));
+    CHECK_MEMORY(model->feature);
+    columns = malloc(model->features * sizeof(size_t));
+    CHECK_MEMORY(columns);
+
+    /* Classes and their priors */
+    model->classes = bayes_sorted_events(space, class_column);
+    CHECK_MEMORY(model->classes);
+    classes = model->classes->length;
+    CHECK(classes > 0, "Class field %s has no samples", class_field);
+
+    model->log_prior = vector_create(classes);
+    VECTOR_CHECK(model->log_prior);
+    class_counts = calloc(classes, sizeof(NN_TYPE));
+    CHECK_MEMORY(class_counts);
+    codes = malloc(rows * sizeof(size_t));
+    CHECK_MEMORY(codes);
+
+    /* Samples without a class are left out of the training */
+    for (size_t row = 0; row < rows; row++) {
+        codes[row] = bayes_class_code(model, PROBABILITY_SAMPLE(space, row, class_column));
+        if (codes[row] < classes) {
+            class_counts[codes[row]]++;
+            labelled++;
+        }
+    }
+
+    for (size_t class = 0; class < classes; class++) {
+        VECTOR(model->log_prior, class) = log(class_counts[class] / labelled);
+    }
+
+    /* Feature keys */
+    for (size_t feature = 0; feature < model->features; feature++) {
+        struct nn_bayes_feature *current = &model->feature[feature];
+        size_t column = probability_get_field_index(space, feature_fields[feature]);
+
+        CHECK(strcmp(space->fields[column], feature_fields[feature]) == 0, "Unknown feature field %s",
+              feature_fields[feature]);
+        CHECK(!(space->sketches && space->sketches[column]), "Feature field %s is sketched",
+              feature_fields[feature]);
+
+        columns[feature]   = column;
+        current->is_binned = space->bins && space->bins[column];
+        current->keys      = current->is_binned ? bayes_bin_thresholds(space, column)
+                                                : bayes_sorted_events(space, column);
+        CHECK_MEMORY(current->keys);
+
+        /* Binned features have one more bin than thresholds, categorical ones a row for unseen categories */
+        current->log_likelihood = matrix_create(current->keys->length + 1, classes);
+        MATRIX_CHECK(current->log_likelihood);
+    }
+
+    /* Likelihood tables, one feature per thread */
+    #pragma omp parallel for
+    for (size_t feature = 0; feature < model->features; feature++) {
+        struct nn_bayes_feature *current = &model->feature[feature];
+        matrix *table = current->log_likelihood;
+        size_t events = table->rows;
+
+        for (size_t row = 0; row < rows; row++) {
+            size_t code;
+
+            if (codes[row] == classes) {
+                continue;
+            }
+
+            code = bayes_feature_code(current, PROBABILITY_SAMPLE(space, row, columns[feature]));
+            MATRIX(table, code, codes[row]) += 1;
+        }
+
+        for (size_t event = 0; event < events; event++) {
+            for (size_t class = 0; class < classes; class++) {
+                MATRIX(table, event, class) =
+                    log((MATRIX(table, event, class) + alpha) / (class_counts[class] + alpha * events));
+            }
+        }
+    }
+
+    free(columns);
+    free(codes);
+    free(class_counts);
+
+    return model;
+
+error:
+    free(columns);
+    free(codes);
+    free(class_counts);
+    bayes_delete(model);
+
+    return NULL;
+}
+
+void bayes_delete(bayes *model)
+{
+    if (!model) {
+        return;
+    }
+
+    for (size_t feature = 0; feature < model->features; feature++) {
+        if (model->feature[feature].keys) {
+            number_delete(model->feature[feature].keys);
+        }
+        if (model->feature[feature].log_likelihood) {
+            number_delete(model->feature[feature].log_likelihood);
+        }
+    }
+
+    if (model->classes) {
+        number_delete(model->classes);
+    }
+    if (model->log_prior) {
+        number_delete(model->log_prior);
+    }
+
+    free(model->feature);
+    free(model);
+}
+
+/**
+ * Adds the log-likelihoods of the features of a sample to its class scores,
+ * four classes at a time.
+ */
+static void bayes_score(const bayes *model, const NN_TYPE *sample, NN_TYPE *scores)
+{
+    size_t classes = model->classes->length;
+
+    memcpy(scores, &VECTOR(model->log_prior, 0), classes * sizeof(NN_TYPE));
+
+    for (size_t feature = 0; feature < model->features; feature++) {
+        const struct nn_bayes_feature *current = &model->feature[feature];
+        const NN_TYPE *likelihood =
+            &MATRIX(current->log_likelihood, bayes_feature_code(current, sample[feature]), 0);
+        size_t class;
+
+        for (class = 0; class < classes / 4 * 4; class += 4) {
+            simde_mm_storeu_ps(&scores[class], simde_mm_add_ps(simde_mm_loadu_ps(&scores[class]),
+                                                               simde_mm_loadu_ps(&likelihood[class])));
+        }
+
+        for (; class < classes; class++) {
+            scores[class] += likelihood[class];
+        }
+    }
+}
+
+/**
+ * Calculates the log posterior log P(class | sample) of every class for
+ * every sample, in parallel.
+ *
+ * @param model A pointer to a Naive Bayes model.
+ * @param samples A matrix with one sample per row and one feature per column, in the order of the model.
+ * @param result A samples x classes matrix for the results, or NULL to allocate one.
+ * @return The matrix with the log posteriors, or NULL on failure.
+ */
+matrix *bayes_log_posterior(bayes *model, matrix *samples, matrix *result)
+{
+    size_t classes;
+
+    CHECK_MEMORY(model);
+    MATRIX_CHECK(samples);
+    CHECK(samples->columns == model->features, "Samples have %zu features, model has %zu",
+          samples->columns, model->features);
+
+    classes = model->classes->length;
+    CHECK(!result || (result->rows == samples->rows && result->columns == classes),
+          "Result matrix should be %zu x %zu", samples->rows, classes);
+
+    if (!result) {
+        result = matrix_create(samples->rows, classes);
+        MATRIX_CHECK(result);
+    }
+
+    #pragma omp parallel for
+    for (size_t row = 0; row < samples->rows; row++) {
+        NN_TYPE *scores = &MATRIX(result, row, 0);
+        NN_TYPE maximum = -INFINITY;
+        NN_TYPE total   = 0;
+
+        bayes_score(model, &MATRIX(samples, row, 0), scores);
+
+        for (size_t class = 0; class < classes; class++) {
+            maximum = fmax(maximum, scores[class]);
+        }
+        for (size_t class = 0; class < classes; class++) {
+            total += exp(scores[class] - maximum);
+        }
+        for (size_t class = 0; class < classes; class++) {
+            scores[class] -= maximum + log(total);
+        }
+    }
+
+    return result;
+
+error:
+    return NULL;
+}
+
+/**
+ * Predicts the most probable class of every sample, in parallel.
+ *
+ * @param model A pointer to a Naive Bayes model.
+ * @param samples A matrix with one sample per row and one feature per column, in the order of the model.
+ * @param result A vector of at least as many elements as samples for the results, or NULL to allocate one.
+ * @return The vector with the predicted class values, or NULL on failure.
+ */
+vector *bayes_predict(bayes *model, matrix *samples, vector *result)
+{
+    size_t classes;
+
+    CHECK_MEMORY(model);
+    MATRIX_CHECK(samples);
+    CHECK(samples->columns == model->features, "Samples have %zu features, model has %zu",
+          samples->columns, model->features);
+    CHECK(!result || result->length >= samples->rows, "Result vector is too short");
+
+    classes = model->classes->length;
+
+    if (!result) {
+        result = vector_create(samples->rows);
+        VECTOR_CHECK(result);
+    }
+
+    #pragma omp parallel
+    {
+        NN_TYPE scores[classes];
+
+        #pragma omp for
+        for (size_t row = 0; row < samples->rows; row++) {
+            size_t best = 0;
+
+            bayes_score(model, &MATRIX(samples, row, 0), scores);
+
+            for (size_t class = 1; class < classes; class++) {
+                if (scores[class] > scores[best]) {
+                    best = class;
+                }
+            }
+
+            VECTOR(result, row) = VECTOR(model->classes, best);
+        }
+    }
+
+    return result;
+
+error:
+    return NULL;
+}
@@ -0,0 +1,735 @@
+#include "tensor.h"
+#include "matrix.h"
+#include "number.h"
+#include "vector.h"
+#include <omp.h>
+#include <string.h>
+
+#define TENSOR_EINSUM_LABELS 128 /* labels are indexed by their character */
+#define TENSOR_EINSUM_SPEC   64  /* longest specification */
+#define TENSOR_EINSUM_CACHE  32  /* cached contraction plans */
+
+/* Plan of a contraction, keyed by its specification and the shapes of its
+ * operands */
+struct tensor_einsum_plan {
+    char   spec[TENSOR_EINSUM_SPEC];
+    size_t count;
+    size_t ranks[TENSOR_EINSUM_OPERANDS];
+    size_t shapes[TENSOR_EINSUM_OPERANDS][TENSOR_MAX_RANK];
+    char   terms[TENSOR_EINSUM_OPERANDS][TENSOR_MAX_RANK + 1];  /* labels of the operands */
+    char   labels[TENSOR_EINSUM_OPERANDS][TENSOR_MAX_RANK + 1]; /* labels left once reduced */
+    char   output[TENSOR_MAX_RANK + 1];
+    size_t path[TENSOR_EINSUM_OPERANDS - 1][2]; /* pairs contracted at every step */
+    size_t used;                                /* last use, 0 for a free entry */
+};
+
+/* Cached contraction plans, see tensor_einsum() */
+static struct tensor_einsum_plan tensor_einsum_cache[TENSOR_EINSUM_CACHE];
+static size_t                    tensor_einsum_clock;
+
+/* Operand of a step of a contraction, with its labels */
+struct tensor_einsum_term {
+    tensor *T;
+    char    labels[TENSOR_MAX_RANK + 1];
+    int     is_owned; /* intermediate results are deleted once contracted */
+};
+
+static int tensor_einsum_is_label(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+/**
+ * Parses an einsum specification like "bij,bjk->bik" into the labels of
+ * every operand and of the output. Without "->", the output has the labels
+ * which appear once, in alphabetical order.
+ *
+ * @param spec The specification.
+ * @param count The number of operands.
+ * @param terms Receives the labels of every operand.
+ * @param output Receives the labels of the output.
+ * @return 0 on success, 1 on a malformed specification.
+ */
+static int tensor_einsum_parse(const char *spec, size_t count,
+                               char terms[][TENSOR_MAX_RANK + 1], char *output)
+{
+    size_t      occurs[TENSOR_EINSUM_LABELS] = {0};
+    size_t      term                         = 0;
+    size_t      rank                         = 0;
+    const char *c                            = spec;
+
+    for (; *c && '-' != *c; c++) {
+        if (' ' == *c) {
+            continue;
+        }
+
+        if (',' == *c) {
+            terms[term][rank] = '\0';
+            term += 1;
+            rank = 0;
+            CHECK(term < count, "Specification has more than %zu operands", count);
+            continue;
+        }
+
+        CHECK(tensor_einsum_is_label(*c), "Unexpected '%c' in the specification", *c);
+        CHECK(rank < TENSOR_MAX_RANK, "Operand %zu has too many labels", term);
+        terms[term][rank++] = *c;
+        occurs[(size_t)*c] += 1;
+    }
+    terms[term][rank] = '\0';
+    CHECK(term + 1 == count, "Specification has %zu operands, %zu given", term + 1, count);
+
+    rank = 0;
+    if ('-' == *c) {
+        CHECK('>' == c[1], "Expected '->' in the specification");
+
+        for (c += 2; *c; c++) {
+            if (' ' == *c) {
+                continue;
+            }
+
+            CHECK(tensor_einsum_is_label(*c), "Unexpected '%c' in the output", *c);
+            CHECK(occurs[(size_t)*c], "Output label '%c' is in no operand", *c);
+            CHECK(!memchr(output, *c, rank), "Output label '%c' is repeated", *c);
+            CHECK(rank < TENSOR_MAX_RANK, "Output has too many labels");
+            output[rank++] = *c;
+        }
+    } else {
+        for (size_t label = 0; label < TENSOR_EINSUM_LABELS; label++) {
+            if (1 == occurs[label]) {
+                CHECK(rank < TENSOR_MAX_RANK, "Output has too many labels");
+                output[rank++] = (char)label;
+            }
+        }
+    }
+    output[rank] = '\0';
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/* Labels of `term` which are in `keep`, in the order of `term`, each once */
+static void tensor_einsum_keep(const char *term, const char *keep, char *labels)
+{
+    size_t rank = 0;
+
+    for (const char *c = term; *c; c++) {
+        if (strchr(keep, *c) && !memchr(labels, *c, rank)) {
+            labels[rank++] = *c;
+        }
+    }
+    labels[rank] = '\0';
+}
+
+/* Labels which outlive the operands `first` and `second`: those of the
+ * output and of every other operand */
+static void tensor_einsum_needed(char terms[][TENSOR_MAX_RANK + 1], size_t count,
+                                 size_t first, size_t second, const char *output,
+                                 char *needed)
+{
+    size_t length = strlen(output);
+
+    memcpy(needed, output, length);
+    for (size_t term = 0; term < count; term++) {
+        if (term != first && term != second) {
+            for (const char *c = terms[term]; *c; c++) {
+                if (!memchr(needed, *c, length)) {
+                    needed[length++] = *c;
+                }
+            }
+        }
+    }
+    needed[length] = '\0';
+}
+
+/**
+ * Calculates the labels of the contraction of two operands, as laid out by
+ * tensor_einsum_pair(): the batch labels shared by both and still needed,
+ * then the free labels of the first and of the second operand.
+ */
+static void tensor_einsum_result(const char *a, const char *b, const char *needed, char *labels)
+{
+    size_t rank = 0;
+
+    for (const char *c = a; *c; c++) {
+        if (strchr(b, *c) && strchr(needed, *c)) {
+            labels[rank++] = *c;
+        }
+    }
+    for (const char *c = a; *c; c++) {
+        if (!strchr(b, *c)) {
+            labels[rank++] = *c;
+        }
+    }
+    for (const char *c = b; *c; c++) {
+        if (!strchr(a, *c)) {
+            labels[rank++] = *c;
+        }
+    }
+    labels[rank] = '\0';
+}
+
+/* Product of the sizes of a set of labels */
+static double tensor_einsum_size(const char *labels, const size_t *sizes)
+{
+    double size = 1;
+
+    for (const char *c = labels; *c; c++) {
+        size *= (double)sizes[(size_t)*c];
+    }
+
+    return size;
+}
+
+/**
+ * Plans a contraction: the labels left on every operand once repeated
+ * labels are turned into diagonals and labels used nowhere else are summed,
+ * and the order in which the operands are contracted pairwise. The order is
+ * greedy, the cheapest pair first, where a pair costs the product of the
+ * sizes of all its labels.
+ *
+ * @param plan The plan, with its specification, count and shapes set.
+ * @return 0 on success, 1 on failure.
+ */
+static int tensor_einsum_planner(struct tensor_einsum_plan *plan)
+{
+    size_t sizes[TENSOR_EINSUM_LABELS] = {0};
+    char   terms[TENSOR_EINSUM_OPERANDS][TENSOR_MAX_RANK + 1];
+    char   needed[TENSOR_EINSUM_LABELS + 1];
+    size_t count = plan->count;
+
+    CHECK(0 == tensor_einsum_parse(plan->spec, count, plan->terms, plan->output),
+          "Wrong einsum specification '%s'", plan->spec);
+    for (size_t term = 0; term < count; term++) {
+        CHECK(strlen(plan->terms[term]) == plan->ranks[term],
+              "Operand %zu has rank %zu, %zu labels given", term, plan->ranks[term],
+              strlen(plan->terms[term]));
+    }
+
+    for (size_t term = 0; term < count; term++) {
+        for (size_t axis = 0; plan->terms[term][axis]; axis++) {
+            size_t label = (size_t)plan->terms[term][axis];
+
+            CHECK(0 == sizes[label] || sizes[label] == plan->shapes[term][axis],
+                  "Label '%c' has sizes %zu and %zu", plan->terms[term][axis], sizes[label],
+                  plan->shapes[term][axis]);
+            sizes[label] = plan->shapes[term][axis];
+        }
+    }
+
+    for (size_t term = 0; term < count; term++) {
+        memcpy(terms[term], plan->terms[term], sizeof(terms[term]));
+    }
+    for (size_t term = 0; term < count; term++) {
+        tensor_einsum_needed(terms, count, term, term, plan->output, needed);
+        tensor_einsum_keep(terms[term], needed, plan->labels[term]);
+    }
+    for (size_t term = 0; term < count; term++) {
+        memcpy(terms[term], plan->labels[term], sizeof(terms[term]));
+    }
+
+    for (size_t step = 0; count > 1; step++, count--) {
+        double best = -1;
+        size_t first = 0, second = 1;
+        char   labels[2 * TENSOR_MAX_RANK + 1];
+
+        for (size_t a = 0; a < count; a++) {
+            for (size_t b = a + 1; b < count; b++) {
+                double cost;
+
+                /* Multiply-adds of the contraction: one per combination of the labels of both */
+                cost = tensor_einsum_size(terms[a], sizes);
+                for (const char *c = terms[b]; *c; c++) {
+                    if (!strchr(terms[a], *c)) {
+                        cost *= (double)sizes[(size_t)*c];
+                    }
+                }
+                if (best < 0 || cost < best) {
+                    best   = cost;
+                    first  = a;
+                    second = b;
+                }
+            }
+        }
+
+        tensor_einsum_needed(terms, count, first, second, plan->output, needed);
+        tensor_einsum_result(terms[first], terms[second], needed, labels);
+        CHECK(strlen(labels) <= TENSOR_MAX_RANK, "Contraction has too many labels");
+
+        plan->path[step][0] = first;
+        plan->path[step][1] = second;
+        memcpy(terms[first], labels, strlen(labels) + 1);
+        memmove(terms[second], terms[second + 1], (count - second - 1) * sizeof(terms[0]));
+    }
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/**
+ * Returns the cached plan of a contraction, planning it on a miss. The least
+ * recently used plan is replaced when the cache is full.
+ *
+ * @param spec The specification.
+ * @param count The number of operands.
+ * @param operands The operands.
+ * @param plan Receives a copy of the plan.
+ * @return 0 on success, 1 on failure.
+ */
+static int tensor_einsum_lookup(const char *spec, size_t count, tensor **operands,
+                                struct tensor_einsum_plan *plan)
+{
+    int is_found = 0;
+    int result   = 0;
+
+    memset(plan, 0, sizeof(*plan));
+    plan->count = count;
+    memcpy(plan->spec, spec, strlen(spec) + 1);
+    for (size_t term = 0; term < count; term++) {
+        plan->ranks[term] = operands[term]->rank;
+        memcpy(plan->shapes[term], operands[term]->shape, operands[term]->rank * sizeof(size_t));
+    }
+
+#pragma omp critical(tensor_einsum_cache)
+    {
+        size_t oldest = 0;
+
+        for (size_t entry = 0; entry < TENSOR_EINSUM_CACHE && !is_found; entry++) {
+            struct tensor_einsum_plan *cached = &tensor_einsum_cache[entry];
+
+            if (cached->used && cached->count == count && 0 == strcmp(cached->spec, spec)
+                && 0 == memcmp(cached->ranks, plan->ranks, sizeof(plan->ranks))
+                && 0 == memcmp(cached->shapes, plan->shapes, sizeof(plan->shapes))) {
+                cached->used = ++tensor_einsum_clock;
+                *plan        = *cached;
+                is_found     = 1;
+            } else if (cached->used < tensor_einsum_cache[oldest].used) {
+                oldest = entry;
+            }
+        }
+
+        if (!is_found) {
+            result = tensor_einsum_planner(plan);
+            if (0 == result) {
+                plan->used                  = ++tensor_einsum_clock;
+                tensor_einsum_cache[oldest] = *plan;
+            }
+        }
+    }
+
+    return result;
+}
+
+/**
+ * Drops every cached contraction plan, see tensor_einsum().
+ */
+void tensor_einsum_cache_clear(void)
+{
+#pragma omp critical(tensor_einsum_cache)
+    {
+        memset(tensor_einsum_cache, 0, sizeof(tensor_einsum_cache));
+        tensor_einsum_clock = 0;
+    }
+}
+
+/* Stride of a label of a term, summed over the axes which repeat it */
+static size_t tensor_einsum_stride(const tensor *T, const char *term, char label)
+{
+    size_t stride = 0;
+
+    for (size_t axis = 0; term[axis]; axis++) {
+        if (label == term[axis]) {
+            stride += T->strides[axis];
+        }
+    }
+
+    return stride;
+}
+
+/**
+ * Creates a view of a term with its axes in the order of `labels`. Repeated
+ * labels of the term become a diagonal, and labels of the term missing from
+ * `labels` must have been summed out before.
+ */
+static tensor *tensor_einsum_view(const struct tensor_einsum_term *term, const char *labels)
+{
+    size_t shape[TENSOR_MAX_RANK];
+    size_t strides[TENSOR_MAX_RANK];
+    size_t rank = strlen(labels);
+
+    for (size_t axis = 0; axis < rank; axis++) {
+        const char *at = strchr(term->labels, labels[axis]);
+
+        shape[axis]   = term->T->shape[at - term->labels];
+        strides[axis] = tensor_einsum_stride(term->T, term->labels, labels[axis]);
+    }
+
+    if (0 == rank) {
+        shape[0]   = 1;
+        strides[0] = 1;
+        rank       = 1;
+    }
+
+    return tensor_view(term->T, rank, shape, strides, term->T->offset);
+}
+
+/**
+ * Sums a term over the labels which are not in `labels`, after taking the
+ * diagonal of its repeated labels.
+ *
+ * @param term The term, replaced by the sum, which keeps the order of its labels.
+ * @param labels The labels to keep.
+ * @return 0 on success, 1 on failure.
+ */
+static int tensor_einsum_sum(struct tensor_einsum_term *term, const char *labels)
+{
+    size_t  indexes[TENSOR_MAX_RANK] = {0};
+    size_t  sizes[TENSOR_MAX_RANK];
+    size_t  input[TENSOR_MAX_RANK];
+    size_t  output[TENSOR_MAX_RANK];
+    size_t  shape[TENSOR_MAX_RANK];
+    size_t  rank = 0, kept = 0, length = 1;
+    char    unique[TENSOR_MAX_RANK + 1];
+    tensor *sum;
+
+    /* The axes of the diagonal, and where they land in the sum */
+    tensor_einsum_keep(term->labels, term->labels, unique);
+    for (const char *c = unique; *c; c++) {
+        const char *at = strchr(labels, *c);
+
+        sizes[rank]  = term->T->shape[strchr(term->labels, *c) - term->labels];
+        input[rank]  = tensor_einsum_stride(term->T, term->labels, *c);
+        output[rank] = 0;
+        if (at) {
+            shape[kept++] = sizes[rank];
+        }
+        length *= sizes[rank];
+        rank += 1;
+    }
+
+    if (0 == kept) {
+        shape[kept++] = 1;
+    }
+    sum = tensor_create(kept, shape);
+    CHECK_MEMORY(sum);
+
+    for (size_t axis = 0, stride = sum->length; axis < rank; axis++) {
+        const char *at = strchr(labels, unique[axis]);
+
+        if (at) {
+            stride /= sizes[axis];
+            output[axis] = stride;
+        }
+    }
+
+    /* The sum walks the term once, in the order of its storage */
+    for (size_t index = 0, from = term->T->offset, to = 0; index < length; index++) {
+        VECTOR(sum->number.values, to) += VECTOR(term->T->number.values, from);
+
+        for (size_t axis = rank; axis-- > 0;) {
+            from += input[axis];
+            to += output[axis];
+            if (++indexes[axis] < sizes[axis]) {
+                break;
+            }
+            from -= sizes[axis] * input[axis];
+            to -= sizes[axis] * output[axis];
+            indexes[axis] = 0;
+        }
+    }
+
+    if (term->is_owned) {
+        number_delete((number *)term->T);
+    }
+    term->T        = sum;
+    term->is_owned = 1;
+    tensor_einsum_keep(unique, labels, term->labels);
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/**
+ * Finds the stride of a group of labels of a view, if the group can be
+ * walked as a single dimension.
+ *
+ * @return 1 and sets `stride` if the group collapses, 0 otherwise.
+ */
+static int tensor_einsum_group(const tensor *T, const char *labels, const char *group,
+                               size_t *stride)
+{
+    size_t inner = 0; /* elements spanned by the inner dimensions of the group */
+
+    *stride = 0;
+    for (size_t index = strlen(group); index-- > 0;) {
+        size_t axis = (size_t)(strchr(labels, group[index]) - labels);
+
+        if (1 == T->shape[axis]) {
+            continue;
+        }
+
+        if (inner && T->strides[axis] != inner) {
+            return 0;
+        }
+        if (!inner) {
+            *stride = T->strides[axis];
+        }
+        inner = T->strides[axis] * T->shape[axis];
+    }
+
+    return 1;
+}
+
+/**
+ * Prepares an operand of a pairwise contraction as a batch of strided
+ * matrices, with its axes ordered as `order`. The operand is read in place
+ * when its rows and columns can each be walked as a single dimension, and
+ * copied to the order of the contraction otherwise.
+ */
+static tensor *tensor_einsum_operand(const struct tensor_einsum_term *term, const char *order,
+                                     const char *rows, const char *columns,
+                                     size_t *row_stride, size_t *column_stride)
+{
+    tensor *view = tensor_einsum_view(term, order);
+    tensor *copy;
+
+    CHECK_MEMORY(view);
+
+    if (tensor_einsum_group(view, order, rows, row_stride)
+        && tensor_einsum_group(view, order, columns, column_stride)) {
+        return view;
+    }
+
+    copy = tensor_clone(view);
+    number_delete((number *)view);
+    CHECK_MEMORY(copy);
+    tensor_einsum_group(copy, order, rows, row_stride);
+    tensor_einsum_group(copy, order, columns, column_stride);
+
+    return copy;
+
+error:
+    return NULL;
+}
+
+/* Position of the batch `index` in an operand of a pairwise contraction */
+static size_t tensor_einsum_batch(const tensor *T, size_t batch_rank, size_t index)
+{
+    size_t offset = T->offset;
+
+    for (size_t axis = batch_rank; axis-- > 0;) {
+        offset += index % T->shape[axis] * T->strides[axis];
+        index /= T->shape[axis];
+    }
+
+    return offset;
+}
+
+/**
+ * Contracts two terms into a new one, lowered to a batch of matrix products
+ * with matrix_gemm_values(): A[batch, M, K] B[batch, K, N] = C[batch, M, N],
+ * where the batch labels are shared and still needed, K are the shared
+ * labels summed away, and M and N the free labels of each term.
+ *
+ * @param a The first term, replaced by the result.
+ * @param b The second term, deleted if owned.
+ * @param needed The labels still needed after the contraction.
+ * @return 0 on success, 1 on failure.
+ */
+static int tensor_einsum_pair(struct tensor_einsum_term *a, struct tensor_einsum_term *b,
+                              const char *needed)
+{
+    char    batch[TENSOR_MAX_RANK + 1] = "", rows[TENSOR_MAX_RANK + 1] = "";
+    char    depth[TENSOR_MAX_RANK + 1] = "", columns[TENSOR_MAX_RANK + 1] = "";
+    char    A_order[TENSOR_MAX_RANK + 1], B_order[TENSOR_MAX_RANK + 1];
+    char    labels[2 * TENSOR_MAX_RANK + 1];
+    size_t  shape[TENSOR_MAX_RANK];
+    size_t  A_rows, A_columns, B_rows, B_columns;
+    size_t  batches = 1, M = 1, K = 1, N = 1, rank = 0;
+    tensor *A = NULL, *B = NULL, *C = NULL;
+    int     is_failed = 0;
+
+    for (const char *c = a->labels; *c; c++) {
+        strncat(strchr(b->labels, *c) ? (strchr(needed, *c) ? batch : depth) : rows, c, 1);
+    }
+    for (const char *c = b->labels; *c; c++) {
+        if (!strchr(a->labels, *c)) {
+            strncat(columns, c, 1);
+        }
+    }
+
+    strcat(strcat(strcpy(A_order, batch), rows), depth);
+    strcat(strcat(strcpy(B_order, batch), depth), columns);
+    A = tensor_einsum_operand(a, A_order, rows, depth, &A_rows, &A_columns);
+    CHECK_MEMORY(A);
+    B = tensor_einsum_operand(b, B_order, depth, columns, &B_rows, &B_columns);
+    CHECK_MEMORY(B);
+
+    tensor_einsum_result(a->labels, b->labels, needed, labels);
+    for (size_t axis = 0; labels[axis]; axis++) {
+        const struct tensor_einsum_term *owner = strchr(a->labels, labels[axis]) ? a : b;
+
+        shape[rank] = owner->T->shape[strchr(owner->labels, labels[axis]) - owner->labels];
+        if (axis < strlen(batch)) {
+            batches *= shape[rank];
+        } else if (axis < strlen(batch) + strlen(rows)) {
+            M *= shape[rank];
+        } else {
+            N *= shape[rank];
+        }
+        rank += 1;
+    }
+    for (const char *c = depth; *c; c++) {
+        K *= a->T->shape[strchr(a->labels, *c) - a->labels];
+    }
+
+    if (0 == rank) {
+        shape[rank++] = 1;
+    }
+    C = tensor_create(rank, shape);
+    CHECK_MEMORY(C);
+
+    /* Small products run side by side, large ones are parallel inside */
+    #pragma omp parallel for schedule(dynamic) if (batches >= (size_t)omp_get_max_threads())
+    for (size_t index = 0; index < batches; index++) {
+        if (matrix_gemm_values(M, N, K,
+                               &VECTOR(A->number.values, tensor_einsum_batch(A, strlen(batch), index)),
+                               A_rows, A_columns,
+                               &VECTOR(B->number.values, tensor_einsum_batch(B, strlen(batch), index)),
+                               B_rows, B_columns, &VECTOR(C->number.values, index * M * N), N)) {
+            #pragma omp atomic write
+            is_failed = 1;
+        }
+    }
+    CHECK(!is_failed, "Matrix product failed");
+
+    number_delete((number *)A);
+    number_delete((number *)B);
+    if (a->is_owned) {
+        number_delete((number *)a->T);
+    }
+    if (b->is_owned) {
+        number_delete((number *)b->T);
+    }
+    a->T        = C;
+    a->is_owned = 1;
+    memcpy(a->labels, labels, strlen(labels) + 1);
+
+    return 0;
+
+error:
+    if (A) {
+        number_delete((number *)A);
+    }
+    if (B) {
+        number_delete((number *)B);
+    }
+    if (C) {
+        number_delete((number *)C);
+    }
+
+    return 1;
+}
+
+/**
+ * Contracts tensors along the labels of an einsum specification, e.g.
+ * "ij,jk->ik" for a matrix product, "bhqd,bhkd->bhqk" for attention scores,
+ * "i,ij,j->" for a bilinear form or "ii->i" for a diagonal.
+ *
+ * Every operand is first reduced to the labels needed later, taking the
+ * diagonal of repeated labels and summing the labels used nowhere else.
+ * The operands are then contracted pairwise, the cheapest pair first, and
+ * every pairwise contraction is lowered to a batch of blocked matrix
+ * products which read transposed and permuted operands in place when their
+ * strides allow it. The plan of a contraction is cached by specification
+ * and shapes, see tensor_einsum_cache_clear().
+ *
+ * @param spec The specification: the labels of every operand separated by
+ * commas, then "->" and the labels of the output. Without "->", the output
+ * has the labels that appear once, in alphabetical order.
+ * @param count The number of operands, up to TENSOR_EINSUM_OPERANDS.
+ * @param operands The operands, which are kept.
+ * @return A new contiguous tensor, of shape [1] when the output has no
+ * labels, or NULL on error.
+ */
+tensor *tensor_einsum(const char *spec, size_t count, tensor **operands)
+{
+    struct tensor_einsum_plan plan;
+    struct tensor_einsum_term terms[TENSOR_EINSUM_OPERANDS];
+    char                      needed[TENSOR_EINSUM_LABELS + 1];
+    char                      all[TENSOR_EINSUM_OPERANDS][TENSOR_MAX_RANK + 1];
+    tensor                   *view   = NULL;
+    tensor                   *result = NULL;
+    size_t                    used   = 0;
+
+    CHECK_MEMORY(spec);
+    CHECK_MEMORY(operands);
+    CHECK(count > 0 && count <= TENSOR_EINSUM_OPERANDS, "Wrong number of operands %zu", count);
+    CHECK(strlen(spec) < TENSOR_EINSUM_SPEC, "Specification is too long");
+    for (size_t term = 0; term < count; term++) {
+        TENSOR_CHECK(operands[term]);
+    }
+
+    CHECK(0 == tensor_einsum_lookup(spec, count, operands, &plan), "Contraction can't be planned");
+
+    for (size_t term = 0; term < count; term++, used++) {
+        terms[term].T        = operands[term];
+        terms[term].is_owned = 0;
+        memcpy(terms[term].labels, plan.terms[term], sizeof(terms[term].labels));
+
+        if (strcmp(plan.terms[term], plan.labels[term])) {
+            CHECK(0 == tensor_einsum_sum(&terms[term], plan.labels[term]), "Sum failed");
+        }
+    }
+
+    for (size_t step = 0; count > 1; step++, count--) {
+        size_t first  = plan.path[step][0];
+        size_t second = plan.path[step][1];
+
+        for (size_t term = 0; term < count; term++) {
+            memcpy(all[term], terms[term].labels, sizeof(all[term]));
+        }
+        tensor_einsum_needed(all, count, first, second, plan.output, needed);
+
+        CHECK(0 == tensor_einsum_pair(&terms[first], &terms[second], needed),
+              "Contraction failed");
+        memmove(&terms[second], &terms[second + 1], (count - second - 1) * sizeof(terms[0]));
+        used -= 1;
+    }
+
+    if (strlen(terms[0].labels) != strlen(plan.output)) {
+        CHECK(0 == tensor_einsum_sum(&terms[0], plan.output), "Sum failed");
+    }
+
+    if (terms[0].is_owned && 0 == strcmp(terms[0].labels, plan.output)
+        && tensor_is_contiguous(terms[0].T)) {
+        return terms[0].T;
+    }
+
+    view = tensor_einsum_view(&terms[0], plan.output);
+    CHECK_MEMORY(view);
+    result = tensor_clone(view);
+    number_delete((number *)view);
+    CHECK_MEMORY(result);
+
+    if (terms[0].is_owned) {
+        number_delete((number *)terms[0].T);
+    }
+
+    return result;
+
+error:
+    for (size_t term = 0; term < used; term++) {
+        if (terms[term].is_owned) {
+            number_delete((number *)terms[term].T);
+        }
+    }
+
+    return NULL;
+}
@@ -1,8 +1,23 @@
 #include "matrix.h"
+#include "matrix_reduce.h"
 #include "number.h"
 #include "vector.h"
 #include <math.h>
-
+#include <omp.h>
+#include <string.h>
+
+#define MATRIX_ROWS_PARALLEL   (1 << 14)
+#define MATRIX_NORM_BLOCK      4096
+#define MATRIX_NORM_STRIPE     256
+#define MATRIX_BROADCAST_BLOCK 4096
+
+/* Blocking of matrix_gemm_values(): rows, depth and columns packed at once,
+ * and the rows and columns of the register block of the micro-kernel */
+#define MATRIX_GEMM_MC 64
+#define MATRIX_GEMM_KC 256
+#define MATRIX_GEMM_NC 1024
+#define MATRIX_GEMM_MR 4
+#define MATRIX_GEMM_NR 8
 
 #define MATRIX_INIT(rows_nr, columns_nr)                                       \
     matrix *instance;                                                          \
@@ -48,6 +63,30 @@ error:
     return NULL;
 }
 
+matrix *matrix_random_uniform(matrix *instance, NN_TYPE min, NN_TYPE max)
+{
+    MATRIX_CHECK(instance);
+
+    CHECK_MEMORY(vector_random_uniform(instance->number.values, min, max));
+
+    return instance;
+
+error:
+    return NULL;
+}
+
+matrix *matrix_random_normal(matrix *instance, NN_TYPE mean, NN_TYPE deviation)
+{
+    MATRIX_CHECK(instance);
+
+    CHECK_MEMORY(vector_random_normal(instance->number.values, mean, deviation));
+
+    return instance;
+
+error:
+    return NULL;
+}
+
 matrix *matrix_identity(size_t size, NN_TYPE default_value)
 {
     matrix *instance;
@@ -154,22 +193,119 @@ error:
     return NULL;
 }
 
+/**
+ * Changes the shape of a matrix, keeping its elements in row-major order.
+ *
+ * When the number of elements is unchanged only the shape is updated, the
+ * elements are neither moved nor reallocated. Otherwise the storage is
+ * resized with vector_reshape(), and new elements are set to 0.
+ *
+ * @param instance A pointer to the matrix.
+ * @param rows The new number of rows.
+ * @param columns The new number of columns.
+ * @return A pointer to the matrix, or NULL on error.
+ */
 matrix *matrix_reshape(matrix *instance, size_t rows, size_t columns)
 {
     MATRIX_CHECK(instance);
     CHECK(rows > 0 && columns > 0, "Invalid matrix shape");
 
+    if (rows * columns != instance->rows * instance->columns) {
+        CHECK_MEMORY(vector_reshape(instance->number.values, rows * columns));
+    }
+
     instance->rows    = rows;
     instance->columns = columns;
 
-    vector_reshape(instance->number.values, rows * columns);
-    CHECK_MEMORY(instance->number.values);
+    return instance;
+
+error:
+    return NULL;
+}
+
+/**
+ * Reorders the rows of a matrix in place, so that row `index` becomes the
+ * former row `permutation[index]`.
+ *
+ * Follows the cycles of the permutation, so every row is copied once, plus
+ * one row per cycle. Applying the same permutation to several matrices
+ * (e.g. samples and labels) shuffles them together.
+ *
+ * @param instance A pointer to the matrix.
+ * @param permutation A permutation of the rows, e.g. from random_permutation().
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_permute_rows(matrix *instance, const size_t *permutation)
+{
+    size_t   size    = instance ? instance->columns * sizeof(NN_TYPE) : 0;
+    char    *visited = NULL;
+    NN_TYPE *first   = NULL;
+
+    MATRIX_CHECK(instance);
+    CHECK_MEMORY(permutation);
+    vector_prefix_invalidate(instance->number.values);
+
+    visited = calloc(instance->rows, 1);
+    CHECK_MEMORY(visited);
+    first = malloc(size);
+    CHECK_MEMORY(first);
+
+    for (size_t row = 0; row < instance->rows; row++) {
+        size_t current = row;
+
+        if (visited[row]) {
+            continue;
+        }
+
+        memcpy(first, &MATRIX(instance, row, 0), size);
+        while (permutation[current] != row) {
+            memcpy(&MATRIX(instance, current, 0), &MATRIX(instance, permutation[current], 0), size);
+            visited[current] = 1;
+            current          = permutation[current];
+        }
+        memcpy(&MATRIX(instance, current, 0), first, size);
+        visited[current] = 1;
+    }
+
+    free(visited);
+    free(first);
+
+    return instance;
+
+error:
+    free(visited);
+    free(first);
+
+    return NULL;
+}
+
+/**
+ * Shuffles the rows of a matrix in place, every order being equally likely.
+ *
+ * @param instance A pointer to the matrix.
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_shuffle_rows(matrix *instance)
+{
+    size_t *permutation = NULL;
+
+    MATRIX_CHECK(instance);
+
+    permutation = malloc(instance->rows * sizeof(size_t));
+    CHECK_MEMORY(permutation);
+    random_permutation(permutation, instance->rows, random_next(random_thread()));
+    CHECK_MEMORY(matrix_permute_rows(instance, permutation));
+
+    free(permutation);
 
     return instance;
 
 error:
+    free(permutation);
+
     return NULL;
 }
+
 /* TODO: Think about order inside vector matrix_shrink ? */
 
 vector *matrix_column_vector(matrix *A, size_t column)
@@ -293,6 +429,7 @@ matrix *matrix_transpose(matrix *instance)
         number_unref((number*)instance);
         instance = transposed;
     } else {
+        vector_prefix_invalidate(instance->number.values);
         number_unref((number*)transposed);
     }
 
@@ -337,6 +474,145 @@ error:
     return NULL;
 }
 
+/* Packs rows [row, row + rows) and depth [from, from + depth) of A, padded
+ * with zeros to whole micro-kernel rows, as MATRIX_GEMM_MR-row panels */
+static void matrix_gemm_pack_A(NN_TYPE *packed, const NN_TYPE *A, size_t row_stride,
+                               size_t column_stride, size_t rows, size_t depth)
+{
+    for (size_t panel = 0; panel < rows; panel += MATRIX_GEMM_MR) {
+        for (size_t p = 0; p < depth; p++) {
+            for (size_t i = 0; i < MATRIX_GEMM_MR; i++) {
+                *packed++ = panel + i < rows
+                                ? A[(panel + i) * row_stride + p * column_stride]
+                                : 0;
+            }
+        }
+    }
+}
+
+/* Packs a block of B, padded with zeros to whole micro-kernel columns, as
+ * MATRIX_GEMM_NR-column panels */
+static void matrix_gemm_pack_B(NN_TYPE *packed, const NN_TYPE *B, size_t row_stride,
+                               size_t column_stride, size_t depth, size_t columns)
+{
+    for (size_t panel = 0; panel < columns; panel += MATRIX_GEMM_NR) {
+        for (size_t p = 0; p < depth; p++) {
+            for (size_t j = 0; j < MATRIX_GEMM_NR; j++) {
+                *packed++ = panel + j < columns
+                                ? B[p * row_stride + (panel + j) * column_stride]
+                                : 0;
+            }
+        }
+    }
+}
+
+/* C[rows x columns] += a packed A panel times a packed B panel, keeping the
+ * MATRIX_GEMM_MR x MATRIX_GEMM_NR block in registers */
+static void matrix_gemm_kernel(const NN_TYPE *A, const NN_TYPE *B, size_t depth, NN_TYPE *C,
+                               size_t C_row_stride, size_t rows, size_t columns)
+{
+    v4sf sum[MATRIX_GEMM_MR][MATRIX_GEMM_NR / 4] = {{{0}}};
+    NN_TYPE block[MATRIX_GEMM_MR][MATRIX_GEMM_NR];
+
+    for (size_t p = 0; p < depth; p++) {
+        v4sf b[MATRIX_GEMM_NR / 4];
+
+        memcpy(b, &B[p * MATRIX_GEMM_NR], sizeof(b));
+        for (size_t i = 0; i < MATRIX_GEMM_MR; i++) {
+            v4sf a = {A[p * MATRIX_GEMM_MR + i], A[p * MATRIX_GEMM_MR + i],
+                      A[p * MATRIX_GEMM_MR + i], A[p * MATRIX_GEMM_MR + i]};
+
+            for (size_t j = 0; j < MATRIX_GEMM_NR / 4; j++) {
+                sum[i][j] += a * b[j];
+            }
+        }
+    }
+
+    memcpy(block, sum, sizeof(block));
+    for (size_t i = 0; i < rows; i++) {
+        for (size_t j = 0; j < columns; j++) {
+            C[i * C_row_stride + j] += block[i][j];
+        }
+    }
+}
+
+/**
+ * Multiplies two strided matrices into a third one, C += A B, with a
+ * cache-blocked kernel: blocks of B and A are packed into contiguous panels
+ * and multiplied by a register-blocked micro-kernel, in parallel over the
+ * blocks of rows.
+ *
+ * The strides of A and B are free, so transposed or permuted operands are
+ * read in place and packed like contiguous ones.
+ *
+ * @param rows The rows of A and C.
+ * @param columns The columns of B and C.
+ * @param depth The columns of A and rows of B.
+ * @param A The first operand, A[i][p] = A[i * A_row_stride + p * A_column_stride].
+ * @param A_row_stride The elements between two rows of A.
+ * @param A_column_stride The elements between two columns of A.
+ * @param B The second operand, B[p][j] = B[p * B_row_stride + j * B_column_stride].
+ * @param B_row_stride The elements between two rows of B.
+ * @param B_column_stride The elements between two columns of B.
+ * @param C The row-major result, which is added to.
+ * @param C_row_stride The elements between two rows of C.
+ * @return 0 on success, 1 on failure.
+ */
+int matrix_gemm_values(size_t rows, size_t columns, size_t depth, const NN_TYPE *A,
+                       size_t A_row_stride, size_t A_column_stride, const NN_TYPE *B,
+                       size_t B_row_stride, size_t B_column_stride, NN_TYPE *C,
+                       size_t C_row_stride)
+{
+    NN_TYPE *B_packed = NULL;
+    size_t   blocks   = (rows + MATRIX_GEMM_MC - 1) / MATRIX_GEMM_MC;
+    int      is_parallel;
+
+    /* The packed block of B is sized for the product, small ones are common */
+    B_packed = malloc((depth < MATRIX_GEMM_KC ? depth : MATRIX_GEMM_KC)
+                      * ((columns < MATRIX_GEMM_NC ? columns : MATRIX_GEMM_NC) + MATRIX_GEMM_NR)
+                      * sizeof(NN_TYPE));
+    CHECK_MEMORY(B_packed);
+
+    is_parallel = blocks > 1 && rows * columns * depth >= MATRIX_ROWS_PARALLEL * 64;
+
+    for (size_t column = 0; column < columns; column += MATRIX_GEMM_NC) {
+        size_t width = columns - column < MATRIX_GEMM_NC ? columns - column : MATRIX_GEMM_NC;
+
+        for (size_t p = 0; p < depth; p += MATRIX_GEMM_KC) {
+            size_t length = depth - p < MATRIX_GEMM_KC ? depth - p : MATRIX_GEMM_KC;
+
+            matrix_gemm_pack_B(B_packed, B + p * B_row_stride + column * B_column_stride,
+                               B_row_stride, B_column_stride, length, width);
+
+            #pragma omp parallel for schedule(dynamic) if (is_parallel)
+            for (size_t block = 0; block < blocks; block++) {
+                NN_TYPE A_packed[MATRIX_GEMM_MC * MATRIX_GEMM_KC];
+                size_t  row    = block * MATRIX_GEMM_MC;
+                size_t  height = rows - row < MATRIX_GEMM_MC ? rows - row : MATRIX_GEMM_MC;
+
+                matrix_gemm_pack_A(A_packed, A + row * A_row_stride + p * A_column_stride,
+                                   A_row_stride, A_column_stride, height, length);
+
+                for (size_t j = 0; j < width; j += MATRIX_GEMM_NR) {
+                    for (size_t i = 0; i < height; i += MATRIX_GEMM_MR) {
+                        matrix_gemm_kernel(&A_packed[i * length], &B_packed[j * length], length,
+                                           &C[(row + i) * C_row_stride + column + j], C_row_stride,
+                                           height - i < MATRIX_GEMM_MR ? height - i : MATRIX_GEMM_MR,
+                                           width - j < MATRIX_GEMM_NR ? width - j : MATRIX_GEMM_NR);
+                    }
+                }
+            }
+        }
+    }
+
+    free(B_packed);
+
+    return 0;
+
+error:
+    return 1;
+}
+
 matrix *matrix_multiplication(matrix *A, matrix *B)
 {
     matrix *multiplicated;
@@ -378,6 +654,147 @@ error:
     return NULL;
 }
 
+/**
+ * Applies a built-in operation to every element of a matrix, in place, see
+ * vector_map_builtin().
+ *
+ * @param A A pointer to the matrix.
+ * @param operation The operation: NN_EXP, NN_LOG, NN_TANH, NN_SIGMOID or NN_SQRT.
+ * @param accuracy NN_PRECISE or NN_FAST.
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_map_builtin(matrix *A, enum nn_map operation, enum nn_accuracy accuracy)
+{
+    MATRIX_CHECK(A);
+
+    CHECK_MEMORY(vector_map_builtin(A->number.values, operation, accuracy));
+
+    return A;
+
+error:
+    return NULL;
+}
+
+/**
+ * Raises every element of a matrix to a power, in place, see vector_pow().
+ *
+ * @param A A pointer to the matrix.
+ * @param exponent The power.
+ * @param accuracy NN_PRECISE or NN_FAST.
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_pow(matrix *A, NN_TYPE exponent, enum nn_accuracy accuracy)
+{
+    MATRIX_CHECK(A);
+
+    CHECK_MEMORY(vector_pow(A->number.values, exponent, accuracy));
+
+    return A;
+
+error:
+    return NULL;
+}
+
+/**
+ * Replaces every row of a matrix by its softmax, e^x / sum(e^x), in a
+ * numerically stable way. Large matrices are processed in parallel over
+ * the rows.
+ *
+ * @param A A pointer to the matrix.
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_softmax_rows(matrix *A)
+{
+    MATRIX_CHECK(A);
+    vector_prefix_invalidate(A->number.values);
+
+    #pragma omp parallel for if (A->rows * A->columns >= MATRIX_ROWS_PARALLEL)
+    for (size_t row = 0; row < A->rows; row++) {
+        vector_softmax_values(&MATRIX(A, row, 0), A->columns, 0);
+    }
+
+    return A;
+
+error:
+    return NULL;
+}
+
+/**
+ * Replaces every row of a matrix by its log-softmax, x - log(sum(e^x)).
+ *
+ * @param A A pointer to the matrix.
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_log_softmax_rows(matrix *A)
+{
+    MATRIX_CHECK(A);
+    vector_prefix_invalidate(A->number.values);
+
+    #pragma omp parallel for if (A->rows * A->columns >= MATRIX_ROWS_PARALLEL)
+    for (size_t row = 0; row < A->rows; row++) {
+        vector_softmax_values(&MATRIX(A, row, 0), A->columns, 1);
+    }
+
+    return A;
+
+error:
+    return NULL;
+}
+
+/**
+ * Calculates log(sum(e^x)) over every row of a matrix.
+ *
+ * @param A A pointer to the matrix.
+ * @param result A vector with one element per row for the results, or NULL to allocate one.
+ * @return The vector with the log-sum-exp of every row, or NULL on error.
+ */
+vector *matrix_log_sum_exp_rows(const matrix *A, vector *result)
+{
+    MATRIX_CHECK(A);
+    CHECK(!result || result->length == A->rows, "Result should have %zu elements", A->rows);
+
+    if (!result) {
+        result = vector_create(A->rows);
+        VECTOR_CHECK(result);
+    }
+    vector_prefix_invalidate(result);
+
+    #pragma omp parallel for if (A->rows * A->columns >= MATRIX_ROWS_PARALLEL)
+    for (size_t row = 0; row < A->rows; row++) {
+        VECTOR(result, row) = vector_log_sum_exp_values(&MATRIX(A, row, 0), A->columns);
+    }
+
+    return result;
+
+error:
+    return NULL;
+}
+
+/**
+ * Divides every row of a matrix by its L1 or L2 norm, in place. Rows of
+ * zeros are left unchanged.
+ *
+ * @param A A pointer to the matrix.
+ * @param power 1 for the L1 norm, 2 for the L2 norm.
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_normalize_rows(matrix *A, int power)
+{
+    MATRIX_CHECK(A);
+    CHECK(1 == power || 2 == power, "Normalization supports the L1 and L2 norms, not L%d", power);
+    vector_prefix_invalidate(A->number.values);
+
+    #pragma omp parallel for if (A->rows * A->columns >= MATRIX_ROWS_PARALLEL)
+    for (size_t row = 0; row < A->rows; row++) {
+        vector_normalize_values(&MATRIX(A, row, 0), A->columns, power);
+    }
+
+    return A;
+
+error:
+    return NULL;
+}
+
 matrix *matrix_map_value(matrix *A, NN_TYPE operation(NN_TYPE, NN_TYPE *),
                          NN_TYPE *value)
 {
@@ -391,6 +808,364 @@ error:
     return NULL;
 }
 
+/* Layout of an operand broadcast to the shape of a matrix */
+struct matrix_broadcast {
+    const NN_TYPE *values;
+    size_t         row_stride;
+    size_t         column_stride;
+    size_t         runs;
+    size_t         run_length;
+    NN_TYPE        scalar;
+};
+
+/**
+ * Broadcasts an operand to the shape of a matrix, NumPy-style, without
+ * expanding it: a scalar, a vector of `columns` elements repeated on every
+ * row, or a matrix with `rows` or 1 rows and `columns` or 1 columns. Repeated
+ * elements get a stride of 0. When the rows line up in the operand, they are
+ * walked as one run split in blocks.
+ *
+ * @param A A pointer to the matrix.
+ * @param w The operand.
+ * @param broadcast Receives the layout of the operand.
+ * @return 0 on success, 1 if the operand can't be broadcast.
+ */
+static int matrix_broadcast_init(const matrix *A, const number *w,
+                                 struct matrix_broadcast *broadcast)
+{
+    size_t length = A->rows * A->columns;
+
+    if (NN_DOUBLE >= w->type) {
+        broadcast->scalar        = NN_INTEGER == w->type  ? (NN_TYPE)w->integer
+                                   : NN_DOUBLE == w->type ? (NN_TYPE)w->doubled
+                                                          : (NN_TYPE)w->floated;
+        broadcast->values        = &broadcast->scalar;
+        broadcast->row_stride    = 0;
+        broadcast->column_stride = 0;
+    } else if (NN_VECTOR == w->type) {
+        CHECK(((const vector *)w)->length == A->columns,
+              "Can't broadcast a vector of %zu to %zu columns", ((const vector *)w)->length,
+              A->columns);
+        broadcast->values        = &VECTOR(w, 0);
+        broadcast->row_stride    = 0;
+        broadcast->column_stride = 1;
+    } else {
+        const matrix *B = (const matrix *)w;
+
+        CHECK(NN_MATRIX == w->type, "Matrix operation with a number of type %d", w->type);
+        CHECK((B->rows == A->rows || 1 == B->rows) && (B->columns == A->columns || 1 == B->columns),
+              "Can't broadcast a %zux%zu matrix to %zux%zu", B->rows, B->columns, A->rows,
+              A->columns);
+        broadcast->values        = &MATRIX(B, 0, 0);
+        broadcast->row_stride    = 1 == B->rows ? 0 : B->columns;
+        broadcast->column_stride = 1 == B->columns ? 0 : 1;
+    }
+
+    broadcast->runs       = A->rows;
+    broadcast->run_length = A->columns;
+    if (broadcast->row_stride == A->columns * broadcast->column_stride) {
+        broadcast->run_length = MATRIX_BROADCAST_BLOCK;
+        broadcast->runs       = (length + MATRIX_BROADCAST_BLOCK - 1) / MATRIX_BROADCAST_BLOCK;
+        broadcast->row_stride = MATRIX_BROADCAST_BLOCK * broadcast->column_stride;
+    }
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/* Applies an element-wise operation with an operand broadcast to the shape of
+ * a matrix, in parallel over the runs */
+static int matrix_broadcast_operation(matrix *A, const number *w, enum nn_operation operation)
+{
+    struct matrix_broadcast broadcast;
+    size_t                  length = A->rows * A->columns;
+    NN_TYPE                *values = &MATRIX(A, 0, 0);
+
+    CHECK(0 == matrix_broadcast_init(A, w, &broadcast), "Operand can't be broadcast");
+    vector_prefix_invalidate(A->number.values);
+
+#pragma omp parallel for schedule(static) if (length >= MATRIX_ROWS_PARALLEL)
+    for (size_t run = 0; run < broadcast.runs; run++) {
+        size_t from = run * broadcast.run_length;
+
+        vector_operation_values(operation, values + from, 1,
+                                broadcast.values + run * broadcast.row_stride,
+                                broadcast.column_stride,
+                                length - from < broadcast.run_length ? length - from
+                                                                     : broadcast.run_length);
+    }
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/* Element-wise operations with a scalar, a row vector, or a matrix which is
+ * broadcast to the shape of the matrix, in place. As with vectors, the
+ * operand is released. */
+#define MATRIX_METHOD_OPERATION(name, operation)                               \
+    matrix *matrix_##name(matrix *A, const number *w)                          \
+    {                                                                          \
+        MATRIX_CHECK(A);                                                       \
+        NUMBER_CHECK(w);                                                       \
+                                                                               \
+        CHECK(0 == matrix_broadcast_operation(A, w, operation),                \
+              "matrix_" #name "() failed");                                    \
+        number_unref((number *)w);                                             \
+                                                                               \
+        return A;                                                              \
+                                                                               \
+    error:                                                                     \
+        return NULL;                                                           \
+    }
+
+MATRIX_METHOD_OPERATION(addition, NN_ADDITION)
+MATRIX_METHOD_OPERATION(subtraction, NN_SUBTRACTION)
+MATRIX_METHOD_OPERATION(hadamard_product, NN_MULTIPLICATION)
+MATRIX_METHOD_OPERATION(division, NN_DIVISION)
+
+/**
+ * Applies an operation to every element of a matrix and the matching element
+ * of an operand broadcast to its shape, in place, see matrix_addition().
+ *
+ * @param A A pointer to the matrix.
+ * @param operation The operation, called with the element of the matrix first.
+ * @param w The operand: a scalar, a row vector or a matrix, which is kept.
+ * @return A pointer to the matrix, or NULL on error.
+ */
+matrix *matrix_map_with(matrix *A, NN_TYPE operation(NN_TYPE, NN_TYPE), const number *w)
+{
+    struct matrix_broadcast broadcast;
+    size_t                  length;
+    NN_TYPE                *values;
+
+    MATRIX_CHECK(A);
+    NUMBER_CHECK(w);
+    CHECK_MEMORY(operation);
+    CHECK(0 == matrix_broadcast_init(A, w, &broadcast), "Operand can't be broadcast");
+    vector_prefix_invalidate(A->number.values);
+
+    length = A->rows * A->columns;
+    values = &MATRIX(A, 0, 0);
+
+#pragma omp parallel for schedule(static) if (length >= MATRIX_ROWS_PARALLEL)
+    for (size_t run = 0; run < broadcast.runs; run++) {
+        size_t         from = run * broadcast.run_length;
+        size_t         to   = length - from < broadcast.run_length ? length
+                                                                   : from + broadcast.run_length;
+        const NN_TYPE *y    = broadcast.values + run * broadcast.row_stride;
+
+        for (size_t index = from; index < to; index++) {
+            values[index] = operation(values[index], y[(index - from) * broadcast.column_stride]);
+        }
+    }
+
+    return A;
+
+error:
+    return NULL;
+}
+
+/* Reduces a row of `length` contiguous values, four at a time */
+static NN_TYPE matrix_reduce_row(const NN_TYPE *values, size_t length, enum nn_reduction reduction)
+{
+    NN_TYPE identity    = matrix_reduce_identity(reduction);
+    NN_TYPE mean        = 0;
+    v4sf    accumulator = {identity, identity, identity, identity};
+    v4sf    at          = {0};
+    NN_TYPE result;
+    NN_TYPE result_at;
+
+    if (NN_VARIANCE == reduction) {
+        mean = matrix_reduce_row(values, length, NN_MEAN);
+    }
+
+    for (size_t column = 0; column < length; column += 4) {
+        /* Padding with the mean adds nothing to the variance */
+        v4sf x = matrix_reduce_load(&values[column], length - column,
+                                    NN_VARIANCE == reduction ? mean : identity);
+
+        matrix_reduce_step(reduction, x, (v4sf) {0} + mean,
+                           (v4sf) {column, column + 1, column + 2, column + 3}, &accumulator, &at);
+    }
+
+    result    = accumulator[0];
+    result_at = at[0];
+    for (int lane = 1; lane < 4; lane++) {
+        matrix_reduce_merge(reduction, &result, &result_at, accumulator[lane], at[lane]);
+    }
+
+    return matrix_reduce_finish(reduction, result, result_at, length);
+}
+
+/**
+ * Reduces the rows [from_row, to_row) of a matrix into one accumulator per
+ * column, streaming the rows in memory order.
+ *
+ * @param accumulators The accumulators, `columns` rounded up to 4.
+ * @param at The positions of the extrema, as many as the accumulators.
+ * @param mean The mean of every column, for the variance, or NULL.
+ */
+static void matrix_reduce_columns_block(const matrix *A, size_t from_row, size_t to_row,
+                                        enum nn_reduction reduction, const NN_TYPE *mean,
+                                        NN_TYPE *accumulators, NN_TYPE *at)
+{
+    size_t  width    = (A->columns + 3) / 4 * 4;
+    NN_TYPE identity = matrix_reduce_identity(reduction);
+
+    for (size_t column = 0; column < width; column++) {
+        accumulators[column] = identity;
+        at[column]           = 0;
+    }
+
+    for (size_t row = from_row; row < to_row; row++) {
+        const NN_TYPE *values = &MATRIX(A, row, 0);
+
+        for (size_t column = 0; column < A->columns; column += 4) {
+            v4sf x = matrix_reduce_load(&values[column], A->columns - column, identity);
+            v4sf block_mean = {0};
+            v4sf accumulator;
+            v4sf block_at;
+
+            if (mean) {
+                block_mean = matrix_reduce_load(&mean[column], A->columns - column, 0);
+            }
+            memcpy(&accumulator, &accumulators[column], sizeof(accumulator));
+            memcpy(&block_at, &at[column], sizeof(block_at));
+
+            matrix_reduce_step(reduction, x, block_mean, (v4sf) {0} + (NN_TYPE)row, &accumulator, &block_at);
+
+            memcpy(&accumulators[column], &accumulator, sizeof(accumulator));
+            memcpy(&at[column], &block_at, sizeof(block_at));
+        }
+    }
+}
+
+/**
+ * Reduces every row of a matrix to one value.
+ *
+ * Every row is reduced four values at a time, in parallel over the rows
+ * for large matrices. The variance is the population variance, and argmin
+ * and argmax give the first column of the extremum; they are refused for
+ * rows longer than MATRIX_REDUCE_POSITIONS.
+ *
+ * @param A A pointer to the matrix.
+ * @param reduction NN_SUM, NN_MEAN, NN_MIN, NN_MAX, NN_ARGMIN, NN_ARGMAX,
+ * NN_VARIANCE, NN_L1_NORM or NN_L2_NORM.
+ * @param result A vector with one element per row for the results, or NULL to allocate one.
+ * @return The vector with the reduction of every row, or NULL on error.
+ */
+vector *matrix_reduce_rows(const matrix *A, enum nn_reduction reduction, vector *result)
+{
+    MATRIX_CHECK(A);
+    CHECK(!result || result->length == A->rows, "Result should have %zu elements", A->rows);
+    CHECK((NN_ARGMIN != reduction && NN_ARGMAX != reduction) || A->columns <= MATRIX_REDUCE_POSITIONS,
+          "Positions of rows of %zu columns don't fit in NN_TYPE", A->columns);
+
+    if (!result) {
+        result = vector_create(A->rows);
+        VECTOR_CHECK(result);
+    }
+    vector_prefix_invalidate(result);
+
+    #pragma omp parallel for if (A->rows * A->columns >= MATRIX_ROWS_PARALLEL)
+    for (size_t row = 0; row < A->rows; row++) {
+        VECTOR(result, row) = matrix_reduce_row(&MATRIX(A, row, 0), A->columns, reduction);
+    }
+
+    return result;
+
+error:
+    return NULL;
+}
+
+/**
+ * Reduces every column of a matrix to one value.
+ *
+ * The rows are streamed in memory order into one SIMD accumulator per
+ * column, instead of gathering every column. Large matrices are split into
+ * blocks of rows, one per thread, whose accumulators are merged in order.
+ * The variance takes a second pass, from the column means. Argmin and argmax
+ * are refused for columns longer than MATRIX_REDUCE_POSITIONS.
+ *
+ * @param A A pointer to the matrix.
+ * @param reduction NN_SUM, NN_MEAN, NN_MIN, NN_MAX, NN_ARGMIN, NN_ARGMAX,
+ * NN_VARIANCE, NN_L1_NORM or NN_L2_NORM.
+ * @param result A vector with one element per column for the results, or NULL to allocate one.
+ * @return The vector with the reduction of every column, or NULL on error.
+ */
+vector *matrix_reduce_columns(const matrix *A, enum nn_reduction reduction, vector *result)
+{
+    NN_TYPE *accumulators = NULL;
+    vector  *mean         = NULL;
+    size_t   width;
+    size_t   blocks;
+
+    MATRIX_CHECK(A);
+    CHECK(!result || result->length == A->columns, "Result should have %zu elements", A->columns);
+    CHECK((NN_ARGMIN != reduction && NN_ARGMAX != reduction) || A->rows <= MATRIX_REDUCE_POSITIONS,
+          "Positions of columns of %zu rows don't fit in NN_TYPE", A->rows);
+
+    if (NN_VARIANCE == reduction) {
+        mean = matrix_reduce_columns(A, NN_MEAN, NULL);
+        VECTOR_CHECK(mean);
+    }
+
+    width  = (A->columns + 3) / 4 * 4;
+    blocks = A->rows * A->columns >= MATRIX_ROWS_PARALLEL ? (size_t)omp_get_max_threads() : 1;
+    blocks = blocks < A->rows ? blocks : A->rows;
+
+    /* Accumulators then positions of every block of rows */
+    accumulators = malloc(2 * blocks * width * sizeof(NN_TYPE));
+    CHECK_MEMORY(accumulators);
+
+    #pragma omp parallel for num_threads(blocks)
+    for (size_t block = 0; block < blocks; block++) {
+        NN_TYPE *accumulator = &accumulators[2 * block * width];
+
+        matrix_reduce_columns_block(A, A->rows * block / blocks, A->rows * (block + 1) / blocks, reduction,
+                                    mean ? &VECTOR(mean, 0) : NULL, accumulator, accumulator + width);
+    }
+
+    for (size_t block = 1; block < blocks; block++) {
+        NN_TYPE *accumulator = &accumulators[2 * block * width];
+
+        for (size_t column = 0; column < A->columns; column++) {
+            matrix_reduce_merge(reduction, &accumulators[column], &accumulators[width + column],
+                                accumulator[column], accumulator[width + column]);
+        }
+    }
+
+    if (!result) {
+        result = vector_create(A->columns);
+        VECTOR_CHECK(result);
+    }
+    vector_prefix_invalidate(result);
+
+    for (size_t column = 0; column < A->columns; column++) {
+        VECTOR(result, column) = matrix_reduce_finish(reduction, accumulators[column],
+                                                      accumulators[width + column], A->rows);
+    }
+
+    free(accumulators);
+    if (mean) {
+        number_delete(mean);
+    }
+
+    return result;
+
+error:
+    free(accumulators);
+    if (mean) {
+        number_delete(mean);
+    }
+
+    return NULL;
+}
+
 NN_TYPE matrix_sum(matrix *A)
 {
     MATRIX_CHECK(A);
@@ -421,19 +1196,54 @@ error:
     return NAN;
 }
 
-NN_TYPE matrix_frobenius_norm(matrix *A)
+/* Sum of squares, or largest absolute value, of `length` values, four at a time */
+static NN_TYPE matrix_norm_block(const NN_TYPE *values, size_t length, int is_max)
 {
-    NN_TYPE sum;
-    matrix *product;
-    MATRIX_CHECK(A);
+    v4sf    accumulator = {0};
+    NN_TYPE result;
+
+    for (size_t index = 0; index < length; index += 4) {
+        v4sf x = matrix_reduce_load(&values[index], length - index, 0);
+
+        if (is_max) {
+            matrix_reduce_step(NN_MAX, (v4sf)((v4si)x & 0x7fffffff), x, x, &accumulator, NULL);
+        } else {
+            accumulator += x * x;
+        }
+    }
+
+    result = accumulator[0];
+    for (int lane = 1; lane < 4; lane++) {
+        matrix_reduce_merge(is_max ? NN_MAX : NN_SUM, &result, NULL, accumulator[lane], 0);
+    }
+
+    return result;
+}
+
+/**
+ * Calculates the Frobenius norm of a matrix, sqrt(sum(a^2)), in one
+ * streaming pass over its values without allocating. Large matrices are
+ * split into blocks summed in parallel.
+ *
+ * @param A A pointer to the matrix.
+ * @return The Frobenius norm, or NAN on error.
+ */
+NN_TYPE matrix_frobenius_norm(const matrix *A)
+{
+    const NN_TYPE *values;
+    size_t         length;
+    double         sum = 0;
 
-    product = matrix_clone(A);
-    MATRIX_CHECK(product);
+    MATRIX_CHECK(A);
 
-    MATRIX_OPERATION(product, product, *);
-    sum = matrix_sum(product);
+    values = &MATRIX(A, 0, 0);
+    length = A->rows * A->columns;
 
-    number_delete(product);
+    #pragma omp parallel for reduction(+ : sum) if (length >= MATRIX_ROWS_PARALLEL)
+    for (size_t index = 0; index < length; index += MATRIX_NORM_BLOCK) {
+        sum += matrix_norm_block(&values[index], length - index < MATRIX_NORM_BLOCK ? length - index
+                                                                                    : MATRIX_NORM_BLOCK, 0);
+    }
 
     return sqrt(sum);
 
@@ -441,29 +1251,155 @@ error:
     return NAN;
 }
 
-NN_TYPE matrix_frobenius_norm_by_trace(matrix *instance)
+/**
+ * Calculates the Frobenius norm of a matrix as sqrt(trace(A A^T)).
+ *
+ * The diagonal of A A^T holds the sums of squares of the rows, so this is
+ * the same single pass as matrix_frobenius_norm(), with no product.
+ *
+ * @param A A pointer to the matrix.
+ * @return The Frobenius norm, or NAN on error.
+ */
+NN_TYPE matrix_frobenius_norm_by_trace(const matrix *A)
 {
-    NN_TYPE frobenius;
-    matrix *A;
-    matrix *AT;
-    matrix *A_AT;
-    MATRIX_CHECK(instance);
+    return matrix_frobenius_norm(A);
+}
+
+/**
+ * Calculates the max norm of a matrix, the largest absolute value of its
+ * elements, in one streaming pass without allocating.
+ *
+ * @param A A pointer to the matrix.
+ * @return The max norm, or NAN on error.
+ */
+NN_TYPE matrix_max_norm(const matrix *A)
+{
+    const NN_TYPE *values;
+    size_t         length;
+    NN_TYPE        max = 0;
+
+    MATRIX_CHECK(A);
+
+    values = &MATRIX(A, 0, 0);
+    length = A->rows * A->columns;
+
+    #pragma omp parallel for reduction(max : max) if (length >= MATRIX_ROWS_PARALLEL)
+    for (size_t index = 0; index < length; index += MATRIX_NORM_BLOCK) {
+        NN_TYPE block = matrix_norm_block(&values[index], length - index < MATRIX_NORM_BLOCK
+                                                               ? length - index : MATRIX_NORM_BLOCK, 1);
+
+        max = block > max ? block : max;
+    }
+
+    return max;
+
+error:
+    return NAN;
+}
+
+/**
+ * Sums the absolute values of the columns [from_column, from_column + width)
+ * into a stripe of at most MATRIX_NORM_STRIPE accumulators on the stack,
+ * and returns the largest sum.
+ */
+static NN_TYPE matrix_one_norm_stripe(const matrix *A, size_t from_column, size_t width, int is_parallel)
+{
+    NN_TYPE sums[MATRIX_NORM_STRIPE] = {0};
+    NN_TYPE max = 0;
+
+    #pragma omp parallel if (is_parallel)
+    {
+        NN_TYPE local[MATRIX_NORM_STRIPE] = {0};
+
+        #pragma omp for nowait
+        for (size_t row = 0; row < A->rows; row++) {
+            const NN_TYPE *values = &MATRIX(A, row, from_column);
+
+            for (size_t column = 0; column < width; column += 4) {
+                v4sf x = matrix_reduce_load(&values[column], width - column, 0);
+                v4sf sum;
+
+                memcpy(&sum, &local[column], sizeof(sum));
+                matrix_reduce_step(NN_L1_NORM, x, x, x, &sum, NULL);
+                memcpy(&local[column], &sum, sizeof(sum));
+            }
+        }
+
+        #pragma omp critical
+        for (size_t column = 0; column < width; column++) {
+            sums[column] += local[column];
+        }
+    }
+
+    for (size_t column = 0; column < width; column++) {
+        max = sums[column] > max ? sums[column] : max;
+    }
+
+    return max;
+}
+
+/**
+ * Calculates the 1-norm of a matrix, the largest sum of absolute values of
+ * a column.
+ *
+ * The columns are summed in stripes of MATRIX_NORM_STRIPE stack
+ * accumulators, streaming the rows of every stripe, so every value is read
+ * once and nothing is allocated. Wide matrices are processed in parallel
+ * over the stripes, narrow ones over the rows of every stripe.
+ *
+ * @param A A pointer to the matrix.
+ * @return The 1-norm, or NAN on error.
+ */
+NN_TYPE matrix_one_norm(const matrix *A)
+{
+    size_t  stripes;
+    int     is_parallel;
+    NN_TYPE max = 0;
 
-    A = matrix_clone(instance);
     MATRIX_CHECK(A);
-    AT = matrix_clone(instance);
-    MATRIX_CHECK(AT);
-    matrix_transpose(AT);
 
-    A_AT = matrix_multiplication(A, AT);
+    stripes     = (A->columns + MATRIX_NORM_STRIPE - 1) / MATRIX_NORM_STRIPE;
+    is_parallel = A->rows * A->columns >= MATRIX_ROWS_PARALLEL;
+
+    #pragma omp parallel for reduction(max : max) if (is_parallel && stripes >= (size_t)omp_get_max_threads())
+    for (size_t stripe = 0; stripe < stripes; stripe++) {
+        size_t  from_column = stripe * MATRIX_NORM_STRIPE;
+        size_t  width       = A->columns - from_column < MATRIX_NORM_STRIPE ? A->columns - from_column
+                                                                            : MATRIX_NORM_STRIPE;
+        NN_TYPE norm        = matrix_one_norm_stripe(A, from_column, width,
+                                                     is_parallel && !omp_in_parallel());
+
+        max = norm > max ? norm : max;
+    }
+
+    return max;
+
+error:
+    return NAN;
+}
+
+/**
+ * Calculates the infinity-norm of a matrix, the largest sum of absolute
+ * values of a row, in one streaming pass without allocating, in parallel
+ * over the rows for large matrices.
+ *
+ * @param A A pointer to the matrix.
+ * @return The infinity-norm, or NAN on error.
+ */
+NN_TYPE matrix_infinity_norm(const matrix *A)
+{
+    NN_TYPE max = 0;
 
-    frobenius = sqrt(matrix_trace(A_AT));
+    MATRIX_CHECK(A);
 
-    number_delete(A);
-    number_delete(AT);
-    number_delete(A_AT);
+    #pragma omp parallel for reduction(max : max) if (A->rows * A->columns >= MATRIX_ROWS_PARALLEL)
+    for (size_t row = 0; row < A->rows; row++) {
+        NN_TYPE norm = matrix_reduce_row(&MATRIX(A, row, 0), A->columns, NN_L1_NORM);
+
+        max = norm > max ? norm : max;
+    }
 
-    return frobenius;
+    return max;
 
 error:
     return NAN;
@@ -0,0 +1,125 @@
+#pragma once
+
+#include "matrix.h"
+#include <math.h>
+#include <string.h>
+
+/* SIMD building blocks of matrix_reduce_rows(), matrix_reduce_columns() and
+ * tensor_reduce(), private to the matrix and tensor sources */
+
+/* Value that leaves a reduction unchanged, also used to pad partial blocks */
+static inline NN_TYPE matrix_reduce_identity(enum nn_reduction reduction)
+{
+    switch (reduction) {
+    case NN_MIN:
+    case NN_ARGMIN:
+        return INFINITY;
+    case NN_MAX:
+    case NN_ARGMAX:
+        return -INFINITY;
+    default:
+        return 0;
+    }
+}
+
+/* Loads up to four values, filling the missing lanes */
+static inline v4sf matrix_reduce_load(const NN_TYPE *values, size_t count, NN_TYPE fill)
+{
+    v4sf block = {fill, fill, fill, fill};
+
+    memcpy(&block, values, (count < 4 ? count : 4) * sizeof(NN_TYPE));
+
+    return block;
+}
+
+static inline v4sf matrix_reduce_select(v4si mask, v4sf a, v4sf b)
+{
+    return (v4sf)(((v4si)a & mask) | ((v4si)b & ~mask));
+}
+
+/**
+ * Folds four values into four accumulators.
+ *
+ * @param x The values.
+ * @param mean The mean of the values, for the variance.
+ * @param position The position of every value, for argmin and argmax.
+ * @param accumulator The accumulators.
+ * @param at The position of the extremum of every accumulator, for argmin and argmax.
+ */
+static inline void matrix_reduce_step(enum nn_reduction reduction, v4sf x, v4sf mean, v4sf position,
+                                      v4sf *accumulator, v4sf *at)
+{
+    v4si mask;
+
+    switch (reduction) {
+    case NN_SUM:
+    case NN_MEAN:
+        *accumulator += x;
+        break;
+    case NN_VARIANCE:
+        *accumulator += (x - mean) * (x - mean);
+        break;
+    case NN_L1_NORM:
+        *accumulator += (v4sf)((v4si)x & 0x7fffffff);
+        break;
+    case NN_L2_NORM:
+        *accumulator += x * x;
+        break;
+    case NN_MIN:
+        *accumulator = matrix_reduce_select(x < *accumulator, x, *accumulator);
+        break;
+    case NN_MAX:
+        *accumulator = matrix_reduce_select(x > *accumulator, x, *accumulator);
+        break;
+    case NN_ARGMIN:
+    case NN_ARGMAX:
+        /* Equal extrema keep the lowest position, whatever the order of the loops */
+        mask = (NN_ARGMIN == reduction ? x < *accumulator : x > *accumulator)
+               | ((x == *accumulator) & (position < *at));
+        *accumulator = matrix_reduce_select(mask, x, *accumulator);
+        *at          = matrix_reduce_select(mask, position, *at);
+        break;
+    }
+}
+
+/* Folds a partial result into another, keeping the lowest position of equal extrema */
+static inline void matrix_reduce_merge(enum nn_reduction reduction, NN_TYPE *accumulator, NN_TYPE *at,
+                                       NN_TYPE other, NN_TYPE other_at)
+{
+    switch (reduction) {
+    case NN_MIN:
+        *accumulator = fminf(*accumulator, other);
+        break;
+    case NN_MAX:
+        *accumulator = fmaxf(*accumulator, other);
+        break;
+    case NN_ARGMIN:
+    case NN_ARGMAX:
+        if ((NN_ARGMIN == reduction ? other < *accumulator : other > *accumulator)
+            || (other == *accumulator && other_at < *at)) {
+            *accumulator = other;
+            *at          = other_at;
+        }
+        break;
+    default:
+        *accumulator += other;
+    }
+}
+
+/* Turns an accumulator over `count` values into the result of a reduction */
+static inline NN_TYPE matrix_reduce_finish(enum nn_reduction reduction, NN_TYPE accumulator, NN_TYPE at,
+                                           size_t count)
+{
+    switch (reduction) {
+    case NN_MEAN:
+    case NN_VARIANCE:
+        return accumulator / count;
+    case NN_L2_NORM:
+        return sqrtf(accumulator);
+    case NN_ARGMIN:
+    case NN_ARGMAX:
+        return at;
+    default:
+        return accumulator;
+    }
+}
@@ -6,6 +6,7 @@
 
 int object_delete(number *instance);
 int matrix_delete(number *instance);
+int tensor_delete(number *instance);
 
 /**
  * Creates a new number instance with the given value of defaule NN_TYPE.
@@ -102,8 +103,10 @@ int number_delete(void *number_ptr)
     } else if (NN_MATRIX == instance->type) {
         r = matrix_delete(instance);
         CHECK(r == 0, "matrix_delete() failed");
+    } else if (NN_TENSOR == instance->type) {
+        r = tensor_delete(instance);
+        CHECK(r == 0, "tensor_delete() failed");
     }
-    // TODO: tensor, ...
 
     return 0;
 
@@ -118,6 +121,9 @@ int object_delete(number *instance)
     CHECK_MEMORY(instance);
     CHECK_MEMORY(instance->values);
 
+    if (NN_VECTOR == instance->type) {
+        free(((vector *)instance)->prefix);
+    }
     free(instance->values);
     free(instance);
 
@@ -146,6 +152,23 @@ error:
     return 1;
 }
 
+int tensor_delete(number *instance)
+{
+    CHECK_MEMORY(instance);
+    CHECK_MEMORY(instance->values);
+
+    /* The storage may be shared with other views of the same tensor */
+    number_unref(instance->values);
+    /* The strides are allocated together with the shape */
+    free(((tensor *)instance)->shape);
+    free(instance);
+
+    return 0;
+
+error:
+    return 1;
+}
+
 number *number_ref(number *n) {
      if (n) {
          atomic_fetch_add(&n->ref_count, 1);
@@ -2,16 +2,48 @@
 #include "math.h"
 #include "matrix.h"
 #include "number.h"
+#include "omp.h"
+#include "probability_samples.h"
+#include "sketch.h"
+#include "stdint.h"
 #include "string.h"
 #include "vector.h"
 
+/**
+ * Checks if a column of a probability space is summarized by a sketch.
+ *
+ * @param space A pointer to a probability space
+ * @param column The index of the column
+ */
+#define PROBABILITY_SKETCHED(space, column) \
+    ((space)->sketches && (space)->sketches[column])
+
+/**
+ * Checks if the values of a column of a probability space are grouped into bins.
+ *
+ * @param space A pointer to a probability space
+ * @param column The index of the column
+ */
+#define PROBABILITY_BINNED(space, column) \
+    ((space)->bins && (space)->bins[column])
+
+/**
+ * Checks if a column of a probability space is summarized, so its events
+ * don't hold every distinct value and its moments come from the running ones.
+ *
+ * @param space A pointer to a probability space
+ * @param column The index of the column
+ */
+#define PROBABILITY_SUMMARIZED(space, column) \
+    (PROBABILITY_SKETCHED(space, column) || PROBABILITY_BINNED(space, column))
+
 /**
  * Loops over the columns of a probability space.
  *
  * @param space A pointer to a probability space
  */
 #define PROBABILITY_COLUMNS(space) \
-    for(size_t column = 0; column < space->samples->columns; column++)
+    for(size_t column = 0; column < PROBABILITY_WIDTH(space); column++)
 
 /**
  * Loops over the columns of a probability space and checks if the
@@ -21,7 +53,7 @@
  * @param field The name of a field for which we seek the corresponding column
  */
 #define PROBABILITY_COLUMN(space, field) \
-    for(size_t column = 0; column < space->samples->columns; column++) \
+    for(size_t column = 0; column < PROBABILITY_WIDTH(space); column++) \
         if(strcmp(space->fields[column], field) == 0)
 /**
  * Loops over the columns of a probability space and iterates over each event
@@ -34,73 +66,431 @@
     PROBABILITY_COLUMN(space, field) \
         for (size_t index = 0; index < space->events[column]->length; index++)
 
+/* Code of a sample whose value isn't an event of its column, e.g. NaN */
+#define PROBABILITY_CODE_NONE UINT32_MAX
+
+/* An event of a column with its index, to look events up by value */
+struct probability_code {
+    NN_TYPE  value;
+    uint32_t index;
+};
+
+/* Orders two values with NaN last, a consistent order for qsort() and bsearch() */
+static inline int probability_value_order(NN_TYPE a, NN_TYPE b)
+{
+    if(isnan(a) || isnan(b)) {
+        return isnan(a) - isnan(b);
+    }
+
+    return (a > b) - (a < b);
+}
+
+static int probability_code_compare(const void *left, const void *right)
+{
+    return probability_value_order(((const struct probability_code *)left)->value,
+                                   ((const struct probability_code *)right)->value);
+}
+
+/* The events of an exact column sorted by value, see probability_event_find() */
+struct nn_probability_lookup {
+    size_t length;
+    size_t capacity;
+    struct probability_code *codes;
+};
+
+/**
+ * Number of events evaluated at a time by the expectation kernels, small
+ * enough for the function values of a block to stay in L1.
+ */
+#define PROBABILITY_BLOCK 256
+
 /**
- * Loops over the columns of a probability space and calculates the sum of
- * a given expression for each event in the specified field's corresponding
- * event vector; the expression is defined using x to represent the value of the event
- * and Px to represent its probability.
+ * Calculates the sum of `values[i] * P[i]` four elements at a time.
  *
- * @param space A pointer to a probability space
- * @param field The name of the field for which to calculate the sum
- * @param accumulator A variable that will hold the sum
- * @param expression An expression, defined using x and Px, to calculate the sum
+ * @param values The values.
+ * @param P The probability of every value.
+ * @param length The number of values.
+ * @returns The weighted sum.
+ */
+static NN_TYPE probability_weighted_sum(const NN_TYPE *values, const NN_TYPE *P, size_t length)
+{
+    simde__m128 sum = simde_mm_setzero_ps();
+    NN_TYPE lanes[4];
+    NN_TYPE result;
+    size_t index;
+
+    for(index = 0; index < length / 4 * 4; index += 4) {
+        sum = simde_mm_add_ps(sum, simde_mm_mul_ps(simde_mm_loadu_ps(&values[index]),
+                                                   simde_mm_loadu_ps(&P[index])));
+    }
+
+    simde_mm_storeu_ps(lanes, sum);
+    result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    for(; index < length; index++) {
+        result += values[index] * P[index];
+    }
+
+    return result;
+}
+
+/**
+ * Calculates the sum of `(values[i] - mu)^2 * P[i]` four elements at a time.
+ *
+ * @param values The values.
+ * @param P The probability of every value.
+ * @param mu The mean of the values.
+ * @param length The number of values.
+ * @returns The weighted sum of squared deviations.
  */
-#define PROBABILITY_SUM(space, field, accumulator, expression) \
-    PROBABILITY_FOREACH(space, field) { \
-        NN_TYPE x = VECTOR(space->events[column], index); \
-        NN_TYPE Px = VECTOR(space->P[column], index); \
-        accumulator += expression; \
+static NN_TYPE probability_weighted_deviation(const NN_TYPE *values, const NN_TYPE *P, NN_TYPE mu, size_t length)
+{
+    simde__m128 sum = simde_mm_setzero_ps();
+    simde__m128 mean = simde_mm_set1_ps(mu);
+    NN_TYPE lanes[4];
+    NN_TYPE result;
+    size_t index;
+
+    for(index = 0; index < length / 4 * 4; index += 4) {
+        simde__m128 deviation = simde_mm_sub_ps(simde_mm_loadu_ps(&values[index]), mean);
+
+        sum = simde_mm_add_ps(sum, simde_mm_mul_ps(simde_mm_mul_ps(deviation, deviation),
+                                                   simde_mm_loadu_ps(&P[index])));
+    }
+
+    simde_mm_storeu_ps(lanes, sum);
+    result = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    for(; index < length; index++) {
+        result += (values[index] - mu) * (values[index] - mu) * P[index];
     }
 
+    return result;
+}
+
 probability *probability_space_populate(probability *space);
-probability *probability_from_matrix(matrix *samples, char **fields) {
-    probability *space_ptr;
-    size_t space_width_size;
-    char **samples_fields;
+static int probability_bins_create(probability *space, size_t column, enum nn_binning binning, size_t count);
+static int probability_bin_of(probability *space, size_t column, NN_TYPE value);
+
+/**
+ * Allocates a probability space over a samples matrix, without observing the
+ * samples yet.
+ * @param samples The samples matrix, owned by the new space, or left to the caller on failure.
+ * @param samples The samples matrix, owned by the new space.
+ * @param fields The names of the fields.
+ * @param layout NN_ROW_MAJOR or NN_COLUMN_MAJOR.
+ * @returns A new, empty probability space, or NULL on failure.
+ */
+static probability *probability_create(matrix *samples, char **fields, enum nn_layout layout) {
+    probability *space = NULL;
+    size_t width = 0;
+    char **samples_fields = NULL;
 
-    space_width_size= sizeof(vector*) * samples->columns;
-    samples_fields = malloc(samples->columns * sizeof(char*));
+    MATRIX_CHECK(samples);
+    width = layout == NN_COLUMN_MAJOR ? samples->rows : samples->columns;
 
-    for(size_t index = 0; index < samples->columns; index++) {
+    samples_fields = calloc(width + 1, sizeof(char*));
+    CHECK_MEMORY(samples_fields);
+
+    for(size_t index = 0; index < width; index++) {
         samples_fields[index] = strdup(fields[index]);
+        CHECK_MEMORY(samples_fields[index]);
     }
 
-    probability space = {
+    space = malloc(sizeof(probability));
+    CHECK_MEMORY(space);
+
+    *space = (probability) {
         .fields = samples_fields,
-        .samples = matrix_clone(samples),
-        .events = malloc(space_width_size),
-        .occurs = malloc(space_width_size),
-        .P = malloc(space_width_size),
-        .variance = malloc(samples->columns * sizeof(NN_TYPE)),
-        .covariance = matrix_create(samples->columns, samples->columns),
-        .correlation = matrix_create(samples->columns, samples->columns)
+        .samples = samples,
+        .layout = layout,
+        .events = calloc(width, sizeof(vector*)),
+        .occurs = calloc(width, sizeof(vector*)),
+        .P = calloc(width, sizeof(vector*)),
+        .lookups = calloc(width, sizeof(struct nn_probability_lookup)),
+        .variance = malloc(width * sizeof(NN_TYPE)),
+        .covariance = matrix_create(width, width),
+        .correlation = matrix_create(width, width),
+        .mean = calloc(width, sizeof(NN_TYPE)),
+        .comoment = matrix_create(width, width)
     };
+    CHECK_MEMORY(space->events);
+    CHECK_MEMORY(space->occurs);
+    CHECK_MEMORY(space->P);
+    CHECK_MEMORY(space->lookups);
+    CHECK_MEMORY(space->variance);
+    CHECK_MEMORY(space->covariance);
+    CHECK_MEMORY(space->correlation);
+    CHECK_MEMORY(space->mean);
+    CHECK_MEMORY(space->comoment);
+
+    return space;
+
+error:
+    if(samples_fields) {
+        for(size_t index = 0; index < width; index++) {
+            free(samples_fields[index]);
+        }
+        free(samples_fields);
+    }
+    if(space) {
+        free(space->events);
+        free(space->occurs);
+        free(space->P);
+        free(space->lookups);
+        free(space->variance);
+        free(space->mean);
+        if(space->covariance) {
+            number_delete(space->covariance);
+        }
+        if(space->correlation) {
+            number_delete(space->correlation);
+        }
+        if(space->comoment) {
+            number_delete(space->comoment);
+        }
+        free(space);
+    }
+    return NULL;
+}
+
+/**
+ * Observes the samples of a freshly created space, releasing the space on
+ * failure.
+ */
+static probability *probability_create_populated(probability *space) {
+    CHECK_MEMORY(space);
+
+    if(!probability_space_populate(space)) {
+        probability_delete(space);
+        return NULL;
+    }
+
+    return space;
+
+error:
+    return NULL;
+}
+
+/**
+ * Creates a probability space from a copy of the samples matrix.
+ *
+ * @param samples A matrix with one sample per row and one field per column.
+ * @param fields The names of the fields, one per column.
+ * @returns A new probability space, or NULL on failure.
+ */
+probability *probability_from_matrix(matrix *samples, char **fields) {
+    matrix *copy;
+    probability *space;
+
+    MATRIX_CHECK(samples);
+
+    copy = matrix_clone(samples);
+    MATRIX_CHECK(copy);
+
+    space = probability_create(copy, fields, NN_ROW_MAJOR);
+    if(!space) {
+        number_unref((number *)copy);
+        return NULL;
+    }
+
+    return probability_create_populated(space);
+
+error:
+    return NULL;
+}
+
+/**
+ * Creates a probability space that shares the caller's samples matrix instead
+ * of copying it.
+ *
+ * The matrix is borrowed with number_ref(), so the caller may keep using it or
+ * hand ownership over by calling number_unref() right away. Appending to or
+ * retracting from the space resizes the shared matrix.
+ *
+ * With NN_COLUMN_MAJOR the matrix holds one field per row and one sample per
+ * column, so each field is contiguous in memory and is scanned without
+ * strides. Appending to a column-major space moves every field, so prefer
+ * NN_ROW_MAJOR for streaming.
+ *
+ * @param samples The samples matrix, laid out as described by `layout`.
+ * @param fields The names of the fields.
+ * @param layout NN_ROW_MAJOR or NN_COLUMN_MAJOR.
+ * @returns A new probability space, or NULL on failure.
+ */
+probability *probability_from_matrix_ref(matrix *samples, char **fields, enum nn_layout layout) {
+    probability *space;
+
+    MATRIX_CHECK(samples);
+
+    space = probability_create((matrix *)number_ref((number *)samples), fields, layout);
+    if(!space) {
+        number_unref((number *)samples);
+        return NULL;
+    }
+
+    return probability_create_populated(space);
+
+error:
+    return NULL;
+}
+
+/**
+ * Creates a probability space that shares the caller's samples matrix,
+ * summarizing high-cardinality fields with fixed-memory sketches.
+ *
+ * A sketched field keeps a Count-Min sketch for its masses, a HyperLogLog
+ * for its number of distinct values, and only its NN_SKETCH_HEAVY most
+ * frequent values as `events`, with their estimated counts as `occurs`.
+ * probability_mass_of() answers from the Count-Min sketch with an error of at
+ * most e / NN_SKETCH_WIDTH; the expected value and the variance come from the
+ * running moments and stay exact. Joint masses still scan the samples.
+ *
+ * The samples are streamed into the sketches without being copied: the
+ * matrix is borrowed with number_ref() as by probability_from_matrix_ref(),
+ * so the sketched fields cost no memory beyond their sketches. The caller
+ * releases its reference with number_unref().
+ *
+ * @param samples A matrix with one sample per row and one field per column.
+ * @param fields The names of the fields, one per column.
+ * @param sketched_fields A NULL-terminated array of the fields to sketch.
+ * @returns A new probability space, or NULL on failure.
+ */
+probability *probability_from_matrix_sketched(matrix *samples, char **fields, char **sketched_fields) {
+    probability *space = NULL;
+
+    MATRIX_CHECK(samples);
+    CHECK_MEMORY(sketched_fields);
+
+    space = probability_create((matrix *)number_ref((number *)samples), fields, NN_ROW_MAJOR);
+    if(!space) {
+        number_unref((number *)samples);
+        return NULL;
+    }
+
+    space->sketches = calloc(PROBABILITY_WIDTH(space), sizeof(sketch*));
+    CHECK_MEMORY(space->sketches);
+
+    for(size_t field_index = 0; sketched_fields[field_index]; field_index++) {
+        PROBABILITY_COLUMN(space, sketched_fields[field_index]) {
+            space->sketches[column] = sketch_create(NN_SKETCH_WIDTH, NN_SKETCH_DEPTH,
+                                                    NN_SKETCH_PRECISION);
+            CHECK_MEMORY(space->sketches[column]);
+        }
+    }
+
+    return probability_create_populated(space);
+
+error:
+    if(space) {
+        probability_delete(space);
+    }
+    return NULL;
+}
+
+/**
+ * Creates a probability space from a copy of the samples matrix, grouping the
+ * values of continuous fields into bins.
+ *
+ * A binned field has one event per bin instead of one per distinct value, so
+ * its `events`, `occurs` and `P` take O(bins) memory:
+ *   - NN_BINNING_WIDTH splits the range of the samples into equal bins,
+ *     events are the bin centers;
+ *   - NN_BINNING_QUANTILE puts the same number of samples into every bin,
+ *     events are the bin centers;
+ *   - NN_BINNING_STREAMING keeps a streaming histogram: every sample adds a
+ *     centroid and the two closest centroids merge once there are more than
+ *     `bins`, events are the centroids.
+ * Values appended outside of the initial range fall into the outer bins.
+ * The expected value and the variance of a binned field come from the running
+ * moments and stay exact.
+ *
+ * @param samples A matrix with one sample per row and one field per column.
+ * @param fields The names of the fields, one per column.
+ * @param binned_fields A NULL-terminated array of the fields to bin.
+ * @param binning The binning strategy.
+ * @param bins The number of bins.
+ * @returns A new probability space, or NULL on failure.
+ */
+probability *probability_from_matrix_binned(matrix *samples, char **fields, char **binned_fields,
+                                            enum nn_binning binning, size_t bins) {
+    probability *space = NULL;
+    matrix *copy;
+
+    MATRIX_CHECK(samples);
+    CHECK_MEMORY(binned_fields);
+    CHECK(bins > 0, "Binning needs at least one bin");
+    CHECK(binning > NN_BINNING_NONE && binning <= NN_BINNING_STREAMING,
+          "Wrong binning %d", binning);
+
+    copy = matrix_clone(samples);
+    MATRIX_CHECK(copy);
+
+    space = probability_create(copy, fields, NN_ROW_MAJOR);
+    if(!space) {
+        number_unref((number *)copy);
+        return NULL;
+    }
+
+    space->bins = calloc(PROBABILITY_WIDTH(space), sizeof(struct nn_bins*));
+    CHECK_MEMORY(space->bins);
 
-    probability_space_populate(&space);
+    for(size_t field_index = 0; binned_fields[field_index]; field_index++) {
+        PROBABILITY_COLUMN(space, binned_fields[field_index]) {
+            CHECK(probability_bins_create(space, column, binning, bins) == 0,
+                  "Binning of %s failed", binned_fields[field_index]);
+        }
+    }
 
-    space_ptr = malloc(sizeof(probability));
-    *space_ptr = space;
+    return probability_create_populated(space);
 
-    return space_ptr;
+error:
+    if(space) {
+        probability_delete(space);
+    }
+    return NULL;
 }
 
 void probability_delete(probability *space) {
-    for(size_t index = 0; index < space->samples->columns; index++) {
-        number_delete(space->events[index]);
-        number_delete(space->P[index]);
-        number_delete(space->occurs[index]);
+    for(size_t index = 0; index < PROBABILITY_WIDTH(space); index++) {
+        if(space->events[index]) {
+            number_delete(space->events[index]);
+            number_delete(space->P[index]);
+            number_delete(space->occurs[index]);
+        }
         free(space->fields[index]);
+        if(space->lookups) {
+            free(space->lookups[index].codes);
+        }
+        if(space->sketches) {
+            sketch_delete(space->sketches[index]);
+        }
+        if(PROBABILITY_BINNED(space, index)) {
+            if(space->bins[index]->edges) {
+                number_delete(space->bins[index]->edges);
+            }
+            free(space->bins[index]);
+        }
     }
     free(space->fields);
 
-    number_delete(space->samples);
+    number_unref((number *)space->samples);
     number_delete(space->covariance);
     number_delete(space->correlation);
+    number_delete(space->comoment);
+    if(space->mutual_information) {
+        number_delete(space->mutual_information);
+    }
 
     free(space->events);
     free(space->occurs);
     free(space->P);
+    free(space->lookups);
     free(space->variance);
+    free(space->mean);
+    free(space->sketches);
+    free(space->bins);
+    probability_cache_free(space);
 
     free(space);
 }
@@ -125,268 +515,2274 @@ size_t probability_get_field_index(probability *space, char *field) {
     return 0;
 }
 
-/**
- * Counts the number of times each event occurs in a probability space.
- *
- * @param space A pointer to a probability space.
- * @returns The same probability space, but with the `occurs` member set to the frequency of each event.
- */
-probability *probability_count_events(probability *space) {
-    MATRIX_FOREACH(space->samples) {
-        int event_index = vector_index_of(space->events[column], MATRIX(space->samples, row, column));
-        VECTOR(space->occurs[column], (size_t)event_index) += 1;
-    }
+/* Maximum number of fields in a cached joint mass */
+#define NN_PROBABILITY_CACHE_WIDTH 4
+#define NN_PROBABILITY_CACHE_NONE  ((size_t)-1)
 
-    return space;
-}
+/* Kind of a cached mass. A marginal of a summarized column answers per bin or
+ * from its sketch while a joint one counts the samples, so a width-1 key of
+ * both kinds may hold different masses */
+#define NN_PROBABILITY_CACHE_MARGINAL 0
+#define NN_PROBABILITY_CACHE_JOINT    1
+
+struct nn_probability_cache_entry {
+    size_t  hash;
+    int     kind;
+    size_t  width;
+    size_t  columns[NN_PROBABILITY_CACHE_WIDTH];
+    NN_TYPE keys[NN_PROBABILITY_CACHE_WIDTH];
+    NN_TYPE mass;
+
+    size_t prev;  /* LRU list, towards the most recently used */
+    size_t next;  /* LRU list, towards the least recently used */
+    size_t chain; /* next entry in the same hash bucket */
+};
+
+struct nn_probability_cache {
+    size_t capacity;
+    size_t size;
+    size_t hits;
+    size_t misses;
+
+    size_t  head;
+    size_t  tail;
+    size_t *buckets;
+    struct nn_probability_cache_entry *entries;
+};
 
 /**
- * Calculates the joint probability mass of multiple fields taking on specific values.
+ * Enables a bounded memoization cache for the marginal and joint masses of a
+ * probability space, or resizes it.
  *
- * Joint probability mass is the probability of all specified values occurring together in a
- * discrete probability distribution with multiple fields.
+ * probability_mass_of() and probability_mass_and() look their (field set,
+ * value tuple) key up in the cache before scanning the space. Once the cache
+ * is full, the least recently used mass is evicted. Any incremental update of
+ * the space clears the cache. The cache is not thread-safe: every lookup
+ * reorders its LRU list, so a space with a cache must not be read from
+ * several threads at once.
  *
  * @param space A pointer to a probability space.
- * @param fields An array of the names of the fields.
- * @param values An array of the values of the fields.
- * @returns The joint probability mass of the specified fields taking on the given values in the probability space.
+ * @param capacity The maximum number of cached masses, or 0 to disable the cache.
+ * @returns The same probability space, or NULL on failure.
  */
-NN_TYPE probability_mass_and(probability *space, char **fields, NN_TYPE *values) {
-    size_t occur = 0;
-
-    for(size_t index = 0; index < space->samples->rows; index++) {
-        int is_suitable = 0;
+probability *probability_cache_enable(probability *space, size_t capacity)
+{
+    struct nn_probability_cache *cache = NULL;
 
-        PROBABILITY_COLUMNS(space) {
-            size_t field_index = 0;
-            int is_breaked = 0;
-            while(fields[field_index]) {
-                if(strcmp(space->fields[column], fields[field_index]) == 0) {
-                    if(MATRIX(space->samples, index, column) == values[field_index]) {
-                        is_suitable = 1;
-                    } else {
-                        is_suitable = 0;
-                        is_breaked = 1;
-                        break;
-                    }
-                }
-                field_index++;
-            }
+    CHECK_MEMORY(space);
 
-            if(is_breaked) {
-                is_suitable = 0;
-                break;
-            }
-        }
+    probability_cache_free(space);
 
-        if(is_suitable) {
-            occur++;
-        }
+    if(capacity == 0) {
+        return space;
     }
 
-    return (NN_TYPE)occur / (NN_TYPE)space->samples->rows;
-}
+    cache = calloc(1, sizeof(struct nn_probability_cache));
+    CHECK_MEMORY(cache);
+    cache->capacity = capacity;
+    cache->entries = malloc(capacity * sizeof(struct nn_probability_cache_entry));
+    CHECK_MEMORY(cache->entries);
+    cache->buckets = malloc(capacity * sizeof(size_t));
+    CHECK_MEMORY(cache->buckets);
 
-/**
-* Calculates the conditional probability of a value in one field occurring given that
-* a value in another field has occurred.
-*
-* Conditional probability is the probability of an event occurring given that another event has occurred.
-* This function calculates the joint probability mass of both fields taking on the specified values
-* divided by the probability mass of the specified value in the second field.
-*
-* @param space A pointer to a probability space.
-* @param A_field The name of the field for which to calculate conditional probability.
-* @param A_value The value of the field for which to calculate conditional probability.
-* @param B_field The name of the field that occurred for calculating conditional probability.
-* @param B_value The value of the field, aka occurred, for which to calculate conditional probability.
-* @returns The conditional probability of the specified values.
-*/
-NN_TYPE probability_conditional(probability *space, char *A_field, NN_TYPE A_value, char *B_field, NN_TYPE B_value) {
-    char *fields[] = { A_field, B_field, NULL };
-    NN_TYPE values[] = { A_value, B_value };
+    space->cache = cache;
+    probability_cache_clear(space);
 
-    NN_TYPE P_AB = probability_mass_and(space, fields, values);
-    NN_TYPE P_B = probability_mass_of(space, B_field, B_value);
+    return space;
 
-    return P_AB / P_B;
+error:
+    if(cache) {
+        free(cache->entries);
+        free(cache->buckets);
+        free(cache);
+    }
+    return NULL;
 }
 
 /**
- * Calculates the conditional probability of a value in one field occurring given that
- * a value in another field has occurred using Bayes theorem.
- *
- * Bayes theorem is a formula that describes how to update the probabilities of hypotheses
- * when given evidence. It is commonly used in statistical inference and machine learning.
+ * Drops every cached mass of a probability space, keeping the hit and miss
+ * counters.
  *
  * @param space A pointer to a probability space.
- * @param A_field The name of the field for which to calculate conditional probability.
- * @param A_value The value of the field for which to calculate conditional probability.
- * @param B_field The name of the field that occurred for calculating conditional probability.
- * @param B_value The value of the field, aka occurred, for which to calculate conditional probability.
- * @returns The conditional probability of the specified values, calculated using Bayes theorem.
  */
-NN_TYPE probability_bayes(probability *space, char *A_field, NN_TYPE A_value, char *B_field, NN_TYPE B_value) {
-    NN_TYPE P_BA = probability_conditional(space, B_field, B_value, A_field, A_value);
-    NN_TYPE P_A = probability_mass_of(space, A_field, A_value);
-    NN_TYPE P_B = probability_mass_of(space, B_field, B_value);
+void probability_cache_clear(probability *space)
+{
+    struct nn_probability_cache *cache = space->cache;
 
-    return P_A * P_BA / P_B;
+    if(!cache) {
+        return;
+    }
+
+    cache->size = 0;
+    cache->head = NN_PROBABILITY_CACHE_NONE;
+    cache->tail = NN_PROBABILITY_CACHE_NONE;
+    for(size_t bucket = 0; bucket < cache->capacity; bucket++) {
+        cache->buckets[bucket] = NN_PROBABILITY_CACHE_NONE;
+    }
 }
 
 /**
- * Calculates the probability mass of a given field taking on a particular value.
- *
- * Probability mass is the probability of a specific value occurring in a discrete probability distribution.
+ * Frees the cache of a probability space, if any, which disables it.
  *
  * @param space A pointer to a probability space.
- * @param field The name of the field.
- * @param value The value of the field for which to calculate the probability mass.
- * @returns The probability mass of the field taking on the given value in the probability space.
  */
-NN_TYPE probability_mass_of(probability *space, char *field, NN_TYPE value) {
-    PROBABILITY_COLUMN(space, field) {
-        return VECTOR(space->P[column], vector_index_of(space->events[column], value));
+void probability_cache_free(probability *space)
+{
+    struct nn_probability_cache *cache = space->cache;
+
+    if(!cache) {
+        return;
     }
 
-    return 0;
+    free(cache->entries);
+    free(cache->buckets);
+    free(cache);
+    space->cache = NULL;
 }
 
 /**
- * Calculates the expected value (aka mean) of a given field in a probability space.
- *
- * Expected value is the sum of the product of values and their probabilities in a probability space.
+ * Reads the counters of the cache of a probability space. Every counter is 0
+ * when the cache is disabled.
  *
  * @param space A pointer to a probability space.
- * @param field The name of the field.
- * @returns The expected value of the field in the probability space.
+ * @param hits Receives the number of lookups which found their mass, or NULL.
+ * @param misses Receives the number of lookups which didn't, or NULL.
+ * @param size Receives the number of cached masses, or NULL.
  */
-NN_TYPE probability_expected_value(probability *space, char *field)
+void probability_cache_stats(probability *space, size_t *hits, size_t *misses, size_t *size)
 {
-    NN_TYPE mu = 0;
+    struct nn_probability_cache *cache = space->cache;
 
-    PROBABILITY_SUM(space, field, mu, x * Px);
-
-    return mu;
+    if(hits) {
+        *hits = cache ? cache->hits : 0;
+    }
+    if(misses) {
+        *misses = cache ? cache->misses : 0;
+    }
+    if(size) {
+        *size = cache ? cache->size : 0;
+    }
+}
+
+/**
+ * Builds the cache key of a joint mass query: the columns of the fields in
+ * ascending order with their values.
+ *
+ * @param space A pointer to a probability space.
+ * @param fields A NULL-terminated array of field names.
+ * @param values The value of every field.
+ * @param columns Receives the columns of the key.
+ * @param keys Receives the values of the key.
+ * @returns The width of the key, or 0 if the query can't be cached.
+ */
+static size_t probability_cache_key(probability *space, char **fields, NN_TYPE *values,
+                                    size_t *columns, NN_TYPE *keys)
+{
+    size_t width = 0;
+
+    if(!space->cache) {
+        return 0;
+    }
+
+    for(size_t field_index = 0; fields[field_index]; field_index++) {
+        size_t position;
+        int is_found = 0;
+
+        if(width == NN_PROBABILITY_CACHE_WIDTH) {
+            return 0;
+        }
+
+        PROBABILITY_COLUMN(space, fields[field_index]) {
+            /* Insertion sort keeps equal queries in any field order on one key */
+            for(position = width; position > 0 && columns[position - 1] > column; position--) {
+                columns[position] = columns[position - 1];
+                keys[position] = keys[position - 1];
+            }
+            columns[position] = column;
+            keys[position] = values[field_index];
+            width++;
+            is_found = 1;
+            break;
+        }
+
+        if(!is_found) {
+            return 0;
+        }
+    }
+
+    return width;
+}
+
+static size_t probability_cache_hash(int kind, size_t width, size_t *columns, NN_TYPE *keys)
+{
+    size_t hash = (14695981039346656037ULL ^ (size_t)kind) * 1099511628211ULL;
+
+    for(size_t index = 0; index < width; index++) {
+        unsigned char *bytes = (unsigned char *)&keys[index];
+
+        hash = (hash ^ columns[index]) * 1099511628211ULL;
+        for(size_t byte = 0; byte < sizeof(NN_TYPE); byte++) {
+            hash = (hash ^ bytes[byte]) * 1099511628211ULL;
+        }
+    }
+
+    return hash;
+}
+
+/* Unlinks an entry from the LRU list */
+static void probability_cache_detach(struct nn_probability_cache *cache, size_t slot)
+{
+    struct nn_probability_cache_entry *entry = &cache->entries[slot];
+
+    if(entry->prev != NN_PROBABILITY_CACHE_NONE) {
+        cache->entries[entry->prev].next = entry->next;
+    } else {
+        cache->head = entry->next;
+    }
+
+    if(entry->next != NN_PROBABILITY_CACHE_NONE) {
+        cache->entries[entry->next].prev = entry->prev;
+    } else {
+        cache->tail = entry->prev;
+    }
+}
+
+/* Links an entry at the most recently used end of the LRU list */
+static void probability_cache_attach(struct nn_probability_cache *cache, size_t slot)
+{
+    struct nn_probability_cache_entry *entry = &cache->entries[slot];
+
+    entry->prev = NN_PROBABILITY_CACHE_NONE;
+    entry->next = cache->head;
+    if(cache->head != NN_PROBABILITY_CACHE_NONE) {
+        cache->entries[cache->head].prev = slot;
+    }
+    cache->head = slot;
+    if(cache->tail == NN_PROBABILITY_CACHE_NONE) {
+        cache->tail = slot;
+    }
+}
+
+/**
+ * Looks a mass up in the cache of a probability space.
+ *
+ * @returns 1 and sets `mass` on a hit, 0 on a miss.
+ */
+static int probability_cache_get(probability *space, int kind, size_t width, size_t *columns,
+                                 NN_TYPE *keys, NN_TYPE *mass)
+{
+    struct nn_probability_cache *cache = space->cache;
+    size_t hash = probability_cache_hash(kind, width, columns, keys);
+    size_t slot = cache->buckets[hash % cache->capacity];
+
+    while(slot != NN_PROBABILITY_CACHE_NONE) {
+        struct nn_probability_cache_entry *entry = &cache->entries[slot];
+
+        if(entry->hash == hash && entry->kind == kind && entry->width == width
+           && memcmp(entry->columns, columns, width * sizeof(size_t)) == 0
+           && memcmp(entry->keys, keys, width * sizeof(NN_TYPE)) == 0) {
+            probability_cache_detach(cache, slot);
+            probability_cache_attach(cache, slot);
+            cache->hits++;
+            *mass = entry->mass;
+
+            return 1;
+        }
+
+        slot = entry->chain;
+    }
+
+    cache->misses++;
+
+    return 0;
+}
+
+/**
+ * Stores a mass in the cache of a probability space, evicting the least
+ * recently used one when the cache is full.
+ */
+static void probability_cache_put(probability *space, int kind, size_t width, size_t *columns,
+                                  NN_TYPE *keys, NN_TYPE mass)
+{
+    struct nn_probability_cache *cache = space->cache;
+    struct nn_probability_cache_entry *entry;
+    size_t slot;
+    size_t bucket;
+
+    if(cache->size < cache->capacity) {
+        slot = cache->size++;
+    } else {
+        size_t *link;
+
+        slot = cache->tail;
+        probability_cache_detach(cache, slot);
+
+        link = &cache->buckets[cache->entries[slot].hash % cache->capacity];
+        while(*link != slot) {
+            link = &cache->entries[*link].chain;
+        }
+        *link = cache->entries[slot].chain;
+    }
+
+    entry = &cache->entries[slot];
+    entry->hash = probability_cache_hash(kind, width, columns, keys);
+    entry->kind = kind;
+    entry->width = width;
+    entry->mass = mass;
+    memcpy(entry->columns, columns, width * sizeof(size_t));
+    memcpy(entry->keys, keys, width * sizeof(NN_TYPE));
+
+    bucket = entry->hash % cache->capacity;
+    entry->chain = cache->buckets[bucket];
+    cache->buckets[bucket] = slot;
+
+    probability_cache_attach(cache, slot);
+}
+
+/**
+ * Maps a value of a column to what joint masses compare, so they count the
+ * same events as the marginals: the bin of the value in a binned column, or
+ * the value itself.
+ *
+ * @param space A pointer to a probability space.
+ * @param column The index of the column.
+ * @param value The value.
+ * @returns The code of the value, or NaN if it falls in no event.
+ */
+static NN_TYPE probability_joint_code(probability *space, size_t column, NN_TYPE value)
+{
+    int bin;
+
+    if(isnan(value) || !PROBABILITY_BINNED(space, column)) {
+        return value;
+    }
+
+    bin = probability_bin_of(space, column, value);
+
+    return bin < 0 ? NAN : (NN_TYPE)bin;
+}
+
+/**
+ * Calculates the joint probability mass of multiple fields taking on specific values.
+ *
+ * Joint probability mass is the probability of all specified values occurring together in a
+ * discrete probability distribution with multiple fields.
+ *
+ * When the cache of the space is enabled, this updates it, so it isn't
+ * thread-safe (see probability_cache_enable()).
+ *
+ * @param space A pointer to a probability space.
+ * @param fields An array of the names of the fields.
+ * @param values An array of the values of the fields.
+ * @returns The joint probability mass of the specified fields taking on the given values in the probability space.
+ */
+NN_TYPE probability_mass_and(probability *space, char **fields, NN_TYPE *values) {
+    size_t occur = 0;
+    size_t columns[NN_PROBABILITY_CACHE_WIDTH];
+    NN_TYPE keys[NN_PROBABILITY_CACHE_WIDTH];
+    size_t width;
+    NN_TYPE mass;
+
+    width = probability_cache_key(space, fields, values, columns, keys);
+    if(width && probability_cache_get(space, NN_PROBABILITY_CACHE_JOINT, width, columns, keys, &mass)) {
+        return mass;
+    }
+
+    for(size_t index = 0; index < PROBABILITY_ROWS(space); index++) {
+        int is_suitable = 0;
+
+        PROBABILITY_COLUMNS(space) {
+            size_t field_index = 0;
+            int is_breaked = 0;
+            while(fields[field_index]) {
+                if(strcmp(space->fields[column], fields[field_index]) == 0) {
+                    if(probability_joint_code(space, column, PROBABILITY_SAMPLE(space, index, column))
+                       == probability_joint_code(space, column, values[field_index])) {
+                        is_suitable = 1;
+                    } else {
+                        is_suitable = 0;
+                        is_breaked = 1;
+                        break;
+                    }
+                }
+                field_index++;
+            }
+
+            if(is_breaked) {
+                is_suitable = 0;
+                break;
+            }
+        }
+
+        if(is_suitable) {
+            occur++;
+        }
+    }
+
+    mass = (NN_TYPE)occur / (NN_TYPE)PROBABILITY_ROWS(space);
+    if(width) {
+        probability_cache_put(space, NN_PROBABILITY_CACHE_JOINT, width, columns, keys, mass);
+    }
+
+    return mass;
+}
+
+/**
+* Calculates the conditional probability of a value in one field occurring given that
+* a value in another field has occurred.
+*
+* Conditional probability is the probability of an event occurring given that another event has occurred.
+* This function calculates the joint probability mass of both fields taking on the specified values
+* divided by the probability mass of the specified value in the second field.
+*
+* @param space A pointer to a probability space.
+* @param A_field The name of the field for which to calculate conditional probability.
+* @param A_value The value of the field for which to calculate conditional probability.
+* @param B_field The name of the field that occurred for calculating conditional probability.
+* @param B_value The value of the field, aka occurred, for which to calculate conditional probability.
+* @returns The conditional probability of the specified values.
+*/
+NN_TYPE probability_conditional(probability *space, char *A_field, NN_TYPE A_value, char *B_field, NN_TYPE B_value) {
+    char *fields[] = { A_field, B_field, NULL };
+    NN_TYPE values[] = { A_value, B_value };
+
+    NN_TYPE P_AB = probability_mass_and(space, fields, values);
+    NN_TYPE P_B = probability_mass_of(space, B_field, B_value);
+
+    return P_AB / P_B;
+}
+
+/**
+ * Calculates the conditional probability of a value in one field occurring given that
+ * a value in another field has occurred using Bayes theorem.
+ *
+ * Bayes theorem is a formula that describes how to update the probabilities of hypotheses
+ * when given evidence. It is commonly used in statistical inference and machine learning.
+ *
+ * @param space A pointer to a probability space.
+ * @param A_field The name of the field for which to calculate conditional probability.
+ * @param A_value The value of the field for which to calculate conditional probability.
+ * @param B_field The name of the field that occurred for calculating conditional probability.
+ * @param B_value The value of the field, aka occurred, for which to calculate conditional probability.
+ * @returns The conditional probability of the specified values, calculated using Bayes theorem.
+ */
+NN_TYPE probability_bayes(probability *space, char *A_field, NN_TYPE A_value, char *B_field, NN_TYPE B_value) {
+    NN_TYPE P_BA = probability_conditional(space, B_field, B_value, A_field, A_value);
+    NN_TYPE P_A = probability_mass_of(space, A_field, A_value);
+    NN_TYPE P_B = probability_mass_of(space, B_field, B_value);
+
+    return P_A * P_BA / P_B;
+}
+
+/**
+ * Finds the event of a value in an exact column by bisection over the
+ * sorted copy of its events.
+ *
+ * @param space A pointer to a probability space.
+ * @param column The column index of the event.
+ * @param value The value of the event.
+ * @returns The index of the event in `events`, or -1 if the value isn't an event.
+ */
+static int probability_event_find(probability *space, size_t column, NN_TYPE value)
+{
+    struct nn_probability_lookup *lookup = &space->lookups[column];
+    struct probability_code key = {value, 0};
+    struct probability_code *found;
+
+    if(isnan(value)) {
+        return -1;
+    }
+
+    found = bsearch(&key, lookup->codes, lookup->length, sizeof(struct probability_code),
+                    probability_code_compare);
+
+    return found ? (int)found->index : -1;
+}
+
+/**
+ * Inserts a new event of an exact column into the sorted copy of its events.
+ *
+ * @param space A pointer to a probability space.
+ * @param column The column index of the event.
+ * @param value The value of the event.
+ * @param index The index of the event in `events`.
+ * @returns 0 on success, 1 on failure.
+ */
+static int probability_event_insert(probability *space, size_t column, NN_TYPE value, size_t index)
+{
+    struct nn_probability_lookup *lookup = &space->lookups[column];
+    struct probability_code key = {value, (uint32_t)index};
+    size_t low = 0;
+    size_t high = lookup->length;
+
+    CHECK(index < PROBABILITY_CODE_NONE, "Too many events in field %s", space->fields[column]);
+
+    if(lookup->length == lookup->capacity) {
+        size_t capacity = lookup->capacity ? 2 * lookup->capacity : 16;
+        struct probability_code *codes = realloc(lookup->codes, capacity * sizeof(struct probability_code));
+
+        CHECK_MEMORY(codes);
+        lookup->codes = codes;
+        lookup->capacity = capacity;
+    }
+
+    while(low < high) {
+        size_t middle = (low + high) / 2;
+
+        if(probability_code_compare(&lookup->codes[middle], &key) <= 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    memmove(&lookup->codes[low + 1], &lookup->codes[low],
+            (lookup->length - low) * sizeof(struct probability_code));
+    lookup->codes[low] = key;
+    lookup->length++;
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/**
+ * Looks the probability mass of a value up in a column, from the sketch of
+ * the column when it has one, or as the mass of the bin of the value.
+ */
+static NN_TYPE probability_column_mass(probability *space, size_t column, NN_TYPE value)
+{
+    int event_index;
+
+    if(PROBABILITY_SKETCHED(space, column)) {
+        return sketch_count(space->sketches[column], value) / (NN_TYPE)PROBABILITY_ROWS(space);
+    }
+
+    event_index = PROBABILITY_BINNED(space, column)
+                      ? probability_bin_of(space, column, value)
+                      : probability_event_find(space, column, value);
+
+    return event_index < 0 ? 0 : VECTOR(space->P[column], (size_t)event_index);
+}
+
+/**
+ * Calculates the probability mass of a given field taking on a particular value.
+ *
+ * Probability mass is the probability of a specific value occurring in a discrete probability distribution.
+ *
+ * When the cache of the space is enabled, this updates it, so it isn't
+ * thread-safe (see probability_cache_enable()).
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @param value The value of the field for which to calculate the probability mass.
+ * @returns The probability mass of the field taking on the given value in the probability space.
+ */
+NN_TYPE probability_mass_of(probability *space, char *field, NN_TYPE value) {
+    PROBABILITY_COLUMN(space, field) {
+        NN_TYPE mass;
+
+        if(space->cache && probability_cache_get(space, NN_PROBABILITY_CACHE_MARGINAL, 1, &column, &value, &mass)) {
+            return mass;
+        }
+
+        mass = probability_column_mass(space, column, value);
+        if(space->cache) {
+            probability_cache_put(space, NN_PROBABILITY_CACHE_MARGINAL, 1, &column, &value, mass);
+        }
+
+        return mass;
+    }
+
+    return 0;
+}
+
+/* A (field, value) term shared by one or more batched queries */
+struct probability_term {
+    size_t  query;
+    size_t  A_column;
+    size_t  B_column;
+    NN_TYPE A_value;
+    NN_TYPE B_value;
+    size_t  occurs;
+    NN_TYPE mass;
+};
+
+static int probability_term_compare(const void *left, const void *right)
+{
+    const struct probability_term *a = left;
+    const struct probability_term *b = right;
+    int order;
+
+    if(a->A_column != b->A_column) return a->A_column < b->A_column ? -1 : 1;
+    if(a->B_column != b->B_column) return a->B_column < b->B_column ? -1 : 1;
+
+    order = probability_value_order(a->A_value, b->A_value);
+
+    return order ? order : probability_value_order(a->B_value, b->B_value);
+}
+
+/**
+ * Sorts the terms of a batch and merges the equal ones in place.
+ *
+ * @param terms The terms, one per query.
+ * @param count The number of terms.
+ * @param slots Receives, for every query, the index of its merged term.
+ * @returns The number of distinct terms.
+ */
+static size_t probability_terms_unique(struct probability_term *terms, size_t count, size_t *slots)
+{
+    size_t unique = 0;
+
+    qsort(terms, count, sizeof(struct probability_term), probability_term_compare);
+
+    for(size_t index = 0; index < count; index++) {
+        if(index == 0 || probability_term_compare(&terms[unique - 1], &terms[index]) != 0) {
+            terms[unique++] = terms[index];
+        }
+        slots[terms[index].query] = unique - 1;
+    }
+
+    return unique;
+}
+
+/**
+ * Looks up the marginal mass of every distinct (A_column, A_value) term.
+ *
+ * @param space A pointer to a probability space.
+ * @param terms The distinct terms.
+ * @param count The number of distinct terms.
+ */
+static void probability_terms_mass_of(probability *space, struct probability_term *terms, size_t count)
+{
+    #pragma omp parallel for
+    for(size_t index = 0; index < count; index++) {
+        terms[index].mass = probability_column_mass(space, terms[index].A_column, terms[index].A_value);
+    }
+}
+
+/**
+ * Computes the joint mass of every distinct (A, B) term in a single parallel
+ * pass over the samples.
+ *
+ * The terms are grouped by their pair of columns, and every sample looks its
+ * pair of values up in each group with a binary search, so the pass costs
+ * O(samples * groups * log(terms)) however many queries share the terms.
+ *
+ * @param space A pointer to a probability space.
+ * @param terms The distinct terms, sorted by probability_term_compare().
+ * @param count The number of distinct terms.
+ * @returns 0 on success, 1 on failure.
+ */
+static int probability_terms_mass_and(probability *space, struct probability_term *terms, size_t count)
+{
+    size_t groups = 0;
+    size_t *group_begin = NULL;
+    size_t *occurs = NULL;
+    size_t rows = PROBABILITY_ROWS(space);
+    size_t threads = (size_t)omp_get_max_threads();
+
+    group_begin = malloc((count + 1) * sizeof(size_t));
+    CHECK_MEMORY(group_begin);
+    occurs = calloc(threads * count, sizeof(size_t));
+    CHECK_MEMORY(occurs);
+
+    for(size_t index = 0; index < count; index++) {
+        if(index == 0 || terms[index].A_column != terms[index - 1].A_column
+           || terms[index].B_column != terms[index - 1].B_column) {
+            group_begin[groups++] = index;
+        }
+    }
+    group_begin[groups] = count;
+
+    /* Every thread counts into its own row of `occurs` on the heap, summed
+     * after the loop, so popular terms don't serialize the threads on shared
+     * counters and millions of terms don't overflow the thread stacks */
+    #pragma omp parallel num_threads(threads)
+    {
+        size_t *counts = &occurs[(size_t)omp_get_thread_num() * count];
+
+        #pragma omp for
+        for(size_t row = 0; row < rows; row++) {
+            for(size_t group = 0; group < groups; group++) {
+                struct probability_term key = terms[group_begin[group]];
+                struct probability_term *found;
+
+                key.A_value = probability_joint_code(space, key.A_column,
+                                                     PROBABILITY_SAMPLE(space, row, key.A_column));
+                key.B_value = probability_joint_code(space, key.B_column,
+                                                     PROBABILITY_SAMPLE(space, row, key.B_column));
+
+                /* NaN never equals a queried value */
+                if(isnan(key.A_value) || isnan(key.B_value)) {
+                    continue;
+                }
+
+                found = bsearch(&key, &terms[group_begin[group]],
+                                group_begin[group + 1] - group_begin[group],
+                                sizeof(struct probability_term), probability_term_compare);
+                if(found) {
+                    counts[found - terms]++;
+                }
+            }
+        }
+    }
+
+    #pragma omp parallel for
+    for(size_t index = 0; index < count; index++) {
+        size_t total = 0;
+
+        for(size_t thread = 0; thread < threads; thread++) {
+            total += occurs[thread * count + index];
+        }
+        terms[index].occurs = total;
+        terms[index].mass = (NN_TYPE)total / (NN_TYPE)rows;
+    }
+
+    free(group_begin);
+    free(occurs);
+
+    return 0;
+
+error:
+    free(group_begin);
+    free(occurs);
+
+    return 1;
+}
+
+/**
+ * Calculates the probability mass of many (field, value) conditions at once.
+ *
+ * Repeated conditions are looked up only once.
+ *
+ * @param space A pointer to a probability space.
+ * @param count The number of queries.
+ * @param fields The field of every query.
+ * @param values The value of every query.
+ * @param result A vector of at least `count` elements for the results, or NULL to allocate one.
+ * @returns The vector with the probability mass of every query, or NULL on failure.
+ */
+vector *probability_mass_batch(probability *space, size_t count, char **fields, NN_TYPE *values, vector *result)
+{
+    struct probability_term *terms = NULL;
+    size_t *slots = NULL;
+    size_t unique;
+
+    CHECK_MEMORY(space);
+    CHECK(count, "Empty batch");
+    CHECK(!result || result->length >= count, "Result vector is too short");
+
+    terms = malloc(count * sizeof(struct probability_term));
+    CHECK_MEMORY(terms);
+    slots = malloc(count * sizeof(size_t));
+    CHECK_MEMORY(slots);
+
+    for(size_t query = 0; query < count; query++) {
+        terms[query] = (struct probability_term) {
+            .query = query,
+            .A_column = probability_get_field_index(space, fields[query]),
+            .A_value = values[query]
+        };
+    }
+
+    unique = probability_terms_unique(terms, count, slots);
+    probability_terms_mass_of(space, terms, unique);
+
+    if(!result) {
+        result = vector_create(count);
+        VECTOR_CHECK(result);
+    }
+
+    for(size_t query = 0; query < count; query++) {
+        VECTOR(result, query) = terms[slots[query]].mass;
+    }
+
+    free(terms);
+    free(slots);
+
+    return result;
+
+error:
+    free(terms);
+    free(slots);
+
+    return NULL;
+}
+
+/**
+ * Calculates the joint and marginal masses shared by a batch of conditional
+ * queries P(A | B).
+ *
+ * @param space A pointer to a probability space.
+ * @param count The number of queries.
+ * @param A_fields, A_values The conditioned (field, value) of every query.
+ * @param B_fields, B_values The occurred (field, value) of every query.
+ * @param P_AB Receives the joint mass P(A and B) of every query.
+ * @param P_A Receives the marginal mass P(A) of every query.
+ * @param P_B Receives the marginal mass P(B) of every query.
+ * @returns 0 on success, 1 on failure.
+ */
+static int probability_batch_terms(probability *space, size_t count,
+                                   char **A_fields, NN_TYPE *A_values,
+                                   char **B_fields, NN_TYPE *B_values,
+                                   NN_TYPE *P_AB, NN_TYPE *P_A, NN_TYPE *P_B)
+{
+    struct probability_term *terms = NULL;
+    size_t *slots = NULL;
+    size_t unique;
+
+    terms = malloc(2 * count * sizeof(struct probability_term));
+    CHECK_MEMORY(terms);
+    slots = malloc(2 * count * sizeof(size_t));
+    CHECK_MEMORY(slots);
+
+    /* Joint terms, by code so values in one bin share a term */
+    for(size_t query = 0; query < count; query++) {
+        size_t A_column = probability_get_field_index(space, A_fields[query]);
+        size_t B_column = probability_get_field_index(space, B_fields[query]);
+
+        terms[query] = (struct probability_term) {
+            .query = query,
+            .A_column = A_column,
+            .B_column = B_column,
+            .A_value = probability_joint_code(space, A_column, A_values[query]),
+            .B_value = probability_joint_code(space, B_column, B_values[query])
+        };
+    }
+
+    unique = probability_terms_unique(terms, count, slots);
+    CHECK(probability_terms_mass_and(space, terms, unique) == 0, "Joint terms failed");
+    for(size_t query = 0; query < count; query++) {
+        P_AB[query] = terms[slots[query]].mass;
+    }
+
+    /* Marginal terms of both sides share one lookup */
+    for(size_t query = 0; query < count; query++) {
+        terms[query] = (struct probability_term) {
+            .query = query,
+            .A_column = probability_get_field_index(space, A_fields[query]),
+            .A_value = A_values[query]
+        };
+        terms[count + query] = (struct probability_term) {
+            .query = count + query,
+            .A_column = probability_get_field_index(space, B_fields[query]),
+            .A_value = B_values[query]
+        };
+    }
+
+    unique = probability_terms_unique(terms, 2 * count, slots);
+    probability_terms_mass_of(space, terms, unique);
+    for(size_t query = 0; query < count; query++) {
+        P_A[query] = terms[slots[query]].mass;
+        P_B[query] = terms[slots[count + query]].mass;
+    }
+
+    free(terms);
+    free(slots);
+
+    return 0;
+
+error:
+    free(terms);
+    free(slots);
+
+    return 1;
+}
+
+/**
+ * Calculates a batch of conditional probabilities P(A | B).
+ *
+ * Every distinct joint and marginal term is computed once for the whole
+ * batch, and all joint terms are counted in a single parallel pass over the
+ * samples instead of one pass per query.
+ *
+ * @param space A pointer to a probability space.
+ * @param count The number of queries.
+ * @param A_fields, A_values The conditioned (field, value) of every query.
+ * @param B_fields, B_values The occurred (field, value) of every query.
+ * @param result A vector of at least `count` elements for the results, or NULL to allocate one.
+ * @returns The vector with the conditional probability of every query, or NULL on failure.
+ */
+vector *probability_conditional_batch(probability *space, size_t count,
+                                      char **A_fields, NN_TYPE *A_values,
+                                      char **B_fields, NN_TYPE *B_values,
+                                      vector *result)
+{
+    NN_TYPE *masses = NULL;
+
+    CHECK_MEMORY(space);
+    CHECK(count, "Empty batch");
+    CHECK(!result || result->length >= count, "Result vector is too short");
+
+    masses = malloc(3 * count * sizeof(NN_TYPE));
+    CHECK_MEMORY(masses);
+    CHECK(probability_batch_terms(space, count, A_fields, A_values, B_fields, B_values,
+                                  masses, masses + count, masses + 2 * count) == 0,
+          "Batch terms failed");
+
+    if(!result) {
+        result = vector_create(count);
+        VECTOR_CHECK(result);
+    }
+
+    for(size_t query = 0; query < count; query++) {
+        VECTOR(result, query) = masses[query] / masses[2 * count + query];
+    }
+
+    free(masses);
+
+    return result;
+
+error:
+    free(masses);
+
+    return NULL;
+}
+
+/**
+ * Calculates a batch of conditional probabilities P(A | B) using Bayes
+ * theorem, P(A) * P(B | A) / P(B).
+ *
+ * Shares its terms the same way as probability_conditional_batch().
+ *
+ * @param space A pointer to a probability space.
+ * @param count The number of queries.
+ * @param A_fields, A_values The conditioned (field, value) of every query.
+ * @param B_fields, B_values The occurred (field, value) of every query.
+ * @param result A vector of at least `count` elements for the results, or NULL to allocate one.
+ * @returns The vector with the conditional probability of every query, or NULL on failure.
+ */
+vector *probability_bayes_batch(probability *space, size_t count,
+                                char **A_fields, NN_TYPE *A_values,
+                                char **B_fields, NN_TYPE *B_values,
+                                vector *result)
+{
+    NN_TYPE *masses = NULL;
+
+    CHECK_MEMORY(space);
+    CHECK(count, "Empty batch");
+    CHECK(!result || result->length >= count, "Result vector is too short");
+
+    masses = malloc(3 * count * sizeof(NN_TYPE));
+    CHECK_MEMORY(masses);
+    CHECK(probability_batch_terms(space, count, A_fields, A_values, B_fields, B_values,
+                                  masses, masses + count, masses + 2 * count) == 0,
+          "Batch terms failed");
+
+    if(!result) {
+        result = vector_create(count);
+        VECTOR_CHECK(result);
+    }
+
+    for(size_t query = 0; query < count; query++) {
+        NN_TYPE P_AB = masses[query];
+        NN_TYPE P_A = masses[count + query];
+        NN_TYPE P_B = masses[2 * count + query];
+        NN_TYPE P_BA = P_AB / P_A;
+
+        VECTOR(result, query) = P_A * P_BA / P_B;
+    }
+
+    free(masses);
+
+    return result;
+
+error:
+    free(masses);
+
+    return NULL;
+}
+
+/**
+ * Calculates the expected value (aka mean) of a given field in a probability space.
+ *
+ * Expected value is the sum of the product of values and their probabilities in a probability space.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @returns The expected value of the field in the probability space.
+ */
+NN_TYPE probability_expected_value(probability *space, char *field)
+{
+    NN_TYPE mu = 0;
+
+    PROBABILITY_COLUMN(space, field) {
+        if(PROBABILITY_SUMMARIZED(space, column)) {
+            return space->mean[column];
+        }
+    }
+
+    PROBABILITY_COLUMN(space, field) {
+        mu = probability_weighted_sum(&VECTOR(space->events[column], 0), &VECTOR(space->P[column], 0),
+                                      space->events[column]->length);
+    }
+
+    return mu;
+}
+
+/**
+ * Calculates the expected value of a function of a given field, E[f(x)].
+ *
+ * The function is evaluated over blocks of events, then every block is
+ * weighted by the probabilities of its events with a SIMD kernel. Only the
+ * weighting is vectorized: `operation` is still called once per event
+ * through its pointer, so a costly function dominates the time.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @param operation The function of the field.
+ * @returns The expected value of the function, or NAN for unknown or sketched fields.
+ */
+NN_TYPE probability_matrix_expected_value_of_function(probability *space, char *field, NN_TYPE operation(NN_TYPE))
+{
+    NN_TYPE result;
+
+    CHECK_MEMORY(probability_matrix_expected_value_of_function_batch(space, field, 1, &operation, &result));
+
+    return result;
+
+error:
+    return NAN;
+}
+
+/**
+ * Calculates the expected values of several functions of a given field in a
+ * single pass over its events, e.g. E[x], E[x^2] and E[log(x)] at once.
+ *
+ * The events are visited block by block, and every function is evaluated and
+ * weighted on a block while it is still in cache. The weighting uses a SIMD
+ * kernel, but every function is still called once per event.
+ *
+ * Sketched fields only keep their most frequent events, so they are refused.
+ * Binned fields are evaluated at the center of every bin.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @param count The number of functions.
+ * @param operations The functions of the field.
+ * @param result An array of at least `count` elements that receives E[f(x)] of every function.
+ * @returns The result array, or NULL on failure.
+ */
+NN_TYPE *probability_matrix_expected_value_of_function_batch(probability *space, char *field, size_t count,
+                                                             NN_TYPE (*operations[])(NN_TYPE), NN_TYPE *result)
+{
+    CHECK_MEMORY(space);
+    CHECK_MEMORY(result);
+
+    PROBABILITY_COLUMN(space, field) {
+        vector *events = space->events[column];
+        NN_TYPE values[PROBABILITY_BLOCK];
+
+        CHECK(!PROBABILITY_SKETCHED(space, column), "Expected value of function of sketched field %s", field);
+
+        for(size_t operation = 0; operation < count; operation++) {
+            result[operation] = 0;
+        }
+
+        for(size_t begin = 0; begin < events->length; begin += PROBABILITY_BLOCK) {
+            size_t length = events->length - begin < PROBABILITY_BLOCK ? events->length - begin : PROBABILITY_BLOCK;
+
+            for(size_t operation = 0; operation < count; operation++) {
+                for(size_t index = 0; index < length; index++) {
+                    values[index] = operations[operation](VECTOR(events, begin + index));
+                }
+
+                result[operation] += probability_weighted_sum(values, &VECTOR(space->P[column], begin), length);
+            }
+        }
+
+        return result;
+    }
+
+    sentinel("Unknown field %s", field);
+
+error:
+    return NULL;
+}
+
+/**
+ * Calculates the variance of a given field in a probability space.
+ *
+ * Variance is a measure of how spread out a set of data is. Specifically, it measures
+ * the average of the squared differences from the mean. A low variance indicates that
+ * the data points tend to be closer to the mean, while a high variance indicates that
+ * the data points are widely dispersed.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @returns The variance of the field in the probability space.
+ */
+NN_TYPE probability_variance(probability *space, char *field)
+{
+    NN_TYPE mu = probability_expected_value(space, field);
+    NN_TYPE sigma2 = 0;
+
+    PROBABILITY_COLUMN(space, field) {
+        if(PROBABILITY_SUMMARIZED(space, column)) {
+            return space->variance[column];
+        }
+    }
+
+    PROBABILITY_COLUMN(space, field) {
+        sigma2 = probability_weighted_deviation(&VECTOR(space->events[column], 0), &VECTOR(space->P[column], 0),
+                                                mu, space->events[column]->length);
+    }
+
+    return sigma2;
+}
+
+/**
+ * Calculates the covariance between two specified fields in a probability space.
+ *
+ * Covariance is a measure of how two variables change together. It measures the extent to which
+ * the variables are linearly associated. A positive covariance indicates that the two variables
+ * tend to increase or decrease together, while a negative covariance indicates that one variable
+ * tends to increase as the other decreases.
+ *
+ * The value is kept up to date by the running co-moments of the space, so
+ * reading it never rescans the samples.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the first field.
+ * @param related_field The name of the second field.
+ * @returns The covariance between the two specified fields in the probability space.
+ */
+NN_TYPE probability_covariance(probability *space, char *field, char *related_field)
+{
+    size_t field_index = probability_get_field_index(space, field);
+    size_t related_field_index = probability_get_field_index(space, related_field);
+
+    return MATRIX(space->covariance, field_index, related_field_index);
+}
+
+/**
+ * Calculates the correlation between two specified fields in a probability space.
+ *
+ * Correlation is a statistical measure that indicates the extent to which two or more variables are related.
+ * In probability theory and statistics, correlational analysis often measures the strength of a relationship between
+ * two variables, and the direction, which can be positive or negative. It ranges between -1 and 1, where 1 represents a
+ * perfect positive correlation and -1 represents a perfect negative correlation, and 0 indicates no correlation.
+ *
+ * A field whose samples are all equal has no variance, so its correlation
+ * with any field is undefined and reported as 0 rather than NaN.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the first field.
+ * @param related_field The name of the second field.
+ * @returns The correlation between the two specified fields in the probability space.
+ */
+NN_TYPE probability_correlation(probability *space, char *field, char *related_field)
+{
+    size_t field_index = probability_get_field_index(space, field);
+    size_t related_field_index = probability_get_field_index(space, related_field);
+
+    return MATRIX(space->correlation, field_index, related_field_index);
+}
+
+/**
+ * Counts the distinct values of a given field in a probability space.
+ *
+ * Sketched fields return the HyperLogLog estimate, which doesn't decrease
+ * when samples are retracted.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @returns The number of distinct values of the field that occur in the space.
+ */
+size_t probability_distinct_count(probability *space, char *field)
+{
+    size_t count = 0;
+
+    PROBABILITY_COLUMN(space, field) {
+        if(PROBABILITY_SKETCHED(space, column)) {
+            return (size_t)round(sketch_distinct(space->sketches[column]));
+        }
+
+        VECTOR_FOREACH(space->occurs[column]) {
+            count += VECTOR(space->occurs[column], index) > 0;
+        }
+    }
+
+    return count;
+}
+
+/**
+ * Gaussian kernel bandwidth of a column, by Silverman's rule of thumb.
+ */
+static NN_TYPE probability_bandwidth(probability *space, size_t column)
+{
+    NN_TYPE sigma = sqrt(space->variance[column]);
+
+    if(sigma < NN_TYPE_EPSILON) {
+        sigma = NN_TYPE_EPSILON;
+    }
+
+    return 1.06 * sigma * pow((NN_TYPE)PROBABILITY_ROWS(space), -0.2);
+}
+
+/**
+ * Sums the Gaussian kernels of the events of a column at a point, weighted by
+ * their probabilities.
+ *
+ * Kernels further than 4 bandwidths away are skipped. The events of binned
+ * columns are sorted, so only the events within that window are visited.
+ */
+static NN_TYPE probability_kernel_sum(probability *space, size_t column, NN_TYPE x, NN_TYPE h)
+{
+    vector *events = space->events[column];
+    NN_TYPE density = 0;
+    size_t begin = 0;
+
+    if(PROBABILITY_BINNED(space, column)) {
+        size_t end = events->length;
+
+        while(begin < end) {
+            size_t middle = (begin + end) / 2;
+
+            if(VECTOR(events, middle) < x - 4 * h) {
+                begin = middle + 1;
+            } else {
+                end = middle;
+            }
+        }
+    }
+
+    for(size_t index = begin; index < events->length; index++) {
+        NN_TYPE z = (x - VECTOR(events, index)) / h;
+
+        if(z < -4) {
+            if(PROBABILITY_BINNED(space, column)) {
+                break;
+            }
+            continue;
+        }
+        if(z <= 4) {
+            density += VECTOR(space->P[column], index) * exp(-z * z / 2);
+        }
+    }
+
+    return density / (h * sqrt(2 * M_PI));
+}
+
+/**
+ * Estimates the probability density of a field at a point with a Gaussian
+ * kernel density estimate over the events of the field.
+ *
+ * Every event contributes a kernel weighted by its probability, so a binned
+ * field evaluates O(bins) kernels at most, whatever the number of samples.
+ * The bandwidth follows Silverman's rule of thumb.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @param x The point at which to estimate the density.
+ * @returns The estimated density, or NAN for unknown or sketched fields.
+ */
+NN_TYPE probability_density(probability *space, char *field, NN_TYPE x)
+{
+    PROBABILITY_COLUMN(space, field) {
+        CHECK(!PROBABILITY_SKETCHED(space, column), "Density of sketched field %s", field);
+
+        return probability_kernel_sum(space, column, x, probability_bandwidth(space, column));
+    }
+
+    return NAN;
+
+error:
+    return NAN;
+}
+
+/**
+ * Calculates the probability of a field falling between two values under the
+ * kernel density estimate of probability_density().
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @param a The lower bound.
+ * @param b The upper bound.
+ * @returns The probability of the field being within [a, b], or NAN for unknown or sketched fields.
+ */
+NN_TYPE probability_density_between(probability *space, char *field, NN_TYPE a, NN_TYPE b)
+{
+    PROBABILITY_COLUMN(space, field) {
+        NN_TYPE h = probability_bandwidth(space, column);
+        NN_TYPE P = 0;
+
+        CHECK(!PROBABILITY_SKETCHED(space, column), "Density of sketched field %s", field);
+
+        VECTOR_FOREACH(space->events[column]) {
+            NN_TYPE x = VECTOR(space->events[column], index);
+
+            P += VECTOR(space->P[column], index)
+                 * (erfc((x - b) / (h * M_SQRT2)) - erfc((x - a) / (h * M_SQRT2))) / 2;
+        }
+
+        return P;
+    }
+
+    return NAN;
+
+error:
+    return NAN;
+}
+
+/**
+ * Evaluates the kernel density estimate of a field on a regular grid of
+ * points, in parallel.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @param from The first point of the grid.
+ * @param to The last point of the grid.
+ * @param result A vector with one element per grid point, receives the densities.
+ * @returns The result vector, or NULL on failure.
+ */
+vector *probability_density_grid(probability *space, char *field, NN_TYPE from, NN_TYPE to, vector *result)
+{
+    VECTOR_CHECK(result);
+
+    PROBABILITY_COLUMN(space, field) {
+        NN_TYPE h = probability_bandwidth(space, column);
+        NN_TYPE step = result->length > 1 ? (to - from) / (result->length - 1) : 0;
+
+        CHECK(!PROBABILITY_SKETCHED(space, column), "Density of sketched field %s", field);
+
+        #pragma omp parallel for
+        for(size_t index = 0; index < result->length; index++) {
+            VECTOR(result, index) = probability_kernel_sum(space, column, from + step * index, h);
+        }
+
+        return result;
+    }
+
+    sentinel("Unknown field %s", field);
+
+error:
+    return NULL;
+}
+
+/**
+ * Largest contingency table, in cells, counted densely; sparser pairs of
+ * columns are counted by sorting their pairs of events instead.
+ */
+#define PROBABILITY_CONTINGENCY_DENSE (1 << 16)
+
+/**
+ * Looks up the event index of every sample of every column in a single
+ * parallel pass over the samples, so the contingency counts of all pairs of
+ * columns share it.
+ *
+ * Sketched columns don't keep their events, their codes are left out.
+ * Samples which match no event, e.g. NaN which never equals its event, get
+ * PROBABILITY_CODE_NONE.
+ *
+ * @param space A pointer to a probability space.
+ * @returns The event indexes, column by column, or NULL on failure.
+ */
+static uint32_t *probability_codes(probability *space)
+{
+    size_t rows = PROBABILITY_ROWS(space);
+    uint32_t *codes = NULL;
+
+    codes = malloc(rows * PROBABILITY_WIDTH(space) * sizeof(uint32_t));
+    CHECK_MEMORY(codes);
+
+    #pragma omp parallel for
+    for(size_t row = 0; row < rows; row++) {
+        PROBABILITY_COLUMNS(space) {
+            NN_TYPE value = PROBABILITY_SAMPLE(space, row, column);
+            int event_index;
+
+            if(PROBABILITY_SKETCHED(space, column)) {
+                continue;
+            }
+
+            event_index = PROBABILITY_BINNED(space, column)
+                              ? probability_bin_of(space, column, value)
+                              : probability_event_find(space, column, value);
+            codes[column * rows + row] = event_index < 0 ? PROBABILITY_CODE_NONE : (uint32_t)event_index;
+        }
+    }
+
+    return codes;
+
+error:
+    return NULL;
+}
+
+/* Adds the entropy term of a count to an entropy in bits */
+#define PROBABILITY_ENTROPY_TERM(entropy, count, rows) \
+    if(count) { \
+        NN_TYPE P = (NN_TYPE)(count) / (rows); \
+        entropy -= P * log2(P); \
+    }
+
+/**
+ * Sorts the samples of a column by their event index with a counting sort,
+ * so the sparse contingency counts of every pair sharing this column reuse
+ * it. Samples which match no event come last.
+ *
+ * @param codes The event index of every sample in the column.
+ * @param events The number of events of the column.
+ * @param rows The number of samples.
+ * @returns The samples in the order of their events, or NULL on failure.
+ */
+static size_t *probability_codes_order(const uint32_t *codes, size_t events, size_t rows)
+{
+    size_t *starts = calloc(events + 2, sizeof(size_t));
+    size_t *order = malloc(rows * sizeof(size_t));
+
+    if(!starts || !order) {
+        free(starts);
+        free(order);
+        return NULL;
+    }
+
+    for(size_t row = 0; row < rows; row++) {
+        starts[(codes[row] == PROBABILITY_CODE_NONE ? events : codes[row]) + 1]++;
+    }
+    for(size_t event = 0; event < events; event++) {
+        starts[event + 1] += starts[event];
+    }
+    for(size_t row = 0; row < rows; row++) {
+        order[starts[codes[row] == PROBABILITY_CODE_NONE ? events : codes[row]]++] = row;
+    }
+
+    free(starts);
+
+    return order;
+}
+
+/**
+ * Checks if the contingency table of two columns is counted densely.
+ */
+#define PROBABILITY_CONTINGENCY_IS_DENSE(A_events, B_events) \
+    ((A_events) * (B_events) <= PROBABILITY_CONTINGENCY_DENSE)
+
+/**
+ * Calculates the joint entropy of two columns from their event indexes.
+ *
+ * Samples which match no event in either column are left out.
+ *
+ * @param A The event index of every sample in the first column.
+ * @param A_events The number of events of the first column.
+ * @param A_order The samples sorted by probability_codes_order() on the first
+ *                column, only read for sparse tables.
+ * @param B The event index of every sample in the second column.
+ * @param B_events The number of events of the second column.
+ * @param rows The number of samples.
+ * @returns The joint entropy in bits, or NAN on failure.
+ */
+static NN_TYPE probability_codes_joint_entropy(const uint32_t *A, size_t A_events, const size_t *A_order,
+                                               const uint32_t *B, size_t B_events, size_t rows)
+{
+    NN_TYPE entropy = 0;
+
+    if(PROBABILITY_CONTINGENCY_IS_DENSE(A_events, B_events)) {
+        size_t *counts = calloc(A_events * B_events, sizeof(size_t));
+
+        if(!counts) {
+            return NAN;
+        }
+
+        for(size_t row = 0; row < rows; row++) {
+            if(A[row] != PROBABILITY_CODE_NONE && B[row] != PROBABILITY_CODE_NONE) {
+                counts[A[row] * B_events + B[row]]++;
+            }
+        }
+
+        for(size_t cell = 0; cell < A_events * B_events; cell++) {
+            PROBABILITY_ENTROPY_TERM(entropy, counts[cell], rows);
+        }
+
+        free(counts);
+    } else {
+        /* Count the events of B within every run of samples sharing an event of A */
+        size_t *counts = calloc(B_events, sizeof(size_t));
+        size_t *touched = malloc(B_events * sizeof(size_t));
+        size_t size = 0;
+
+        if(!counts || !touched) {
+            free(counts);
+            free(touched);
+            return NAN;
+        }
+
+        for(size_t position = 0; position < rows; position++) {
+            size_t row = A_order[position];
+
+            if(A[row] == PROBABILITY_CODE_NONE) {
+                break;
+            }
+
+            if(B[row] != PROBABILITY_CODE_NONE && counts[B[row]]++ == 0) {
+                touched[size++] = B[row];
+            }
+
+            if(position + 1 == rows || A[A_order[position + 1]] != A[row]) {
+                for(size_t index = 0; index < size; index++) {
+                    PROBABILITY_ENTROPY_TERM(entropy, counts[touched[index]], rows);
+                    counts[touched[index]] = 0;
+                }
+                size = 0;
+            }
+        }
+
+        free(counts);
+        free(touched);
+    }
+
+    return entropy;
+}
+
+/**
+ * Calculates the entropy of a given field in a probability space, in bits.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @returns The entropy of the field, or NAN for unknown or sketched fields.
+ */
+NN_TYPE probability_entropy(probability *space, char *field)
+{
+    PROBABILITY_COLUMN(space, field) {
+        NN_TYPE entropy = 0;
+
+        CHECK(!PROBABILITY_SKETCHED(space, column), "Entropy of sketched field %s", field);
+
+        if(space->mutual_information) {
+            return MATRIX(space->mutual_information, column, column);
+        }
+
+        VECTOR_FOREACH(space->occurs[column]) {
+            PROBABILITY_ENTROPY_TERM(entropy, VECTOR(space->occurs[column], index), PROBABILITY_ROWS(space));
+        }
+
+        return entropy;
+    }
+
+    return NAN;
+
+error:
+    return NAN;
+}
+
+/**
+ * Calculates the joint entropy of two fields in a probability space, in bits.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the first field.
+ * @param related_field The name of the second field.
+ * @returns The joint entropy of the fields, or NAN on failure.
+ */
+NN_TYPE probability_joint_entropy(probability *space, char *field, char *related_field)
+{
+    size_t column = probability_get_field_index(space, field);
+    size_t related_column = probability_get_field_index(space, related_field);
+    size_t rows = PROBABILITY_ROWS(space);
+    size_t A_events = space->events[column]->length;
+    size_t B_events = space->events[related_column]->length;
+    uint32_t *codes = NULL;
+    size_t *order = NULL;
+    NN_TYPE entropy;
+
+    CHECK(!PROBABILITY_SKETCHED(space, column) && !PROBABILITY_SKETCHED(space, related_column),
+          "Joint entropy of sketched field %s or %s", field, related_field);
+
+    if(space->mutual_information) {
+        return MATRIX(space->mutual_information, column, column)
+             + MATRIX(space->mutual_information, related_column, related_column)
+             - MATRIX(space->mutual_information, column, related_column);
+    }
+
+    codes = probability_codes(space);
+    CHECK_MEMORY(codes);
+
+    if(!PROBABILITY_CONTINGENCY_IS_DENSE(A_events, B_events)) {
+        order = probability_codes_order(&codes[column * rows], A_events, rows);
+        CHECK_MEMORY(order);
+    }
+
+    entropy = probability_codes_joint_entropy(&codes[column * rows], A_events, order,
+                                              &codes[related_column * rows], B_events, rows);
+    free(codes);
+    free(order);
+
+    return entropy;
+
+error:
+    free(codes);
+
+    return NAN;
+}
+
+/**
+ * Calculates the mutual information, in bits, between every pair of fields
+ * of a probability space, e.g. to select features.
+ *
+ * The matrix is laid out like `space->correlation` and holds the entropy of
+ * every field on its diagonal. The event of every sample is looked up once
+ * for all the pairs, and the samples of a column are sorted by event once for
+ * all its sparse pairs; the pairs are then counted in parallel. The result is
+ * cached on the space until its samples change; sketched fields get NAN.
+ *
+ * @param space A pointer to a probability space.
+ * @returns The mutual information matrix, owned by the space, or NULL on failure.
+ */
+matrix *probability_mutual_information(probability *space)
+{
+    size_t rows;
+    size_t width;
+    uint32_t *codes = NULL;
+    size_t **orders = NULL;
+    matrix *information = NULL;
+
+    CHECK_MEMORY(space);
+
+    if(space->mutual_information) {
+        return space->mutual_information;
+    }
+
+    rows = PROBABILITY_ROWS(space);
+    width = PROBABILITY_WIDTH(space);
+
+    codes = probability_codes(space);
+    CHECK_MEMORY(codes);
+    orders = calloc(width, sizeof(size_t *));
+    CHECK_MEMORY(orders);
+    information = matrix_create(width, width);
+    MATRIX_CHECK(information);
+
+    /* The samples of a column are sorted once, if any of its pairs is sparse */
+    PROBABILITY_COLUMNS(space) {
+        if(PROBABILITY_SKETCHED(space, column)) {
+            continue;
+        }
+
+        for(size_t related_column = column + 1; related_column < width; related_column++) {
+            if(!PROBABILITY_SKETCHED(space, related_column)
+               && !PROBABILITY_CONTINGENCY_IS_DENSE(space->events[column]->length,
+                                                    space->events[related_column]->length)) {
+                orders[column] = probability_codes_order(&codes[column * rows],
+                                                         space->events[column]->length, rows);
+                CHECK_MEMORY(orders[column]);
+                break;
+            }
+        }
+    }
+
+    PROBABILITY_COLUMNS(space) {
+        MATRIX(information, column, column) = PROBABILITY_SKETCHED(space, column)
+                                                  ? NAN
+                                                  : probability_entropy(space, space->fields[column]);
+    }
+
+    #pragma omp parallel for schedule(dynamic)
+    for(size_t pair = 0; pair < width * width; pair++) {
+        size_t column = pair / width;
+        size_t related_column = pair % width;
+        NN_TYPE joint_entropy;
+
+        if(related_column <= column) {
+            continue;
+        }
+
+        if(PROBABILITY_SKETCHED(space, column) || PROBABILITY_SKETCHED(space, related_column)) {
+            MATRIX(information, column, related_column) = NAN;
+            MATRIX(information, related_column, column) = NAN;
+            continue;
+        }
+
+        joint_entropy = probability_codes_joint_entropy(&codes[column * rows], space->events[column]->length,
+                                                        orders[column], &codes[related_column * rows],
+                                                        space->events[related_column]->length, rows);
+
+        MATRIX(information, column, related_column) = MATRIX(information, column, column)
+                                                    + MATRIX(information, related_column, related_column)
+                                                    - joint_entropy;
+        MATRIX(information, related_column, column) = MATRIX(information, column, related_column);
+    }
+
+    PROBABILITY_COLUMNS(space) {
+        free(orders[column]);
+    }
+    free(orders);
+    free(codes);
+    space->mutual_information = information;
+
+    return information;
+
+error:
+    if(orders) {
+        PROBABILITY_COLUMNS(space) {
+            free(orders[column]);
+        }
+    }
+    free(orders);
+    free(codes);
+    if(information) {
+        number_delete(information);
+    }
+
+    return NULL;
+}
+
+/**
+ * Appends a new event to a column, with no occurrences yet.
+ *
+ * @param space A pointer to a probability space.
+ * @param column The column index of the event.
+ * @param value The value of the new event.
+ * @returns The index of the new event, or -1 on failure.
+ */
+static int probability_event_grow(probability *space, size_t column, NN_TYPE value)
+{
+    size_t length = space->events[column] ? space->events[column]->length : 0;
+
+    if(length == 0) {
+        space->events[column] = vector_create(1);
+        space->occurs[column] = vector_create(1);
+        space->P[column] = vector_create(1);
+    } else {
+        vector_reshape(space->events[column], length + 1);
+        vector_reshape(space->occurs[column], length + 1);
+        vector_reshape(space->P[column], length + 1);
+    }
+    VECTOR_CHECK(space->events[column]);
+    VECTOR_CHECK(space->occurs[column]);
+    VECTOR_CHECK(space->P[column]);
+
+    VECTOR(space->events[column], length) = value;
+    VECTOR(space->occurs[column], length) = 0;
+    vector_prefix_invalidate(space->events[column]);
+    vector_prefix_invalidate(space->occurs[column]);
+    vector_prefix_invalidate(space->P[column]);
+
+    return (int)length;
+
+error:
+    return -1;
+}
+
+/**
+ * Adds `delta` occurrences of a value to the event counters of a column.
+ *
+ * Unseen values are appended to the column's `events`, `occurs` and `P`
+ * vectors, so the events keep the order in which they were first observed,
+ * and inserted into the sorted copy that probability_event_find() bisects.
+ *
+ * @param space A pointer to a probability space.
+ * @param column The column index of the event.
+ * @param value The observed value.
+ * @param delta The number of occurrences to add (negative to retract).
+ * @returns 0 on success, 1 on failure.
+ */
+static int probability_event_count(probability *space, size_t column, NN_TYPE value, NN_TYPE delta)
+{
+    int event_index = probability_event_find(space, column, value);
+
+    if(event_index < 0) {
+        CHECK(delta > 0, "Retracted value %f was never observed", value);
+
+        event_index = probability_event_grow(space, column, value);
+        CHECK(event_index >= 0, "Event growth failed");
+        CHECK(probability_event_insert(space, column, value, (size_t)event_index) == 0,
+              "Event lookup growth failed");
+    }
+
+    VECTOR(space->occurs[column], (size_t)event_index) += delta;
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/**
+ * Adds `delta` occurrences of a value to the sketch of a column and keeps the
+ * column's `events` as its NN_SKETCH_HEAVY most frequent values.
+ *
+ * A value outside of the heavy hitters replaces the least frequent one once
+ * its estimated count is higher.
+ *
+ * @param space A pointer to a probability space.
+ * @param column The column index of the event.
+ * @param value The observed value.
+ * @param delta The number of occurrences to add (negative to retract).
+ * @returns 0 on success, 1 on failure.
+ */
+static int probability_sketch_count(probability *space, size_t column, NN_TYPE value, NN_TYPE delta)
+{
+    int event_index = -1;
+    NN_TYPE estimate;
+
+    sketch_add(space->sketches[column], value, (long)delta);
+    estimate = sketch_count(space->sketches[column], value);
+
+    if(space->events[column]) {
+        event_index = vector_index_of(space->events[column], value);
+    }
+
+    if(event_index < 0 && delta > 0) {
+        if(!space->events[column] || space->events[column]->length < NN_SKETCH_HEAVY) {
+            event_index = probability_event_grow(space, column, value);
+            CHECK(event_index >= 0, "Event growth failed");
+        } else {
+            size_t least = 0;
+
+            VECTOR_FOREACH(space->occurs[column]) {
+                if(VECTOR(space->occurs[column], index) < VECTOR(space->occurs[column], least)) {
+                    least = index;
+                }
+            }
+
+            if(estimate > VECTOR(space->occurs[column], least)) {
+                event_index = (int)least;
+                VECTOR(space->events[column], least) = value;
+            }
+        }
+    }
+
+    if(event_index >= 0) {
+        VECTOR(space->occurs[column], (size_t)event_index) = estimate;
+    }
+
+    return 0;
+
+error:
+    return 1;
+}
+
+static int probability_value_compare(const void *left, const void *right)
+{
+    NN_TYPE a = *(const NN_TYPE *)left;
+    NN_TYPE b = *(const NN_TYPE *)right;
+
+    return (a > b) - (a < b);
+}
+
+/**
+ * Sets up the bins of a column from the samples of the space.
+ *
+ * Fixed width and quantile bins get their edges and one event per bin, at
+ * the bin center. Streaming bins start empty and get their centroids as the
+ * samples are observed.
+ *
+ * @param space A pointer to a probability space, with its samples but not observed yet.
+ * @param column The column index to bin.
+ * @param binning The binning strategy.
+ * @param count The number of bins.
+ * @returns 0 on success, 1 on failure.
+ */
+static int probability_bins_create(probability *space, size_t column, enum nn_binning binning, size_t count)
+{
+    struct nn_bins *bins;
+    size_t rows = PROBABILITY_ROWS(space);
+    NN_TYPE *sorted = NULL;
+
+    bins = calloc(1, sizeof(struct nn_bins));
+    CHECK_MEMORY(bins);
+    space->bins[column] = bins;
+
+    bins->binning = binning;
+    bins->count = count;
+
+    if(binning == NN_BINNING_STREAMING) {
+        return 0;
+    }
+
+    bins->edges = vector_create(count + 1);
+    VECTOR_CHECK(bins->edges);
+
+    if(binning == NN_BINNING_WIDTH) {
+        NN_TYPE min = INFINITY;
+        NN_TYPE max = -INFINITY;
+
+        /* NaN fails both comparisons, so it never widens the range */
+        for(size_t row = 0; row < rows; row++) {
+            NN_TYPE value = PROBABILITY_SAMPLE(space, row, column);
+            min = value < min ? value : min;
+            max = value > max ? value : max;
+        }
+        if(min > max) {
+            min = max = 0;
+        }
+        if(max == min) {
+            min -= 0.5;
+            max += 0.5;
+        }
+
+        VECTOR_FOREACH(bins->edges) {
+            VECTOR(bins->edges, index) = min + (max - min) * index / count;
+        }
+    } else {
+        size_t length = 0;
+
+        sorted = malloc(rows * sizeof(NN_TYPE));
+        CHECK_MEMORY(sorted);
+        for(size_t row = 0; row < rows; row++) {
+            NN_TYPE value = PROBABILITY_SAMPLE(space, row, column);
+
+            if(!isnan(value)) {
+                sorted[length++] = value;
+            }
+        }
+        qsort(sorted, length, sizeof(NN_TYPE), probability_value_compare);
+
+        VECTOR_FOREACH(bins->edges) {
+            VECTOR(bins->edges, index) = length ? sorted[index * (length - 1) / count] : 0;
+        }
+        free(sorted);
+    }
+
+    space->events[column] = vector_create(count);
+    space->occurs[column] = vector_create(count);
+    space->P[column] = vector_create(count);
+    VECTOR_CHECK(space->events[column]);
+    VECTOR_CHECK(space->occurs[column]);
+    VECTOR_CHECK(space->P[column]);
+
+    VECTOR_FOREACH(space->events[column]) {
+        VECTOR(space->events[column], index)
+            = (VECTOR(bins->edges, index) + VECTOR(bins->edges, index + 1)) / 2;
+    }
+
+    return 0;
+
+error:
+    free(sorted);
+    return 1;
+}
+
+/**
+ * Finds the bin of a value in a binned column: the bin between the edges
+ * around the value, or the nearest centroid of a streaming histogram.
+ *
+ * @param space A pointer to a probability space.
+ * @param column The index of a binned column.
+ * @param value The value to look up.
+ * @returns The index of the bin, or -1 if the column has no bins yet.
+ */
+static int probability_bin_of(probability *space, size_t column, NN_TYPE value)
+{
+    struct nn_bins *bins = space->bins[column];
+    vector *bounds = bins->binning == NN_BINNING_STREAMING ? space->events[column] : bins->edges;
+    size_t low = 0;
+    size_t high;
+
+    if(!bounds) {
+        return -1;
+    }
+
+    /* First bound above the value */
+    high = bounds->length;
+    while(low < high) {
+        size_t middle = (low + high) / 2;
+
+        if(VECTOR(bounds, middle) <= value) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    if(bins->binning == NN_BINNING_STREAMING) {
+        if(low == bounds->length
+           || (low > 0 && value - VECTOR(bounds, low - 1) <= VECTOR(bounds, low) - value)) {
+            return (int)low - 1;
+        }
+        return (int)low;
+    }
+
+    if(low == 0) {
+        return 0;
+    }
+
+    return low > bins->count ? (int)bins->count - 1 : (int)low - 1;
 }
 
 /**
- * Calculates the variance of a given field in a probability space.
+ * Adds `delta` occurrences of a value to the bins of a column.
  *
- * Variance is a measure of how spread out a set of data is. Specifically, it measures
- * the average of the squared differences from the mean. A low variance indicates that
- * the data points tend to be closer to the mean, while a high variance indicates that
- * the data points are widely dispersed.
+ * A streaming histogram inserts the value as a new centroid, keeping the
+ * centroids sorted, and merges the two closest centroids into their weighted
+ * mean when there are more than `count` of them. Retracted values are taken
+ * from the nearest centroid.
  *
  * @param space A pointer to a probability space.
- * @param field The name of the field.
- * @returns The variance of the field in the probability space.
+ * @param column The index of a binned column.
+ * @param value The observed value.
+ * @param delta The number of occurrences to add (negative to retract).
+ * @returns 0 on success, 1 on failure.
  */
-NN_TYPE probability_variance(probability *space, char *field)
+static int probability_bin_count(probability *space, size_t column, NN_TYPE value, NN_TYPE delta)
 {
-    NN_TYPE mu = probability_expected_value(space, field);
-    NN_TYPE sigma2 = 0;
+    struct nn_bins *bins = space->bins[column];
+    int bin = probability_bin_of(space, column, value);
+    vector *events;
+    vector *occurs;
+    size_t length;
+    size_t closest;
 
-    PROBABILITY_SUM(space, field, sigma2, pow(x - mu, 2) * Px);
+    if(bins->binning != NN_BINNING_STREAMING || delta < 0) {
+        CHECK(bin >= 0, "Retracted value %f was never observed", value);
+        VECTOR(space->occurs[column], (size_t)bin) += delta;
+        if(VECTOR(space->occurs[column], (size_t)bin) < 0) {
+            VECTOR(space->occurs[column], (size_t)bin) = 0;
+        }
 
-    return sigma2;
+        return 0;
+    }
+
+    if(bin >= 0 && VECTOR(space->events[column], (size_t)bin) == value) {
+        VECTOR(space->occurs[column], (size_t)bin) += delta;
+        return 0;
+    }
+
+    /* Insert a new centroid after the centroids below the value */
+    bin = probability_event_grow(space, column, value);
+    CHECK(bin >= 0, "Event growth failed");
+    events = space->events[column];
+    occurs = space->occurs[column];
+    length = events->length;
+
+    while(bin > 0 && VECTOR(events, bin - 1) > value) {
+        VECTOR(events, bin) = VECTOR(events, bin - 1);
+        VECTOR(occurs, bin) = VECTOR(occurs, bin - 1);
+        bin--;
+    }
+    VECTOR(events, bin) = value;
+    VECTOR(occurs, bin) = delta;
+
+    if(length <= bins->count) {
+        return 0;
+    }
+
+    /* Merge the closest pair of centroids */
+    closest = 0;
+    for(size_t index = 1; index + 1 < length; index++) {
+        if(VECTOR(events, index + 1) - VECTOR(events, index)
+           < VECTOR(events, closest + 1) - VECTOR(events, closest)) {
+            closest = index;
+        }
+    }
+
+    NN_TYPE weight = VECTOR(occurs, closest) + VECTOR(occurs, closest + 1);
+    if(weight > 0) {
+        VECTOR(events, closest) = (VECTOR(events, closest) * VECTOR(occurs, closest)
+                                   + VECTOR(events, closest + 1) * VECTOR(occurs, closest + 1))
+                                  / weight;
+    }
+    VECTOR(occurs, closest) = weight;
+
+    memmove(&VECTOR(events, closest + 1), &VECTOR(events, closest + 2),
+            (length - closest - 2) * sizeof(NN_TYPE));
+    memmove(&VECTOR(occurs, closest + 1), &VECTOR(occurs, closest + 2),
+            (length - closest - 2) * sizeof(NN_TYPE));
+    vector_reshape(events, length - 1);
+    vector_reshape(occurs, length - 1);
+    vector_reshape(space->P[column], length - 1);
+
+    return 0;
+
+error:
+    return 1;
 }
 
 /**
- * Calculates the covariance between two specified fields in a probability space.
+ * Adds `delta` occurrences of a value to a column, by the sketch, the bins or
+ * the exact events of the column.
  *
- * Covariance is a measure of how two variables change together. It measures the extent to which
- * the variables are linearly associated. A positive covariance indicates that the two variables
- * tend to increase or decrease together, while a negative covariance indicates that one variable
- * tends to increase as the other decreases.
+ * @returns 0 on success, 1 on failure.
+ */
+static int probability_column_count(probability *space, size_t column, NN_TYPE value, NN_TYPE delta)
+{
+    if(PROBABILITY_SKETCHED(space, column)) {
+        return probability_sketch_count(space, column, value, delta);
+    }
+
+    if(PROBABILITY_BINNED(space, column)) {
+        return probability_bin_count(space, column, value, delta);
+    }
+
+    return probability_event_count(space, column, value, delta);
+}
+
+/**
+ * Updates the running means and co-moments with one sample (Welford).
  *
  * @param space A pointer to a probability space.
- * @param field The name of the first field.
- * @param related_field The name of the second field.
- * @returns The covariance between the two specified fields in the probability space.
+ * @param sample The values of the sample, one per column.
+ * @param count The number of samples including the new one.
  */
-NN_TYPE probability_covariance(probability *space, char *field, char *related_field)
+static void probability_moments_add(probability *space, NN_TYPE *sample, size_t count)
 {
-    char *fields[] = { field, related_field, NULL };
-    vector *origin = space->events[probability_get_field_index(space, field)];
-    vector *related = space->events[probability_get_field_index(space, related_field)];
+    size_t columns = PROBABILITY_WIDTH(space);
+    NN_TYPE delta[columns];
+
+    PROBABILITY_COLUMNS(space) {
+        delta[column] = sample[column] - space->mean[column];
+        space->mean[column] += delta[column] / count;
+    }
 
-    NN_TYPE mu_field = probability_expected_value(space, field);
-    NN_TYPE mu_related = probability_expected_value(space, related_field);
+    PROBABILITY_COLUMNS(space) {
+        for(size_t related_column = 0; related_column < columns; related_column++) {
+            MATRIX(space->comoment, column, related_column)
+                += delta[column] * (sample[related_column] - space->mean[related_column]);
+        }
+    }
+}
 
-    NN_TYPE covariance = 0;
+/**
+ * Removes one sample from the running means and co-moments, the inverse of
+ * probability_moments_add().
+ *
+ * @param space A pointer to a probability space.
+ * @param sample The values of the sample, one per column.
+ * @param count The number of samples left after the removal.
+ */
+static void probability_moments_remove(probability *space, NN_TYPE *sample, size_t count)
+{
+    size_t columns = PROBABILITY_WIDTH(space);
+    NN_TYPE delta[columns];
 
-    //#pragma omp parallel for reduction (+:covariance)
-    VECTOR_FOREACH(origin) {
-        NN_TYPE x = VECTOR(origin, index);
-        NN_TYPE y = VECTOR(related, index);
-        NN_TYPE values[] = {x, y};
-        NN_TYPE P = probability_mass_and(space, fields, values);
-        covariance += (x - mu_field) * (y - mu_related) * P;
+    PROBABILITY_COLUMNS(space) {
+        delta[column] = sample[column] - space->mean[column];
+        space->mean[column] = count ? space->mean[column] - delta[column] / count : 0;
     }
 
-    return covariance;
+    PROBABILITY_COLUMNS(space) {
+        for(size_t related_column = 0; related_column < columns; related_column++) {
+            MATRIX(space->comoment, column, related_column)
+                -= (sample[column] - space->mean[column]) * delta[related_column];
+        }
+    }
 }
 
 /**
- * Calculates the correlation between two specified fields in a probability space.
+ * Returns the values of one sample, one per field.
  *
- * Correlation is a statistical measure that indicates the extent to which two or more variables are related.
- * In probability theory and statistics, correlational analysis often measures the strength of a relationship between
- * two variables, and the direction, which can be positive or negative. It ranges between -1 and 1, where 1 represents a
- * perfect positive correlation and -1 represents a perfect negative correlation, and 0 indicates no correlation.
+ * Row-major samples are returned in place; column-major samples are gathered
+ * into `buffer`.
  *
  * @param space A pointer to a probability space.
- * @param field The name of the first field.
- * @param related_field The name of the second field.
- * @returns The correlation between the two specified fields in the probability space.
+ * @param row The index of the sample.
+ * @param buffer Storage for one value per field.
+ * @returns A pointer to the values of the sample.
  */
-NN_TYPE probability_correlation(probability *space, char *field, char *related_field)
+static NN_TYPE *probability_sample(probability *space, size_t row, NN_TYPE *buffer)
 {
-    size_t field_index = probability_get_field_index(space, field);
-    size_t related_field_index = probability_get_field_index(space, related_field);
-    NN_TYPE mu_field = space->variance[field_index];
-    NN_TYPE mu_related = space->variance[related_field_index];
+    if(space->layout == NN_ROW_MAJOR) {
+        return &MATRIX(space->samples, space->first + row, 0);
+    }
 
-    NN_TYPE correlation = MATRIX(space->covariance, field_index, related_field_index) / sqrt(mu_field * mu_related);
+    PROBABILITY_COLUMNS(space) {
+        buffer[column] = PROBABILITY_SAMPLE(space, row, column);
+    }
 
-    return correlation;
+    return buffer;
 }
 
-probability*
-probability_space_variance(probability *space) {
-    PROBABILITY_COLUMNS(space) {
-        number *rows = number_create((NN_TYPE)space->samples->rows);
-        space->P[column] = vector_division(vector_clone(space->occurs[column]),
-                                          rows);
+/**
+ * Feeds the sample rows [from_row, to_row) of the space into the event
+ * counters and the running moments.
+ *
+ * @param space A pointer to a probability space.
+ * @param from_row The first row to observe; all rows before it are already observed.
+ * @param to_row The row after the last one to observe.
+ * @returns The same probability space, or NULL on failure.
+ */
+static probability *probability_space_observe(probability *space, size_t from_row, size_t to_row) {
+    NN_TYPE gathered[PROBABILITY_WIDTH(space)];
+
+    for(size_t row = from_row; row < to_row; row++) {
+        NN_TYPE *sample = probability_sample(space, row, gathered);
 
-        space->variance[column] = probability_variance(space, space->fields[column]);
+        PROBABILITY_COLUMNS(space) {
+            CHECK(probability_column_count(space, column, sample[column], 1) == 0,
+                  "Event counting failed at row %zu", row);
+        }
 
-        number_delete(rows);
+        probability_moments_add(space, sample, row + 1);
     }
 
     return space;
+
+error:
+    return NULL;
 }
 
-probability *probability_space_covariance(probability *space) {
-    PROBABILITY_COLUMNS(space) {
-        for(size_t related_column = 0; related_column <= column; related_column++) {
-            NN_TYPE covariation = probability_covariance(space, space->fields[column], space->fields[related_column]);;
+/**
+ * Removes the oldest `count` samples of the space from the event counters
+ * and the running moments, the inverse of probability_space_observe().
+ *
+ * @param space A pointer to a probability space.
+ * @param count The number of oldest rows to forget.
+ * @returns The same probability space, or NULL on failure.
+ */
+static probability *probability_space_forget(probability *space, size_t count) {
+    NN_TYPE gathered[PROBABILITY_WIDTH(space)];
+    size_t rows = PROBABILITY_ROWS(space);
 
-            MATRIX(space->covariance, column, related_column) = covariation;
-            MATRIX(space->covariance, related_column, column) = covariation;
+    for(size_t row = 0; row < count; row++) {
+        NN_TYPE *sample = probability_sample(space, row, gathered);
+
+        PROBABILITY_COLUMNS(space) {
+            CHECK(probability_column_count(space, column, sample[column], -1) == 0,
+                  "Event retraction failed at row %zu", row);
         }
+
+        probability_moments_remove(space, sample, rows - row - 1);
     }
 
     return space;
+
+error:
+    return NULL;
 }
 
-probability *probability_space_correlation(probability *space) {
+/**
+ * Recomputes the derived properties (`P`, `variance`, `covariance` and
+ * `correlation`) from the event counters and the running co-moments.
+ *
+ * The cost depends on the number of events and columns only, never on the
+ * number of samples seen so far. Cached masses are dropped.
+ *
+ * @param space A pointer to a probability space.
+ * @returns The same probability space.
+ */
+static probability *probability_space_normalize(probability *space) {
+    NN_TYPE rows = (NN_TYPE)PROBABILITY_ROWS(space);
+
+    probability_cache_clear(space);
+
+    if(space->mutual_information) {
+        number_delete(space->mutual_information);
+        space->mutual_information = NULL;
+    }
+
+    PROBABILITY_COLUMNS(space) {
+        /* Every update ends here, after writing the events and counters in place */
+        vector_prefix_invalidate(space->events[column]);
+        vector_prefix_invalidate(space->occurs[column]);
+        vector_prefix_invalidate(space->P[column]);
+
+        VECTOR_FOREACH(space->occurs[column]) {
+            VECTOR(space->P[column], index) = VECTOR(space->occurs[column], index) / rows;
+        }
+
+        space->variance[column] = MATRIX(space->comoment, column, column) / rows;
+    }
+
     PROBABILITY_COLUMNS(space) {
-        for(size_t related_column = 0; related_column <= column; related_column++) {
-            NN_TYPE correlation = probability_correlation(space, space->fields[column], space->fields[related_column]);
-            MATRIX(space->correlation, column, related_column) = correlation;
-            MATRIX(space->correlation, related_column, column) = correlation;
+        for(size_t related_column = 0; related_column < PROBABILITY_WIDTH(space); related_column++) {
+            NN_TYPE covariance = MATRIX(space->comoment, column, related_column) / rows;
+            NN_TYPE deviations = sqrt(space->variance[column] * space->variance[related_column]);
+
+            MATRIX(space->covariance, column, related_column) = covariance;
+            /* A constant field has no correlation, rather than NaN */
+            MATRIX(space->correlation, column, related_column)
+                = deviations > 0 ? covariance / deviations : 0;
         }
     }
 
@@ -401,29 +2797,323 @@ probability *probability_space_correlation(probability *space) {
  * @returns A pointer to the modified probability space.
  */
 probability *probability_space_populate(probability *space) {
-    matrix *samples = space->samples;
+    CHECK_MEMORY(probability_space_observe(space, 0, PROBABILITY_ROWS(space)));
 
-    PROBABILITY_COLUMNS(space) {
-        vector *column_data = matrix_column_vector(samples, column);
-        VECTOR_CHECK(column_data);
-        space->events[column] = vector_unique(column_data);
-        VECTOR_CHECK(space->events[column]);
-        space->occurs[column] = vector_create(space->events[column]->length);
-        VECTOR_CHECK(space->occurs[column]);
+    return probability_space_normalize(space);
 
-        number_delete(column_data);
-    }
+error:
+    return NULL;
+}
+
+/**
+ * Moves the samples of the window to the front of the samples matrix,
+ * dropping the retracted samples which are still stored before it.
+ *
+ * @param space A pointer to a probability space.
+ * @returns The same probability space, or NULL on failure.
+ */
+static probability *probability_compact(probability *space) {
+    size_t rows = PROBABILITY_ROWS(space);
+    size_t stored = rows + space->first;
+    NN_TYPE *values = (NN_TYPE *)((vector *)space->samples->number.values)->number.values;
 
-    probability_count_events(space);
+    if(space->first == 0) {
+        return space;
+    }
 
-    probability_space_correlation(
-        probability_space_covariance(
-            probability_space_variance(space)
-        )
-    );
+    if(space->layout == NN_ROW_MAJOR) {
+        memmove(values, &MATRIX(space->samples, space->first, 0),
+                rows * space->samples->columns * sizeof(NN_TYPE));
+        space->first = 0;
+        CHECK_MEMORY(matrix_reshape(space->samples, rows, space->samples->columns));
+    } else {
+        /* Pack the remaining samples of each field, from the first one */
+        PROBABILITY_COLUMNS(space) {
+            memmove(values + column * rows, values + column * stored + space->first,
+                    rows * sizeof(NN_TYPE));
+        }
+        space->first = 0;
+        CHECK_MEMORY(matrix_reshape(space->samples, space->samples->rows, rows));
+    }
 
     return space;
 
 error:
     return NULL;
 }
+
+/**
+ * Appends a batch of samples to a probability space.
+ *
+ * Event counts, `P`, variance (Welford) and covariance (co-moment updates)
+ * are updated from the new rows only, so the cost is O(batch) regardless of
+ * how many samples the space already holds. Column-major samples are
+ * compacted and spread to the new length first.
+ *
+ * @param space A pointer to a probability space.
+ * @param rows A matrix with the new samples, with the same columns as the space.
+ * @returns The same probability space, or NULL on failure.
+ */
+probability *probability_append(probability *space, matrix *rows) {
+    size_t history;
+
+    CHECK_MEMORY(space);
+    MATRIX_CHECK(rows);
+    CHECK(rows->columns == PROBABILITY_WIDTH(space),
+          "Appended rows have %zu columns, space has %zu", rows->columns, PROBABILITY_WIDTH(space));
+
+    history = PROBABILITY_ROWS(space);
+    if(space->layout == NN_ROW_MAJOR) {
+        size_t stored = space->first + history;
+
+        CHECK_MEMORY(matrix_reshape(space->samples, stored + rows->rows, rows->columns));
+        memcpy(&MATRIX(space->samples, stored, 0), &MATRIX(rows, 0, 0),
+               rows->rows * rows->columns * sizeof(NN_TYPE));
+    } else {
+        CHECK_MEMORY(probability_compact(space));
+        CHECK_MEMORY(matrix_reshape(space->samples, rows->columns, history + rows->rows));
+
+        /* Spread the fields from the last one, so none is overwritten */
+        for(size_t column = rows->columns; column-- > 0;) {
+            memmove(&MATRIX(space->samples, column, 0),
+                    (NN_TYPE *)((vector *)space->samples->number.values)->number.values + column * history,
+                    history * sizeof(NN_TYPE));
+            for(size_t row = 0; row < rows->rows; row++) {
+                MATRIX(space->samples, column, history + row) = MATRIX(rows, row, column);
+            }
+        }
+    }
+
+    CHECK_MEMORY(probability_space_observe(space, history, PROBABILITY_ROWS(space)));
+
+    return probability_space_normalize(space);
+
+error:
+    return NULL;
+}
+
+/**
+ * Retracts the oldest samples from a probability space, e.g. to keep a
+ * sliding window over a stream of samples.
+ *
+ * The statistics are downdated from the retracted rows only. The retracted
+ * samples are skipped by an offset into the samples matrix, which is only
+ * compacted once they outnumber the remaining ones, so the cost is O(batch)
+ * amortized whatever the size of the window. Until then the samples matrix
+ * still stores them before the window. Events whose count drops to zero are
+ * kept with a probability of 0.
+ *
+ * @param space A pointer to a probability space.
+ * @param count The number of oldest rows to retract; at least one row must remain.
+ * @returns The same probability space, or NULL on failure.
+ */
+probability *probability_retract(probability *space, size_t count) {
+    CHECK_MEMORY(space);
+    CHECK(count < PROBABILITY_ROWS(space),
+          "Can't retract %zu of %zu samples", count, PROBABILITY_ROWS(space));
+
+    CHECK_MEMORY(probability_space_forget(space, count));
+
+    space->first += count;
+    if(space->first >= PROBABILITY_ROWS(space)) {
+        CHECK_MEMORY(probability_compact(space));
+    }
+
+    return probability_space_normalize(space);
+
+error:
+    return NULL;
+}
+
+/**
+ * Builds an alias table sampler (Vose) from the distribution of a field, so
+ * every draw costs one uniform number and one table lookup, whatever the
+ * number of events.
+ *
+ * The sampler keeps a copy of the events and probabilities, later updates
+ * of the space don't affect it. A sketched field keeps only its heavy
+ * hitters, whose probabilities don't sum to 1, so it can't be sampled.
+ *
+ * @param space A pointer to a probability space.
+ * @param field The name of the field.
+ * @returns A pointer to the new sampler, or NULL on failure.
+ */
+probability_sampler *probability_sampler_create(probability *space, char *field)
+{
+    probability_sampler *sampler = NULL;
+    size_t *small = NULL;
+    size_t *large = NULL;
+
+    CHECK_MEMORY(space);
+
+    PROBABILITY_COLUMN(space, field) {
+        size_t length = space->events[column]->length;
+        size_t small_count = 0;
+        size_t large_count = 0;
+
+        CHECK(!PROBABILITY_SKETCHED(space, column), "Can't sample sketched field %s", field);
+        CHECK(length, "Field %s has no events to sample", field);
+
+        sampler = calloc(1, sizeof(probability_sampler));
+        CHECK_MEMORY(sampler);
+        sampler->length = length;
+        sampler->events = vector_clone(space->events[column]);
+        VECTOR_CHECK(sampler->events);
+        sampler->threshold = vector_create(length);
+        VECTOR_CHECK(sampler->threshold);
+        sampler->alias = malloc(length * sizeof(size_t));
+        CHECK_MEMORY(sampler->alias);
+
+        small = malloc(length * sizeof(size_t));
+        CHECK_MEMORY(small);
+        large = malloc(length * sizeof(size_t));
+        CHECK_MEMORY(large);
+
+        /* Scaled probabilities, 1 is the average event */
+        VECTOR_FOREACH(space->P[column]) {
+            VECTOR(sampler->threshold, index) = VECTOR(space->P[column], index) * length;
+            sampler->alias[index] = index;
+
+            if(VECTOR(sampler->threshold, index) < 1) {
+                small[small_count++] = index;
+            } else {
+                large[large_count++] = index;
+            }
+        }
+
+        /* Every small event is topped up by a large one */
+        while(small_count && large_count) {
+            size_t less = small[--small_count];
+            size_t more = large[large_count - 1];
+
+            sampler->alias[less] = more;
+            VECTOR(sampler->threshold, more) -= 1 - VECTOR(sampler->threshold, less);
+
+            if(VECTOR(sampler->threshold, more) < 1) {
+                large_count--;
+                small[small_count++] = more;
+            }
+        }
+
+        /* Rounding leftovers are full */
+        while(large_count) {
+            VECTOR(sampler->threshold, large[--large_count]) = 1;
+        }
+        while(small_count) {
+            VECTOR(sampler->threshold, small[--small_count]) = 1;
+        }
+
+        free(small);
+        free(large);
+
+        return sampler;
+    }
+
+    sentinel("Unknown field %s", field);
+
+error:
+    free(small);
+    free(large);
+    probability_sampler_delete(sampler);
+
+    return NULL;
+}
+
+void probability_sampler_delete(probability_sampler *sampler)
+{
+    if(!sampler) {
+        return;
+    }
+
+    if(sampler->events) {
+        number_delete(sampler->events);
+    }
+    if(sampler->threshold) {
+        number_delete(sampler->threshold);
+    }
+    free(sampler->alias);
+    free(sampler);
+}
+
+/**
+ * Draws events from a sampler into every element of a vector.
+ *
+ * Every draw takes 64 random bits and multiplies them by the number of
+ * slots (multiply-shift, as random_below()): the high word picks the slot of
+ * the alias table and the low word is the exact fraction that chooses
+ * between the slot's event and its alias, without branches, so tables with
+ * more than 2^24 events are drawn evenly. The vector is split in blocks of
+ * NN_RANDOM_BLOCK draws, each from its own stream.
+ *
+ * @param sampler A pointer to a sampler.
+ * @param result The vector that receives the draws.
+ * @returns The result vector, or NULL on failure.
+ */
+vector *probability_sampler_draw(probability_sampler *sampler, vector *result)
+{
+    uint64_t seed;
+    size_t blocks;
+
+    CHECK_MEMORY(sampler);
+    VECTOR_CHECK(result);
+
+    seed = random_next(random_thread());
+    blocks = (result->length + NN_RANDOM_BLOCK - 1) / NN_RANDOM_BLOCK;
+
+    #pragma omp parallel for
+    for(size_t block = 0; block < blocks; block++) {
+        size_t begin = block * NN_RANDOM_BLOCK;
+        size_t end = begin + NN_RANDOM_BLOCK < result->length ? begin + NN_RANDOM_BLOCK : result->length;
+        struct nn_random generator;
+
+        random_seed(&generator, seed ^ (block * 0xD1B54A32D192ED03ULL));
+
+        for(size_t index = begin; index < end; index++) {
+            unsigned __int128 scaled = (unsigned __int128)random_next(&generator) * sampler->length;
+            size_t slot = (size_t)(scaled >> 64);
+            double fraction = (double)(uint64_t)scaled * 0x1p-64;
+
+            slot = fraction < VECTOR(sampler->threshold, slot) ? slot : sampler->alias[slot];
+            VECTOR(result, index) = VECTOR(sampler->events, slot);
+        }
+    }
+
+    return result;
+
+error:
+    return NULL;
+}
+
+/**
+ * Draws samples from the joint distribution of a probability space, by
+ * picking stored samples uniformly, into every row of a matrix.
+ *
+ * @param space A pointer to a probability space.
+ * @param result A matrix with one column per field that receives one drawn sample per row.
+ * @returns The result matrix, or NULL on failure.
+ */
+matrix *probability_draw_samples(probability *space, matrix *result)
+{
+    size_t rows;
+
+    CHECK_MEMORY(space);
+    MATRIX_CHECK(result);
+    CHECK(result->columns == PROBABILITY_WIDTH(space),
+          "Result has %zu columns, space has %zu fields", result->columns, PROBABILITY_WIDTH(space));
+
+    rows = PROBABILITY_ROWS(space);
+
+    for(size_t row = 0; row < result->rows; row++) {
+        /* Multiply-shift maps 64 random bits to [0, rows) */
+        size_t sample = (size_t)(((unsigned __int128)random_next(random_thread()) * rows) >> 64);
+
+        PROBABILITY_COLUMNS(space) {
+            MATRIX(result, row, column) = PROBABILITY_SAMPLE(space, sample, column);
+        }
+    }
+
+    return result;
+
+error:
+    return NULL;
+}
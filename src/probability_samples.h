@@ -0,0 +1,37 @@
+#pragma once
+
+#include "probability.h"
+
+/* Access to the samples of a probability space, shared by the sources of the
+ * probability library */
+
+/**
+ * Number of samples held by a probability space, whatever the layout of its
+ * samples matrix. Retracted samples which aren't compacted yet don't count.
+ *
+ * @param space A pointer to a probability space
+ */
+#define PROBABILITY_ROWS(space) \
+    (((space)->layout == NN_COLUMN_MAJOR ? (space)->samples->columns : (space)->samples->rows) \
+     - (space)->first)
+
+/**
+ * Number of fields of a probability space, whatever the layout of its
+ * samples matrix.
+ *
+ * @param space A pointer to a probability space
+ */
+#define PROBABILITY_WIDTH(space) \
+    ((space)->layout == NN_COLUMN_MAJOR ? (space)->samples->rows : (space)->samples->columns)
+
+/**
+ * Accesses the value of a field in a sample of a probability space.
+ *
+ * @param space A pointer to a probability space
+ * @param row The index of the sample
+ * @param column The index of the field
+ */
+#define PROBABILITY_SAMPLE(space, row, column) \
+    (*((space)->layout == NN_COLUMN_MAJOR \
+        ? &MATRIX((space)->samples, column, (space)->first + (row)) \
+        : &MATRIX((space)->samples, (space)->first + (row), column)))
@@ -0,0 +1,440 @@
+#include "random.h"
+
+#include <math.h>
+#include <stdatomic.h>
+#include <string.h>
+
+/* Four 32 bit lanes, one xoshiro128+ stream per lane */
+typedef uint32_t v4su __attribute__((vector_size(16)));
+typedef float    v4f __attribute__((vector_size(16)));
+
+static atomic_ullong random_global_seed = 0x853C49E6748FEA9BULL;
+static atomic_ullong random_generation  = 1;
+static atomic_ullong random_streams     = 0;
+
+static _Thread_local struct nn_random random_thread_generator;
+static _Thread_local unsigned long long random_thread_generation = 0;
+
+static inline uint64_t random_rotl(uint64_t x, int k)
+{
+    return (x << k) | (x >> (64 - k));
+}
+
+/**
+ * Advances a splitmix64 state, used to expand seeds into generator states.
+ */
+static inline uint64_t random_splitmix(uint64_t *state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+    return z ^ (z >> 31);
+}
+
+/**
+ * Seeds a generator, expanding the seed with splitmix64 so that close seeds
+ * give unrelated streams.
+ *
+ * @param generator A pointer to the generator.
+ * @param seed The seed.
+ */
+void random_seed(struct nn_random *generator, uint64_t seed)
+{
+    for (size_t index = 0; index < 4; index++) {
+        generator->state[index] = random_splitmix(&seed);
+    }
+}
+
+/**
+ * Draws the next 64 random bits of a generator (xoshiro256+).
+ *
+ * @param generator A pointer to the generator.
+ * @return The random bits; the upper ones are the strongest.
+ */
+uint64_t random_next(struct nn_random *generator)
+{
+    uint64_t *s      = generator->state;
+    uint64_t  result = s[0] + s[3];
+    uint64_t  t      = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = random_rotl(s[3], 45);
+
+    return result;
+}
+
+/**
+ * Advances a generator by 2^128 draws, so a generator can be split into
+ * non-overlapping streams: seed one, then jump it once per stream.
+ *
+ * @param generator A pointer to the generator.
+ */
+void random_jump(struct nn_random *generator)
+{
+    static const uint64_t jump[] = {0x180EC6D33CFD0ABAULL, 0xD5A61266F0C9392CULL,
+                                    0xA9582618E03FC9AAULL, 0x39ABDC4529B1661CULL};
+    uint64_t state[4] = {0};
+
+    for (size_t word = 0; word < 4; word++) {
+        for (int bit = 0; bit < 64; bit++) {
+            if (jump[word] & (1ULL << bit)) {
+                for (size_t index = 0; index < 4; index++) {
+                    state[index] ^= generator->state[index];
+                }
+            }
+            random_next(generator);
+        }
+    }
+
+    for (size_t index = 0; index < 4; index++) {
+        generator->state[index] = state[index];
+    }
+}
+
+/**
+ * Keeps a scaled uniform number below `max`, which rounding can reach when
+ * max - min isn't a power of two.
+ */
+static inline NN_TYPE random_clamp(NN_TYPE value, NN_TYPE min, NN_TYPE max)
+{
+    return value < max ? value : nextafterf(max, min);
+}
+
+/**
+ * Draws a uniform number in [min, max).
+ */
+NN_TYPE random_uniform(struct nn_random *generator, NN_TYPE min, NN_TYPE max)
+{
+    /* 24 bits fill the mantissa of a float exactly, so 1 is never reached */
+    NN_TYPE unit = (NN_TYPE)(random_next(generator) >> 40) * (1.0f / 16777216.0f);
+
+    return random_clamp(min + (max - min) * unit, min, max);
+}
+
+/**
+ * Draws a normal number (Box-Muller).
+ */
+NN_TYPE random_normal(struct nn_random *generator, NN_TYPE mean, NN_TYPE deviation)
+{
+    NN_TYPE u = random_uniform(generator, 0, 1);
+    NN_TYPE v = random_uniform(generator, 0, 1);
+
+    return mean + deviation * sqrt(-2 * log(1 - u)) * cos(2 * M_PI * v);
+}
+
+/**
+ * Returns the generator of the calling thread.
+ *
+ * Every thread draws from its own stream, without locks; the streams are
+ * numbered in the order the threads first draw, and every stream is seeded
+ * in constant time from the global seed mixed with its number.
+ * random_seed_global() restarts all of them.
+ *
+ * @return The generator of the calling thread.
+ */
+struct nn_random *random_thread(void)
+{
+    unsigned long long generation = atomic_load(&random_generation);
+
+    if (random_thread_generation != generation) {
+        uint64_t stream = atomic_fetch_add(&random_streams, 1);
+        uint64_t key    = atomic_load(&random_global_seed) ^ (stream * 0xD1B54A32D192ED03ULL);
+
+        random_seed(&random_thread_generator, random_splitmix(&key));
+        random_thread_generation = generation;
+    }
+
+    return &random_thread_generator;
+}
+
+/**
+ * Reseeds the generators of all threads, e.g. for reproducible runs.
+ *
+ * @param seed The seed.
+ */
+void random_seed_global(uint64_t seed)
+{
+    atomic_store(&random_global_seed, seed);
+    atomic_store(&random_streams, 0);
+    atomic_fetch_add(&random_generation, 1);
+}
+
+/**
+ * Seeds four xoshiro128+ lanes for a block of a bulk fill.
+ */
+static void random_lanes_seed(v4su state[4], uint64_t seed, uint64_t block)
+{
+    uint64_t mix = seed ^ (block * 0xD1B54A32D192ED03ULL);
+
+    /* Every vector is built whole, so no lane is read before it is set */
+    for (size_t word = 0; word < 4; word++) {
+        uint32_t lanes[4];
+
+        for (size_t lane = 0; lane < 4; lane++) {
+            lanes[lane] = (uint32_t)(random_splitmix(&mix) >> 32);
+        }
+        state[word] = (v4su){ lanes[0], lanes[1], lanes[2], lanes[3] };
+    }
+}
+
+/**
+ * Draws four uniform numbers in [0, 1) from four xoshiro128+ lanes.
+ */
+static inline v4f random_lanes_next(v4su s[4])
+{
+    v4su result = s[0] + s[3];
+    v4su t      = s[1] << 9;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = (s[3] << 11) | (s[3] >> 21);
+
+    return __builtin_convertvector(result >> 8, v4f) * (1.0f / 16777216.0f);
+}
+
+/**
+ * Fills an array with uniform numbers in [min, max), in parallel.
+ *
+ * The array is split in blocks of NN_RANDOM_BLOCK values, each generated by
+ * its own stream keyed by the seed and the block index, so the result only
+ * depends on the seed, never on the number of threads.
+ *
+ * @param values The array to fill.
+ * @param length The number of values.
+ * @param min The lower bound.
+ * @param max The upper bound, excluded.
+ * @param seed The seed of the fill.
+ * @return The array.
+ */
+NN_TYPE *random_fill_uniform(NN_TYPE *values, size_t length, NN_TYPE min, NN_TYPE max, uint64_t seed)
+{
+    size_t blocks = (length + NN_RANDOM_BLOCK - 1) / NN_RANDOM_BLOCK;
+
+    #pragma omp parallel for
+    for (size_t block = 0; block < blocks; block++) {
+        size_t begin = block * NN_RANDOM_BLOCK;
+        size_t end   = begin + NN_RANDOM_BLOCK < length ? begin + NN_RANDOM_BLOCK : length;
+        v4su   state[4];
+
+        random_lanes_seed(state, seed, block);
+
+        for (size_t index = begin; index < end; index += 4) {
+            v4f unit = random_lanes_next(state);
+
+            for (size_t lane = 0; lane < 4 && index + lane < end; lane++) {
+                values[index + lane] = random_clamp(min + (max - min) * unit[lane], min, max);
+            }
+        }
+    }
+
+    return values;
+}
+
+/**
+ * Fills an array with normal numbers (Box-Muller), in parallel.
+ *
+ * Like random_fill_uniform(), the result only depends on the seed.
+ *
+ * @param values The array to fill.
+ * @param length The number of values.
+ * @param mean The mean of the numbers.
+ * @param deviation The standard deviation of the numbers.
+ * @param seed The seed of the fill.
+ * @return The array.
+ */
+NN_TYPE *random_fill_normal(NN_TYPE *values, size_t length, NN_TYPE mean, NN_TYPE deviation, uint64_t seed)
+{
+    size_t blocks = (length + NN_RANDOM_BLOCK - 1) / NN_RANDOM_BLOCK;
+
+    #pragma omp parallel for
+    for (size_t block = 0; block < blocks; block++) {
+        size_t begin = block * NN_RANDOM_BLOCK;
+        size_t end   = begin + NN_RANDOM_BLOCK < length ? begin + NN_RANDOM_BLOCK : length;
+        v4su   state[4];
+
+        random_lanes_seed(state, seed, block);
+
+        /* Every pair of uniform draws gives a pair of normal numbers */
+        for (size_t index = begin; index < end; index += 8) {
+            v4f u = random_lanes_next(state);
+            v4f v = random_lanes_next(state);
+            NN_TYPE normal[8];
+
+            #pragma omp simd
+            for (size_t lane = 0; lane < 4; lane++) {
+                NN_TYPE radius = sqrtf(-2 * logf(1 - u[lane]));
+                NN_TYPE angle  = 2 * (NN_TYPE)M_PI * v[lane];
+
+                normal[lane]     = radius * cosf(angle);
+                normal[lane + 4] = radius * sinf(angle);
+            }
+
+            for (size_t lane = 0; lane < 8 && index + lane < end; lane++) {
+                values[index + lane] = mean + deviation * normal[lane];
+            }
+        }
+    }
+
+    return values;
+}
+
+/**
+ * Draws an unbiased integer in [0, bound) (Lemire's multiply-shift with
+ * rejection).
+ *
+ * @param generator A pointer to the generator.
+ * @param bound The number of possible values, greater than zero.
+ * @return The random integer.
+ */
+uint64_t random_below(struct nn_random *generator, uint64_t bound)
+{
+    unsigned __int128 product = (unsigned __int128)random_next(generator) * bound;
+    uint64_t          low     = (uint64_t)product;
+
+    if (low < bound) {
+        uint64_t threshold = -bound % bound;
+
+        while (low < threshold) {
+            product = (unsigned __int128)random_next(generator) * bound;
+            low     = (uint64_t)product;
+        }
+    }
+
+    return (uint64_t)(product >> 64);
+}
+
+/* Swaps two elements of `size` bytes */
+static inline void random_swap(char *values, size_t size, size_t a, size_t b)
+{
+    char swapped[size];
+
+    memcpy(swapped, values + a * size, size);
+    memcpy(values + a * size, values + b * size, size);
+    memcpy(values + b * size, swapped, size);
+}
+
+/* Fisher-Yates shuffle of the elements [begin, end) */
+static void random_shuffle_block(struct nn_random *generator, char *values, size_t size, size_t begin,
+                                 size_t end)
+{
+    for (size_t index = end - 1; index > begin; index--) {
+        random_swap(values, size, index, begin + random_below(generator, index - begin + 1));
+    }
+}
+
+/**
+ * Merges two shuffled neighbouring blocks [begin, middle) and [middle, end)
+ * into one shuffled block (MergeShuffle, Bacher et al.).
+ */
+static void random_shuffle_merge(struct nn_random *generator, char *values, size_t size, size_t begin,
+                                 size_t middle, size_t end)
+{
+    size_t   index = begin;
+    uint64_t bits  = 0;
+    size_t   left  = 0;
+
+    /* Interleave the blocks with coin flips until one of them runs out */
+    for (;;) {
+        if (!left) {
+            bits = random_next(generator);
+            left = 64;
+        }
+        left--;
+
+        if (bits & 1) {
+            if (middle == end) {
+                break;
+            }
+            random_swap(values, size, index, middle++);
+        } else if (index == middle) {
+            break;
+        }
+
+        bits >>= 1;
+        index++;
+    }
+
+    /* Insert what is left at random positions */
+    for (; index < end; index++) {
+        random_swap(values, size, index, begin + random_below(generator, index - begin + 1));
+    }
+}
+
+/**
+ * Shuffles an array in place, every permutation being equally likely.
+ *
+ * Small arrays get a Fisher-Yates shuffle. Arrays longer than
+ * NN_RANDOM_SHUFFLE_BLOCK are cut in a power of two of blocks, shuffled in
+ * parallel, then merged pairwise in parallel (MergeShuffle). Every block and
+ * merge has its own stream keyed by the seed, so the result only depends on
+ * the seed.
+ *
+ * @param values The array to shuffle.
+ * @param length The number of elements.
+ * @param size The size of an element in bytes.
+ * @param seed The seed of the shuffle.
+ * @return The array.
+ */
+void *random_shuffle(void *values, size_t length, size_t size, uint64_t seed)
+{
+    size_t blocks = 1;
+
+    if (length < 2) {
+        return values;
+    }
+
+    while (length / blocks > NN_RANDOM_SHUFFLE_BLOCK) {
+        blocks *= 2;
+    }
+
+    #pragma omp parallel for
+    for (size_t block = 0; block < blocks; block++) {
+        struct nn_random generator;
+
+        random_seed(&generator, seed ^ (block * 0xD1B54A32D192ED03ULL));
+        random_shuffle_block(&generator, values, size, length * block / blocks,
+                             length * (block + 1) / blocks);
+    }
+
+    for (size_t width = 1; width < blocks; width *= 2) {
+        #pragma omp parallel for
+        for (size_t block = 0; block < blocks; block += 2 * width) {
+            struct nn_random generator;
+
+            random_seed(&generator, ~seed ^ ((blocks * width + block) * 0xD1B54A32D192ED03ULL));
+            random_shuffle_merge(&generator, values, size, length * block / blocks,
+                                 length * (block + width) / blocks,
+                                 length * (block + 2 * width) / blocks);
+        }
+    }
+
+    return values;
+}
+
+/**
+ * Fills an array with a random permutation of 0 .. length - 1, e.g. to
+ * shuffle the rows of several matrices the same way.
+ *
+ * @param indexes The array to fill.
+ * @param length The number of indexes.
+ * @param seed The seed of the permutation.
+ * @return The array.
+ */
+size_t *random_permutation(size_t *indexes, size_t length, uint64_t seed)
+{
+    #pragma omp parallel for
+    for (size_t index = 0; index < length; index++) {
+        indexes[index] = index;
+    }
+
+    return random_shuffle(indexes, length, sizeof(size_t), seed);
+}
@@ -0,0 +1,154 @@
+#include "sketch.h"
+
+#include "util/error.h"
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+
+/**
+ * Hashes a value with a seed (splitmix64 finalizer).
+ *
+ * Both zeroes hash the same, as they compare equal.
+ */
+static uint64_t sketch_hash(NN_TYPE value, uint64_t seed)
+{
+    uint64_t hash = 0;
+
+    value = value + (NN_TYPE)0;
+    memcpy(&hash, &value, sizeof(NN_TYPE));
+
+    hash += seed * 0x9E3779B97F4A7C15ULL + 0x9E3779B97F4A7C15ULL;
+    hash = (hash ^ (hash >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    hash = (hash ^ (hash >> 27)) * 0x94D049BB133111EBULL;
+
+    return hash ^ (hash >> 31);
+}
+
+/**
+ * Creates a sketch with a Count-Min table and HyperLogLog registers.
+ *
+ * @param width The number of counters per Count-Min row.
+ * @param depth The number of Count-Min rows.
+ * @param precision The number of HyperLogLog index bits (4..18).
+ * @return A pointer to the new sketch, or NULL on failure.
+ */
+sketch *sketch_create(size_t width, size_t depth, size_t precision)
+{
+    sketch *instance = NULL;
+
+    CHECK(width && depth, "Sketch size should be greater than zero");
+    CHECK(precision >= 4 && precision <= 18, "Wrong HyperLogLog precision %zu",
+          precision);
+
+    instance = calloc(1, sizeof(sketch));
+    CHECK_MEMORY(instance);
+
+    instance->width     = width;
+    instance->depth     = depth;
+    instance->precision = precision;
+
+    instance->counts = calloc(width * depth, sizeof(long));
+    CHECK_MEMORY(instance->counts);
+    instance->registers = calloc((size_t)1 << precision, 1);
+    CHECK_MEMORY(instance->registers);
+
+    return instance;
+
+error:
+    sketch_delete(instance);
+    return NULL;
+}
+
+void sketch_delete(sketch *instance)
+{
+    if (instance) {
+        free(instance->counts);
+        free(instance->registers);
+        free(instance);
+    }
+}
+
+/**
+ * Adds occurrences of a value to a sketch.
+ *
+ * Negative `delta` retracts occurrences from the Count-Min table. The
+ * HyperLogLog registers only ever grow, so retraction doesn't lower the
+ * distinct count.
+ *
+ * @param instance A pointer to the sketch.
+ * @param value The observed value.
+ * @param delta The number of occurrences to add.
+ * @return The same sketch.
+ */
+sketch *sketch_add(sketch *instance, NN_TYPE value, long delta)
+{
+    uint64_t      hash;
+    size_t        bits;
+    unsigned char rank;
+
+    for (size_t row = 0; row < instance->depth; row++) {
+        size_t column = sketch_hash(value, row + 1) % instance->width;
+        instance->counts[row * instance->width + column] += delta;
+    }
+
+    if (delta > 0) {
+        hash = sketch_hash(value, 0);
+        bits = 64 - instance->precision;
+        rank = (hash << instance->precision)
+                   ? __builtin_clzll(hash << instance->precision) + 1
+                   : (int)bits + 1;
+        if (rank > instance->registers[hash >> bits]) {
+            instance->registers[hash >> bits] = rank;
+        }
+    }
+
+    return instance;
+}
+
+/**
+ * Estimates the number of occurrences of a value.
+ *
+ * The estimate never undercounts, and overcounts by at most e / width of all
+ * occurrences with probability 1 - e^-depth.
+ */
+NN_TYPE sketch_count(const sketch *instance, NN_TYPE value)
+{
+    long count = 0;
+
+    for (size_t row = 0; row < instance->depth; row++) {
+        size_t column = sketch_hash(value, row + 1) % instance->width;
+        long   cell   = instance->counts[row * instance->width + column];
+
+        if (row == 0 || cell < count) {
+            count = cell;
+        }
+    }
+
+    return count > 0 ? (NN_TYPE)count : 0;
+}
+
+/**
+ * Estimates the number of distinct values added to a sketch (HyperLogLog
+ * with the linear counting correction for small cardinalities).
+ */
+NN_TYPE sketch_distinct(const sketch *instance)
+{
+    size_t registers = (size_t)1 << instance->precision;
+    size_t zeros     = 0;
+    double sum       = 0;
+    double alpha     = 0.7213 / (1 + 1.079 / registers);
+    double estimate;
+
+    for (size_t index = 0; index < registers; index++) {
+        sum += ldexp(1.0, -instance->registers[index]);
+        zeros += instance->registers[index] == 0;
+    }
+
+    estimate = alpha * registers * registers / sum;
+    if (estimate <= 2.5 * registers && zeros) {
+        estimate = registers * log((double)registers / zeros);
+    }
+
+    return (NN_TYPE)estimate;
+}
@@ -0,0 +1,1552 @@
+#include "tensor.h"
+#include "matrix_reduce.h"
+#include "number.h"
+#include "vector.h"
+#include <omp.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TENSOR_PARALLEL (1 << 14)
+#define TENSOR_CHUNK    4096 /* elements of a run handled by one task */
+#define TENSOR_BLOCK    256  /* elements gathered at once from a strided run */
+
+/* External definition of the inline accessor */
+NN_TYPE TENSOR(tensor *T, ...);
+
+/* Applies an operation to `length` elements of `x`, with the matching
+ * elements of `y`, walking both with their own stride */
+typedef void tensor_run(NN_TYPE *x, size_t x_stride, const NN_TYPE *y,
+                        size_t y_stride, size_t length, const void *argument);
+
+/* Operation of tensor_map() and tensor_map_builtin() */
+struct tensor_map_argument {
+    NN_TYPE (*operation)(NN_TYPE);
+    NN_TYPE (*binary)(NN_TYPE, NN_TYPE);
+    enum nn_map      builtin;
+    enum nn_accuracy accuracy;
+};
+
+/* Layout of an element-wise loop over a tensor and an operand, with the
+ * dimensions that are contiguous in both merged into one. The last
+ * dimension is walked as runs, the others are decoded from the run index. */
+struct tensor_loop {
+    size_t rank;
+    size_t shape[TENSOR_MAX_RANK];
+    size_t strides[2][TENSOR_MAX_RANK];
+    size_t offset[2];
+    size_t runs;
+};
+
+/**
+ * Allocates a tensor with a row-major contiguous layout, without storage.
+ *
+ * The strides share one allocation with the shape, see tensor_delete().
+ *
+ * @param rank The number of dimensions.
+ * @param shape The size of every dimension.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+static tensor *tensor_init(size_t rank, const size_t *shape)
+{
+    tensor *instance = NULL;
+    size_t  length   = 1;
+
+    CHECK(rank > 0 && rank <= TENSOR_MAX_RANK, "Wrong tensor rank %zu", rank);
+    CHECK_MEMORY(shape);
+
+    instance = malloc(sizeof(tensor));
+    CHECK_MEMORY(instance);
+    instance->shape = malloc(2 * rank * sizeof(size_t));
+    CHECK_MEMORY(instance->shape);
+
+    instance->number.type      = NN_TENSOR;
+    instance->number.ref_count = 1;
+    instance->number.values    = NULL;
+    instance->rank             = rank;
+    instance->strides          = instance->shape + rank;
+    instance->offset           = 0;
+
+    for (size_t axis = rank; axis-- > 0;) {
+        CHECK(shape[axis] > 0, "Wrong tensor size at dimension %zu", axis);
+        instance->shape[axis]   = shape[axis];
+        instance->strides[axis] = length;
+        length *= shape[axis];
+    }
+    instance->length = length;
+
+    return instance;
+
+error:
+    if (instance) {
+        free(instance->shape);
+        free(instance);
+    }
+
+    return NULL;
+}
+
+/**
+ * Creates a contiguous tensor filled with zeros.
+ *
+ * @param rank The number of dimensions, up to TENSOR_MAX_RANK.
+ * @param shape The size of every dimension.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_create(size_t rank, const size_t *shape)
+{
+    tensor *instance = tensor_init(rank, shape);
+    CHECK_MEMORY(instance);
+
+    instance->number.values = vector_create(instance->length);
+    CHECK_MEMORY(instance->number.values);
+
+    return instance;
+
+error:
+    if (instance) {
+        free(instance->shape);
+        free(instance);
+    }
+
+    return NULL;
+}
+
+/**
+ * Creates a contiguous tensor from a list of values in row-major order.
+ *
+ * @param rank The number of dimensions, up to TENSOR_MAX_RANK.
+ * @param shape The size of every dimension.
+ * @param values The values, as many as the product of the shape.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_from_list(size_t rank, const size_t *shape, NN_TYPE *values)
+{
+    tensor *instance = tensor_init(rank, shape);
+    CHECK_MEMORY(instance);
+
+    instance->number.values = vector_from_list(instance->length, values);
+    CHECK_MEMORY(instance->number.values);
+
+    return instance;
+
+error:
+    if (instance) {
+        free(instance->shape);
+        free(instance);
+    }
+
+    return NULL;
+}
+
+/**
+ * Creates a contiguous tensor over the elements of a vector, without copying
+ * them, e.g. to see a flat batch as N x C x H x W.
+ *
+ * The tensor takes a reference to the vector, so both share their elements.
+ *
+ * @param v A pointer to the vector.
+ * @param rank The number of dimensions, up to TENSOR_MAX_RANK.
+ * @param shape The size of every dimension, their product must be the length of the vector.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_from_vector(vector *v, size_t rank, const size_t *shape)
+{
+    tensor *instance = NULL;
+
+    VECTOR_CHECK(v);
+
+    instance = tensor_init(rank, shape);
+    CHECK_MEMORY(instance);
+    CHECK(instance->length == v->length,
+          "Tensor of %zu elements from a vector of %zu", instance->length, v->length);
+
+    instance->number.values = number_ref((number *)v);
+
+    return instance;
+
+error:
+    if (instance) {
+        free(instance->shape);
+        free(instance);
+    }
+
+    return NULL;
+}
+
+/**
+ * Creates a strided view over the elements of a tensor, without copying
+ * them, e.g. a slice, a sub-sampling or a transposition.
+ *
+ * The view takes a reference to the storage of the tensor, so both share
+ * their elements and either can be deleted first.
+ *
+ * @param T A pointer to the tensor.
+ * @param rank The number of dimensions of the view, up to TENSOR_MAX_RANK.
+ * @param shape The size of every dimension of the view.
+ * @param strides The elements between two indexes of every dimension, or NULL for a row-major layout.
+ * @param offset The position of the first element of the view in the storage.
+ * @return A pointer to the view, or NULL on error.
+ */
+tensor *tensor_view(tensor *T, size_t rank, const size_t *shape,
+                    const size_t *strides, size_t offset)
+{
+    tensor *instance = NULL;
+    size_t  last     = offset;
+
+    TENSOR_CHECK(T);
+
+    instance = tensor_init(rank, shape);
+    CHECK_MEMORY(instance);
+
+    if (strides) {
+        memcpy(instance->strides, strides, rank * sizeof(size_t));
+    }
+    for (size_t axis = 0; axis < rank; axis++) {
+        last += (instance->shape[axis] - 1) * instance->strides[axis];
+    }
+    CHECK(last < ((vector *)T->number.values)->length,
+          "View reaches element %zu of %zu", last, ((vector *)T->number.values)->length);
+
+    instance->offset        = offset;
+    instance->number.values = number_ref(T->number.values);
+
+    return instance;
+
+error:
+    if (instance) {
+        free(instance->shape);
+        free(instance);
+    }
+
+    return NULL;
+}
+
+/**
+ * Checks if the elements of a tensor are stored in row-major order without
+ * gaps. Dimensions of size 1 are ignored.
+ *
+ * @param T A pointer to the tensor.
+ * @return 1 if the tensor is contiguous, 0 otherwise.
+ */
+int tensor_is_contiguous(const tensor *T)
+{
+    size_t length = 1;
+
+    TENSOR_CHECK(T);
+
+    for (size_t axis = T->rank; axis-- > 0;) {
+        if (T->shape[axis] > 1 && T->strides[axis] != length) {
+            return 0;
+        }
+        length *= T->shape[axis];
+    }
+
+    return 1;
+
+error:
+    return 0;
+}
+
+/* A tensor which is contiguous and spans its whole storage can be handled as
+ * the storage vector */
+static int tensor_is_dense(const tensor *T)
+{
+    return 0 == T->offset && T->length == ((vector *)T->number.values)->length
+           && tensor_is_contiguous(T);
+}
+
+/* Writing through a dimension with a stride of 0 would update one element
+ * from several places at once */
+static int tensor_is_broadcast(const tensor *T)
+{
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        if (T->shape[axis] > 1 && 0 == T->strides[axis]) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * Calculates the strides which broadcast an operand to a shape, NumPy-style:
+ * the shapes are aligned on their last dimension, and the dimensions which
+ * are missing or of size 1 in the operand get a stride of 0, so they repeat
+ * its elements without copying them.
+ *
+ * @param rank The rank of the broadcast shape.
+ * @param shape The broadcast shape.
+ * @param operand_rank The rank of the operand, up to `rank`.
+ * @param operand_shape The shape of the operand.
+ * @param operand_strides The strides of the operand.
+ * @param strides Receives `rank` strides of the operand over the broadcast shape.
+ * @return 0 on success, 1 if the operand can't be broadcast to the shape.
+ */
+static int tensor_broadcast_strides(size_t rank, const size_t *shape, size_t operand_rank,
+                                    const size_t *operand_shape,
+                                    const size_t *operand_strides, size_t *strides)
+{
+    size_t leading = rank - operand_rank;
+
+    CHECK(operand_rank <= rank, "Can't broadcast rank %zu to rank %zu", operand_rank, rank);
+
+    for (size_t axis = 0; axis < rank; axis++) {
+        size_t size;
+
+        if (axis < leading) {
+            strides[axis] = 0;
+            continue;
+        }
+
+        size = operand_shape[axis - leading];
+        CHECK(size == shape[axis] || 1 == size,
+              "Can't broadcast size %zu to %zu at dimension %zu", size, shape[axis], axis);
+        strides[axis] = 1 == size ? 0 : operand_strides[axis - leading];
+    }
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/**
+ * Creates a view repeating the elements of a tensor over a larger shape,
+ * NumPy-style, without copying them. Dimensions of size 1, and the missing
+ * leading ones, get a stride of 0.
+ *
+ * The view can be read, or cloned to get a contiguous copy, but operations
+ * can't write through it.
+ *
+ * @param T A pointer to the tensor.
+ * @param rank The rank of the view, at least the rank of the tensor.
+ * @param shape The shape of the view.
+ * @return A pointer to the view, or NULL on error.
+ */
+tensor *tensor_broadcast(tensor *T, size_t rank, const size_t *shape)
+{
+    size_t strides[TENSOR_MAX_RANK];
+
+    TENSOR_CHECK(T);
+    CHECK_MEMORY(shape);
+    CHECK(rank <= TENSOR_MAX_RANK, "Wrong tensor rank %zu", rank);
+    CHECK(0 == tensor_broadcast_strides(rank, shape, T->rank, T->shape, T->strides, strides),
+          "Tensor can't be broadcast");
+
+    return tensor_view(T, rank, shape, strides, T->offset);
+
+error:
+    return NULL;
+}
+
+/**
+ * Creates a view of a tensor with its dimensions reordered, e.g. N x H x W x C
+ * seen as N x C x H x W, by swapping the strides without moving any element.
+ *
+ * @param T A pointer to the tensor.
+ * @param axes The dimension of the tensor placed at every dimension of the view, a permutation of 0 to rank - 1.
+ * @return A pointer to the view, or NULL on error.
+ */
+tensor *tensor_permute(tensor *T, const size_t *axes)
+{
+    size_t shape[TENSOR_MAX_RANK], strides[TENSOR_MAX_RANK];
+    int    is_used[TENSOR_MAX_RANK] = {0};
+
+    TENSOR_CHECK(T);
+    CHECK_MEMORY(axes);
+
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        CHECK(axes[axis] < T->rank && !is_used[axes[axis]],
+              "Axes aren't a permutation of %zu dimensions", T->rank);
+        is_used[axes[axis]] = 1;
+        shape[axis]         = T->shape[axes[axis]];
+        strides[axis]       = T->strides[axes[axis]];
+    }
+
+    return tensor_view(T, T->rank, shape, strides, T->offset);
+
+error:
+    return NULL;
+}
+
+/**
+ * Calculates the strides of a tensor seen with another shape of the same
+ * length, when its elements can be reached without copying them: every group
+ * of dimensions which is merged or split must be contiguous in the tensor.
+ * Dimensions of size 1 are ignored.
+ *
+ * @param T A pointer to the tensor.
+ * @param rank The rank of the new shape.
+ * @param shape The new shape.
+ * @param strides Receives the strides of the new shape.
+ * @return 1 if the shape can be a view of the tensor, 0 otherwise.
+ */
+static int tensor_reshape_strides(const tensor *T, size_t rank, const size_t *shape,
+                                  size_t *strides)
+{
+    size_t old_shape[TENSOR_MAX_RANK], old_strides[TENSOR_MAX_RANK];
+    size_t old_rank = 0, old = 0, axis = 0;
+
+    for (size_t dimension = 0; dimension < T->rank; dimension++) {
+        if (T->shape[dimension] > 1) {
+            old_shape[old_rank]   = T->shape[dimension];
+            old_strides[old_rank] = T->strides[dimension];
+            old_rank += 1;
+        }
+    }
+
+    while (axis < rank && old < old_rank) {
+        size_t new_end = axis + 1, old_end = old + 1;
+        size_t new_size = shape[axis], old_size = old_shape[old];
+
+        // Smallest groups of dimensions of the same length
+        while (new_size != old_size) {
+            if (new_size < old_size) {
+                new_size *= shape[new_end++];
+            } else {
+                old_size *= old_shape[old_end++];
+            }
+        }
+
+        for (size_t dimension = old; dimension + 1 < old_end; dimension++) {
+            if (old_strides[dimension] != old_shape[dimension + 1] * old_strides[dimension + 1]) {
+                return 0;
+            }
+        }
+
+        strides[new_end - 1] = old_strides[old_end - 1];
+        for (size_t dimension = new_end - 1; dimension > axis; dimension--) {
+            strides[dimension - 1] = strides[dimension] * shape[dimension];
+        }
+
+        axis = new_end;
+        old  = old_end;
+    }
+
+    // Trailing dimensions of size 1
+    for (; axis < rank; axis++) {
+        strides[axis] = 1;
+    }
+
+    return 1;
+}
+
+/**
+ * Creates a tensor with the elements of another one in row-major order and a
+ * new shape of the same length.
+ *
+ * It is a view sharing the elements of the tensor whenever the strides allow
+ * it, which is always the case for a contiguous tensor, and a contiguous copy
+ * otherwise, e.g. to flatten a permuted view.
+ *
+ * @param T A pointer to the tensor.
+ * @param rank The rank of the new shape, up to TENSOR_MAX_RANK.
+ * @param shape The new shape, its product must be the length of the tensor.
+ * @return A pointer to the view or to the copy, or NULL on error.
+ */
+tensor *tensor_reshape(tensor *T, size_t rank, const size_t *shape)
+{
+    size_t  strides[TENSOR_MAX_RANK];
+    size_t  length = 1;
+    tensor *copy, *instance;
+
+    TENSOR_CHECK(T);
+    CHECK_MEMORY(shape);
+    CHECK(rank > 0 && rank <= TENSOR_MAX_RANK, "Wrong tensor rank %zu", rank);
+
+    for (size_t axis = 0; axis < rank; axis++) {
+        length *= shape[axis];
+    }
+    CHECK(length == T->length, "Can't reshape %zu elements to %zu", T->length, length);
+
+    if (tensor_reshape_strides(T, rank, shape, strides)) {
+        return tensor_view(T, rank, shape, strides, T->offset);
+    }
+
+    copy = tensor_clone(T);
+    CHECK_MEMORY(copy);
+    instance = tensor_view(copy, rank, shape, NULL, 0);
+    number_delete((number *)copy);
+
+    return instance;
+
+error:
+    return NULL;
+}
+
+/**
+ * Returns a tensor with the elements of another one stored contiguously, for
+ * kernels which can't walk strides: the tensor itself with one more
+ * reference when it is already contiguous, or a contiguous copy of it.
+ *
+ * Either way the result is released with number_unref().
+ *
+ * @param T A pointer to the tensor.
+ * @return A pointer to the contiguous tensor, or NULL on error.
+ */
+tensor *tensor_contiguous(tensor *T)
+{
+    TENSOR_CHECK(T);
+
+    if (tensor_is_contiguous(T)) {
+        return (tensor *)number_ref((number *)T);
+    }
+
+    return tensor_clone(T);
+
+error:
+    return NULL;
+}
+
+/**
+ * Calculates the position of an element in the storage of a tensor, without
+ * checking the indexes.
+ *
+ * @param T A pointer to the tensor.
+ * @param indexes One index per dimension.
+ * @return The position of the element in the storage vector.
+ */
+size_t tensor_offset(const tensor *T, const size_t *indexes)
+{
+    size_t offset = T->offset;
+
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        offset += indexes[axis] * T->strides[axis];
+    }
+
+    return offset;
+}
+
+/**
+ * Returns an element of a tensor.
+ *
+ * @param T A pointer to the tensor.
+ * @param indexes One index per dimension.
+ * @return The element, or 0 on error.
+ */
+NN_TYPE tensor_get(const tensor *T, const size_t *indexes)
+{
+    TENSOR_CHECK(T);
+    CHECK_MEMORY(indexes);
+
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        CHECK(indexes[axis] < T->shape[axis], "Index %zu out of bounds at dimension %zu",
+              indexes[axis], axis);
+    }
+
+    return VECTOR(T->number.values, tensor_offset(T, indexes));
+
+error:
+    return 0;
+}
+
+/**
+ * Sets an element of a tensor.
+ *
+ * @param T A pointer to the tensor.
+ * @param indexes One index per dimension.
+ * @param value The new value of the element.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_set(tensor *T, const size_t *indexes, NN_TYPE value)
+{
+    TENSOR_CHECK(T);
+    CHECK_MEMORY(indexes);
+
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        CHECK(indexes[axis] < T->shape[axis], "Index %zu out of bounds at dimension %zu",
+              indexes[axis], axis);
+    }
+
+    vector_prefix_invalidate(T->number.values);
+    VECTOR(T->number.values, tensor_offset(T, indexes)) = value;
+
+    return T;
+
+error:
+    return NULL;
+}
+
+/**
+ * Prepares an element-wise loop over a tensor and an operand of the same
+ * shape. Dimensions of size 1 are dropped, and a dimension is merged into
+ * the next one when both are contiguous for the tensor and the operand.
+ *
+ * @param loop Receives the layout of the loop.
+ * @param T A pointer to the tensor.
+ * @param strides The strides of the operand, or NULL for a scalar.
+ * @param offset The position of the first element of the operand.
+ */
+static void tensor_loop_init(struct tensor_loop *loop, const tensor *T,
+                             const size_t *strides, size_t offset)
+{
+    size_t rank = 0;
+    size_t shape[TENSOR_MAX_RANK];
+    size_t x_strides[TENSOR_MAX_RANK];
+    size_t y_strides[TENSOR_MAX_RANK];
+
+    for (size_t axis = T->rank; axis-- > 0;) {
+        size_t x_stride = T->strides[axis];
+        size_t y_stride = strides ? strides[axis] : 0;
+
+        if (1 == T->shape[axis]) {
+            continue;
+        }
+
+        if (rank > 0 && x_stride == shape[rank - 1] * x_strides[rank - 1]
+            && y_stride == shape[rank - 1] * y_strides[rank - 1]) {
+            shape[rank - 1] *= T->shape[axis];
+            continue;
+        }
+
+        shape[rank]     = T->shape[axis];
+        x_strides[rank] = x_stride;
+        y_strides[rank] = y_stride;
+        rank += 1;
+    }
+
+    if (0 == rank) {
+        shape[0]     = 1;
+        x_strides[0] = 1;
+        y_strides[0] = 0;
+        rank         = 1;
+    }
+
+    loop->rank      = rank;
+    loop->offset[0] = T->offset;
+    loop->offset[1] = offset;
+    loop->runs      = 1;
+    for (size_t axis = 0; axis < rank; axis++) {
+        loop->shape[axis]      = shape[rank - 1 - axis];
+        loop->strides[0][axis] = x_strides[rank - 1 - axis];
+        loop->strides[1][axis] = y_strides[rank - 1 - axis];
+        if (axis + 1 < rank) {
+            loop->runs *= loop->shape[axis];
+        }
+    }
+}
+
+/* Decodes the position of the first element of a run in both operands */
+static void tensor_loop_offsets(const struct tensor_loop *loop, size_t run,
+                                size_t *x_offset, size_t *y_offset)
+{
+    *x_offset = loop->offset[0];
+    *y_offset = loop->offset[1];
+
+    for (size_t axis = loop->rank - 1; axis-- > 0;) {
+        size_t index = run % loop->shape[axis];
+
+        run /= loop->shape[axis];
+        *x_offset += index * loop->strides[0][axis];
+        *y_offset += index * loop->strides[1][axis];
+    }
+}
+
+/**
+ * Runs an element-wise loop, splitting the runs into chunks which are
+ * handled in parallel when the loop is large enough.
+ *
+ * @param loop The layout of the loop.
+ * @param x The storage of the tensor.
+ * @param y The storage of the operand.
+ * @param run The operation applied to every chunk.
+ * @param argument The argument of the operation.
+ */
+static void tensor_loop_apply(const struct tensor_loop *loop, NN_TYPE *x, const NN_TYPE *y,
+                              tensor_run *run, const void *argument)
+{
+    size_t inner    = loop->shape[loop->rank - 1];
+    size_t x_stride = loop->strides[0][loop->rank - 1];
+    size_t y_stride = loop->strides[1][loop->rank - 1];
+    size_t chunks   = (inner + TENSOR_CHUNK - 1) / TENSOR_CHUNK;
+    size_t tasks    = loop->runs * chunks;
+
+#pragma omp parallel for schedule(static) if (loop->runs * inner >= TENSOR_PARALLEL)
+    for (size_t task = 0; task < tasks; task++) {
+        size_t from   = task % chunks * TENSOR_CHUNK;
+        size_t length = inner - from < TENSOR_CHUNK ? inner - from : TENSOR_CHUNK;
+        size_t x_offset, y_offset;
+
+        tensor_loop_offsets(loop, task / chunks, &x_offset, &y_offset);
+        run(x + x_offset + from * x_stride, x_stride, y + y_offset + from * y_stride,
+            y_stride, length, argument);
+    }
+}
+
+/* Arithmetic on a run, with the strided vector kernels */
+static void tensor_arithmetic_run(NN_TYPE *x, size_t x_stride, const NN_TYPE *y,
+                                  size_t y_stride, size_t length, const void *argument)
+{
+    vector_operation_values(*(const enum nn_operation *)argument, x, x_stride, y, y_stride,
+                            length);
+}
+
+static void tensor_copy_run(NN_TYPE *x, size_t x_stride, const NN_TYPE *y,
+                            size_t y_stride, size_t length, const void *argument)
+{
+    (void)argument;
+
+    if (1 == x_stride && 1 == y_stride) {
+        memcpy(x, y, length * sizeof(NN_TYPE));
+        return;
+    }
+
+    for (size_t index = 0; index < length; index++) {
+        x[index * x_stride] = y[index * y_stride];
+    }
+}
+
+static void tensor_map_run(NN_TYPE *x, size_t x_stride, const NN_TYPE *y,
+                           size_t y_stride, size_t length, const void *argument)
+{
+    const struct tensor_map_argument *map = argument;
+
+    (void)y;
+    (void)y_stride;
+
+    for (size_t index = 0; index < length; index++) {
+        x[index * x_stride] = map->operation(x[index * x_stride]);
+    }
+}
+
+static void tensor_map_with_run(NN_TYPE *x, size_t x_stride, const NN_TYPE *y,
+                                size_t y_stride, size_t length, const void *argument)
+{
+    const struct tensor_map_argument *map = argument;
+
+    for (size_t index = 0; index < length; index++) {
+        x[index * x_stride] = map->binary(x[index * x_stride], y[index * y_stride]);
+    }
+}
+
+/* Strided runs are gathered into a buffer to reuse the vector kernels */
+static void tensor_map_builtin_run(NN_TYPE *x, size_t x_stride, const NN_TYPE *y,
+                                   size_t y_stride, size_t length, const void *argument)
+{
+    const struct tensor_map_argument *map = argument;
+    NN_TYPE buffer[TENSOR_BLOCK];
+
+    (void)y;
+    (void)y_stride;
+
+    if (1 == x_stride) {
+        vector_map_builtin_values(x, length, map->builtin, map->accuracy);
+        return;
+    }
+
+    for (size_t from = 0; from < length; from += TENSOR_BLOCK) {
+        size_t count = length - from < TENSOR_BLOCK ? length - from : TENSOR_BLOCK;
+
+        for (size_t index = 0; index < count; index++) {
+            buffer[index] = x[(from + index) * x_stride];
+        }
+        vector_map_builtin_values(buffer, count, map->builtin, map->accuracy);
+        for (size_t index = 0; index < count; index++) {
+            x[(from + index) * x_stride] = buffer[index];
+        }
+    }
+}
+
+/**
+ * Creates a contiguous copy of a tensor, or of a view.
+ *
+ * @param T A pointer to the tensor.
+ * @return A pointer to the copy, or NULL on error.
+ */
+tensor *tensor_clone(const tensor *T)
+{
+    struct tensor_loop loop;
+    tensor            *instance;
+
+    TENSOR_CHECK(T);
+
+    instance = tensor_create(T->rank, T->shape);
+    CHECK_MEMORY(instance);
+
+    tensor_loop_init(&loop, instance, T->strides, T->offset);
+    tensor_loop_apply(&loop, &VECTOR(instance->number.values, 0),
+                      &VECTOR(T->number.values, 0), tensor_copy_run, NULL);
+
+    return instance;
+
+error:
+    return NULL;
+}
+
+/**
+ * Sets every element of a tensor to a value.
+ *
+ * @param T A pointer to the tensor.
+ * @param value The value.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_seed(tensor *T, NN_TYPE value)
+{
+    struct tensor_loop loop;
+
+    TENSOR_CHECK(T);
+    vector_prefix_invalidate(T->number.values);
+
+    tensor_loop_init(&loop, T, NULL, 0);
+    tensor_loop_apply(&loop, &VECTOR(T->number.values, 0), &value, tensor_copy_run, NULL);
+
+    return T;
+
+error:
+    return NULL;
+}
+
+/**
+ * Checks if two tensors have the same shape and elements, whatever their
+ * layout.
+ *
+ * @param T A pointer to the first tensor.
+ * @param U A pointer to the second tensor.
+ * @return 1 if the tensors are equal, 0 if not, -1 on error.
+ */
+int tensor_is_equal(const tensor *T, const tensor *U)
+{
+    struct tensor_loop loop;
+    size_t             inner;
+
+    TENSOR_CHECK(T);
+    TENSOR_CHECK(U);
+
+    if (T->rank != U->rank || memcmp(T->shape, U->shape, T->rank * sizeof(size_t))) {
+        return 0;
+    }
+
+    tensor_loop_init(&loop, T, U->strides, U->offset);
+    inner = loop.shape[loop.rank - 1];
+
+    for (size_t run = 0; run < loop.runs; run++) {
+        size_t   x_offset, y_offset;
+        NN_TYPE *x, *y;
+
+        tensor_loop_offsets(&loop, run, &x_offset, &y_offset);
+        x = &VECTOR(T->number.values, x_offset);
+        y = &VECTOR(U->number.values, y_offset);
+        for (size_t index = 0; index < inner; index++) {
+            if (x[index * loop.strides[0][loop.rank - 1]]
+                != y[index * loop.strides[1][loop.rank - 1]]) {
+                return 0;
+            }
+        }
+    }
+
+    return 1;
+
+error:
+    return -1;
+}
+
+/**
+ * Prepares the loop of an operation between a tensor and an operand which is
+ * broadcast to its shape: a tensor, or a vector seen as a tensor of rank 1.
+ *
+ * An operand sharing the storage of the tensor with another shape or layout
+ * is copied first, as the loop would read elements it has already updated.
+ *
+ * @param loop Receives the layout of the loop.
+ * @param T A pointer to the tensor.
+ * @param w The operand.
+ * @param copy Receives the copy of the operand, if one was needed.
+ * @return The storage of the operand, or NULL on error.
+ */
+static const NN_TYPE *tensor_loop_operand(struct tensor_loop *loop, const tensor *T,
+                                          const number *w, tensor **copy)
+{
+    size_t        strides[TENSOR_MAX_RANK];
+    const tensor *U = (const tensor *)w;
+
+    *copy = NULL;
+
+    if (NN_VECTOR == w->type) {
+        size_t length = ((const vector *)w)->length;
+        size_t stride = 1;
+
+        CHECK(0 == tensor_broadcast_strides(T->rank, T->shape, 1, &length, &stride, strides),
+              "Vector can't be broadcast to the tensor");
+        tensor_loop_init(loop, T, strides, 0);
+
+        return &VECTOR(w, 0);
+    }
+
+    CHECK(NN_TENSOR == w->type, "Tensor operation with a number of type %d", w->type);
+
+    if (U->number.values == T->number.values
+        && (U->offset != T->offset || U->rank != T->rank
+            || memcmp(U->shape, T->shape, T->rank * sizeof(size_t))
+            || memcmp(U->strides, T->strides, T->rank * sizeof(size_t)))) {
+        *copy = tensor_clone(U);
+        CHECK_MEMORY(*copy);
+        U = *copy;
+    }
+
+    CHECK(0 == tensor_broadcast_strides(T->rank, T->shape, U->rank, U->shape, U->strides,
+                                        strides),
+          "Tensor can't be broadcast to the tensor");
+    tensor_loop_init(loop, T, strides, U->offset);
+
+    return &VECTOR(U->number.values, 0);
+
+error:
+    return NULL;
+}
+
+/**
+ * Applies an element-wise operation with a scalar, or with a tensor or a
+ * vector broadcast to the shape of the tensor. Dense tensors of the same
+ * shape are handed to the vector operation as a whole, others are walked run
+ * by run.
+ *
+ * @return 0 on success, 1 on failure.
+ */
+static int tensor_operation(tensor *T, const number *w, enum nn_operation operation,
+                            vector *vector_operation(vector *, const number *))
+{
+    struct tensor_loop loop;
+    const tensor      *U    = (const tensor *)w;
+    tensor            *copy = NULL;
+    const NN_TYPE     *y;
+    NN_TYPE            scalar;
+
+    CHECK(!tensor_is_broadcast(T), "Can't write to a broadcast view");
+    vector_prefix_invalidate(T->number.values);
+
+    if (NN_DOUBLE >= w->type) {
+        if (NN_TYPE_ENUM == w->type && tensor_is_dense(T)) {
+            CHECK_MEMORY(vector_operation(T->number.values, number_ref((number *)w)));
+            return 0;
+        }
+
+        scalar = NN_INTEGER == w->type  ? (NN_TYPE)w->integer
+                 : NN_DOUBLE == w->type ? (NN_TYPE)w->doubled
+                                        : (NN_TYPE)w->floated;
+        tensor_loop_init(&loop, T, NULL, 0);
+        tensor_loop_apply(&loop, &VECTOR(T->number.values, 0), &scalar,
+                          tensor_arithmetic_run, &operation);
+
+        return 0;
+    }
+
+    if (NN_TENSOR == w->type && T->rank == U->rank
+        && 0 == memcmp(T->shape, U->shape, T->rank * sizeof(size_t)) && tensor_is_dense(T)
+        && tensor_is_dense(U)) {
+        CHECK_MEMORY(vector_operation(T->number.values, number_ref(U->number.values)));
+        return 0;
+    }
+
+    y = tensor_loop_operand(&loop, T, w, &copy);
+    CHECK_MEMORY(y);
+    tensor_loop_apply(&loop, &VECTOR(T->number.values, 0), y, tensor_arithmetic_run,
+                      &operation);
+    if (copy) {
+        number_delete((number *)copy);
+    }
+
+    return 0;
+
+error:
+    if (copy) {
+        number_delete((number *)copy);
+    }
+
+    return 1;
+}
+
+/* Element-wise operations with a scalar, or with a tensor or a vector which
+ * is broadcast to the shape of the tensor, in place. As with vectors, the
+ * operand is released. */
+#define TENSOR_METHOD_OPERATION(name, operation)                               \
+    tensor *tensor_##name(tensor *T, const number *w)                          \
+    {                                                                          \
+        TENSOR_CHECK(T);                                                       \
+        NUMBER_CHECK(w);                                                       \
+                                                                               \
+        CHECK(0 == tensor_operation(T, w, operation, vector_##name),           \
+              "tensor_" #name "() failed");                                    \
+        number_unref((number *)w);                                             \
+                                                                               \
+        return T;                                                              \
+                                                                               \
+    error:                                                                     \
+        return NULL;                                                           \
+    }
+
+TENSOR_METHOD_OPERATION(addition, NN_ADDITION)
+TENSOR_METHOD_OPERATION(subtraction, NN_SUBTRACTION)
+TENSOR_METHOD_OPERATION(multiplication, NN_MULTIPLICATION)
+TENSOR_METHOD_OPERATION(division, NN_DIVISION)
+
+/**
+ * Applies an operation to every element of a tensor, in place.
+ *
+ * @param T A pointer to the tensor.
+ * @param operation The operation.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_map(tensor *T, NN_TYPE operation(NN_TYPE))
+{
+    struct tensor_loop         loop;
+    struct tensor_map_argument map = {.operation = operation};
+
+    TENSOR_CHECK(T);
+    CHECK_MEMORY(operation);
+    CHECK(!tensor_is_broadcast(T), "Can't write to a broadcast view");
+    vector_prefix_invalidate(T->number.values);
+
+    tensor_loop_init(&loop, T, NULL, 0);
+    tensor_loop_apply(&loop, &VECTOR(T->number.values, 0), NULL, tensor_map_run, &map);
+
+    return T;
+
+error:
+    return NULL;
+}
+
+/**
+ * Applies an operation to every element of a tensor and the matching element
+ * of an operand broadcast to its shape, in place, e.g. to clip every row of
+ * a batch with its own bounds.
+ *
+ * @param T A pointer to the tensor.
+ * @param operation The operation, called with the element of the tensor first.
+ * @param U A pointer to the operand, which is kept.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_map_with(tensor *T, NN_TYPE operation(NN_TYPE, NN_TYPE), const tensor *U)
+{
+    struct tensor_loop         loop;
+    struct tensor_map_argument map  = {.binary = operation};
+    tensor                    *copy = NULL;
+    const NN_TYPE             *y;
+
+    TENSOR_CHECK(T);
+    TENSOR_CHECK(U);
+    CHECK_MEMORY(operation);
+    CHECK(!tensor_is_broadcast(T), "Can't write to a broadcast view");
+    vector_prefix_invalidate(T->number.values);
+
+    y = tensor_loop_operand(&loop, T, (const number *)U, &copy);
+    CHECK_MEMORY(y);
+    tensor_loop_apply(&loop, &VECTOR(T->number.values, 0), y, tensor_map_with_run, &map);
+    if (copy) {
+        number_delete((number *)copy);
+    }
+
+    return T;
+
+error:
+    if (copy) {
+        number_delete((number *)copy);
+    }
+
+    return NULL;
+}
+
+/**
+ * Applies a built-in operation to every element of a tensor, in place, see
+ * vector_map_builtin().
+ *
+ * @param T A pointer to the tensor.
+ * @param operation The operation: NN_EXP, NN_LOG, NN_TANH, NN_SIGMOID or NN_SQRT.
+ * @param accuracy NN_PRECISE or NN_FAST.
+ * @return A pointer to the tensor, or NULL on error.
+ */
+tensor *tensor_map_builtin(tensor *T, enum nn_map operation, enum nn_accuracy accuracy)
+{
+    struct tensor_loop         loop;
+    struct tensor_map_argument map = {.builtin = operation, .accuracy = accuracy};
+
+    TENSOR_CHECK(T);
+    CHECK(operation <= NN_SQRT, "Unknown operation %d", operation);
+    CHECK(!tensor_is_broadcast(T), "Can't write to a broadcast view");
+    vector_prefix_invalidate(T->number.values);
+
+    tensor_loop_init(&loop, T, NULL, 0);
+    tensor_loop_apply(&loop, &VECTOR(T->number.values, 0), NULL, tensor_map_builtin_run,
+                      &map);
+
+    return T;
+
+error:
+    return NULL;
+}
+
+/* Reduction of a tensor over some of its dimensions, see tensor_reduction_init() */
+struct tensor_reduction {
+    size_t kept_rank;
+    size_t kept_shape[TENSOR_MAX_RANK];
+    size_t kept_strides[TENSOR_MAX_RANK];      /* in the tensor */
+    size_t kept_outputs[TENSOR_MAX_RANK];      /* in the result */
+    size_t reduced_rank;
+    size_t reduced_shape[TENSOR_MAX_RANK];
+    size_t reduced_strides[TENSOR_MAX_RANK];   /* in the tensor */
+    size_t reduced_positions[TENSOR_MAX_RANK]; /* in the row-major order of the reduced dimensions */
+    size_t offset;
+    int    is_streamed; /* the last kept dimension is walked four results at a time */
+    size_t units;       /* combinations of the kept dimensions which aren't streamed */
+    size_t width;       /* results of a unit: the size of the streamed dimension, or 1 */
+    size_t length;      /* elements reduced into every result */
+};
+
+/* Sorts dimensions by decreasing stride in the tensor, so that the last ones
+ * are the innermost loops */
+static void tensor_reduction_sort(size_t rank, size_t *shape, size_t *strides, size_t *steps)
+{
+    for (size_t axis = 1; axis < rank; axis++) {
+        for (size_t other = axis; other > 0 && strides[other - 1] < strides[other]; other--) {
+            size_t swap[3] = {shape[other], strides[other], steps[other]};
+
+            shape[other]       = shape[other - 1];
+            strides[other]     = strides[other - 1];
+            steps[other]       = steps[other - 1];
+            shape[other - 1]   = swap[0];
+            strides[other - 1] = swap[1];
+            steps[other - 1]   = swap[2];
+        }
+    }
+}
+
+/**
+ * Prepares the loops of a reduction.
+ *
+ * Dimensions of size 1 are dropped, and neighbour dimensions which are both
+ * kept or both reduced are merged when they are contiguous in the tensor.
+ * Each group is then ordered by decreasing stride. When the last kept
+ * dimension has a smaller stride than every reduced one, e.g. the batch
+ * dimension of N x C, it is streamed into a row of accumulators instead of
+ * gathering every result from elements far apart.
+ *
+ * @param reduction Receives the loops.
+ * @param T A pointer to the tensor.
+ * @param is_reduced Whether every dimension of the tensor is reduced.
+ */
+static void tensor_reduction_init(struct tensor_reduction *reduction, const tensor *T,
+                                  const int *is_reduced)
+{
+    size_t shape[TENSOR_MAX_RANK], strides[TENSOR_MAX_RANK], steps[TENSOR_MAX_RANK];
+    size_t step[TENSOR_MAX_RANK];
+    int    kinds[TENSOR_MAX_RANK];
+    size_t rank = 0, outputs = 1, positions = 1;
+
+    // Step of every dimension in the result, or among the reduced positions
+    for (size_t axis = T->rank; axis-- > 0;) {
+        if (is_reduced[axis]) {
+            step[axis] = positions;
+            positions *= T->shape[axis];
+        } else {
+            step[axis] = outputs;
+            outputs *= T->shape[axis];
+        }
+    }
+
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        if (1 == T->shape[axis]) {
+            continue;
+        }
+        if (rank > 0 && kinds[rank - 1] == is_reduced[axis]
+            && strides[rank - 1] == T->shape[axis] * T->strides[axis]) {
+            shape[rank - 1] *= T->shape[axis];
+            strides[rank - 1] = T->strides[axis];
+            steps[rank - 1]   = step[axis];
+            continue;
+        }
+        shape[rank]   = T->shape[axis];
+        strides[rank] = T->strides[axis];
+        steps[rank]   = step[axis];
+        kinds[rank]   = is_reduced[axis];
+        rank += 1;
+    }
+
+    reduction->kept_rank    = 0;
+    reduction->reduced_rank = 0;
+    for (size_t axis = 0; axis < rank; axis++) {
+        if (kinds[axis]) {
+            size_t at = reduction->reduced_rank++;
+
+            reduction->reduced_shape[at]     = shape[axis];
+            reduction->reduced_strides[at]   = strides[axis];
+            reduction->reduced_positions[at] = steps[axis];
+        } else {
+            size_t at = reduction->kept_rank++;
+
+            reduction->kept_shape[at]   = shape[axis];
+            reduction->kept_strides[at] = strides[axis];
+            reduction->kept_outputs[at] = steps[axis];
+        }
+    }
+    tensor_reduction_sort(reduction->kept_rank, reduction->kept_shape, reduction->kept_strides,
+                          reduction->kept_outputs);
+    tensor_reduction_sort(reduction->reduced_rank, reduction->reduced_shape,
+                          reduction->reduced_strides, reduction->reduced_positions);
+
+    reduction->is_streamed = reduction->kept_rank > 0
+                             && (0 == reduction->reduced_rank
+                                 || reduction->kept_strides[reduction->kept_rank - 1]
+                                        < reduction->reduced_strides[reduction->reduced_rank - 1]);
+
+    // Nothing to reduce: a single run of one element
+    if (0 == reduction->reduced_rank) {
+        reduction->reduced_rank         = 1;
+        reduction->reduced_shape[0]     = 1;
+        reduction->reduced_strides[0]   = 1;
+        reduction->reduced_positions[0] = 0;
+    }
+
+    reduction->offset = T->offset;
+    reduction->width  = reduction->is_streamed ? reduction->kept_shape[reduction->kept_rank - 1] : 1;
+    reduction->units  = outputs / reduction->width;
+    reduction->length = positions;
+}
+
+/* Position in the tensor of the first element of a unit, and in the result of its first result */
+static size_t tensor_reduction_unit(const struct tensor_reduction *reduction, size_t unit,
+                                    size_t *output)
+{
+    size_t offset = reduction->offset;
+    size_t rank   = reduction->kept_rank - reduction->is_streamed;
+
+    *output = 0;
+    for (size_t axis = rank; axis-- > 0;) {
+        size_t index = unit % reduction->kept_shape[axis];
+
+        unit /= reduction->kept_shape[axis];
+        offset += index * reduction->kept_strides[axis];
+        *output += index * reduction->kept_outputs[axis];
+    }
+
+    return offset;
+}
+
+/* Position in the tensor of an element of the reduced loops, relative to a
+ * unit, and its position among the reduced elements */
+static size_t tensor_reduction_element(const struct tensor_reduction *reduction, size_t index,
+                                       size_t *position)
+{
+    size_t offset = 0;
+
+    *position = 0;
+    for (size_t axis = reduction->reduced_rank; axis-- > 0;) {
+        size_t at = index % reduction->reduced_shape[axis];
+
+        index /= reduction->reduced_shape[axis];
+        offset += at * reduction->reduced_strides[axis];
+        *position += at * reduction->reduced_positions[axis];
+    }
+
+    return offset;
+}
+
+/**
+ * Reduces the elements [from, to) of the reduced loops into one result,
+ * walking the innermost reduced dimension four values at a time. Strided
+ * runs are gathered into a buffer first.
+ *
+ * @param result Receives the accumulator, before matrix_reduce_finish().
+ * @param result_at Receives the position of the extremum, for argmin and argmax.
+ */
+static void tensor_reduction_run(const struct tensor_reduction *reduction, const NN_TYPE *values,
+                                 size_t base, enum nn_reduction operation, NN_TYPE mean,
+                                 size_t from, size_t to, NN_TYPE *result, NN_TYPE *result_at)
+{
+    size_t  last        = reduction->reduced_rank - 1;
+    size_t  size        = reduction->reduced_shape[last];
+    size_t  stride      = reduction->reduced_strides[last];
+    size_t  step        = reduction->reduced_positions[last];
+    NN_TYPE identity    = matrix_reduce_identity(operation);
+    v4sf    accumulator = {identity, identity, identity, identity};
+    v4sf    at          = {0};
+    NN_TYPE buffer[TENSOR_BLOCK];
+
+    for (size_t index = from; index < to;) {
+        size_t         position;
+        size_t         offset = base + tensor_reduction_element(reduction, index, &position);
+        size_t         run    = size - index % size;
+        const NN_TYPE *x      = &values[offset];
+
+        run = run < to - index ? run : to - index;
+        if (1 != stride) {
+            run = run < TENSOR_BLOCK ? run : TENSOR_BLOCK;
+            for (size_t element = 0; element < run; element++) {
+                buffer[element] = values[offset + element * stride];
+            }
+            x = buffer;
+        }
+
+        for (size_t element = 0; element < run; element += 4) {
+            /* Padding with the mean adds nothing to the variance */
+            v4sf block = matrix_reduce_load(&x[element], run - element,
+                                            NN_VARIANCE == operation ? mean : identity);
+            v4sf where = {position + element * step, position + (element + 1) * step,
+                          position + (element + 2) * step, position + (element + 3) * step};
+
+            matrix_reduce_step(operation, block, (v4sf) {0} + mean, where, &accumulator, &at);
+        }
+
+        index += run;
+    }
+
+    *result    = accumulator[0];
+    *result_at = at[0];
+    for (int lane = 1; lane < 4; lane++) {
+        matrix_reduce_merge(operation, result, result_at, accumulator[lane], at[lane]);
+    }
+}
+
+/**
+ * Reduces the elements [from, to) of the reduced loops into the results of
+ * a unit, streaming the last kept dimension in memory order into one SIMD
+ * accumulator per result.
+ *
+ * @param mean The mean of every result of the unit, for the variance, or NULL.
+ * @param accumulators Receives the accumulators, `width` rounded up to 4.
+ * @param at Receives the positions of the extrema, as many as the accumulators.
+ */
+static void tensor_reduction_stream(const struct tensor_reduction *reduction, const NN_TYPE *values,
+                                    size_t base, enum nn_reduction operation, const NN_TYPE *mean,
+                                    size_t from, size_t to, NN_TYPE *accumulators, NN_TYPE *at)
+{
+    size_t  width    = reduction->width;
+    size_t  stride   = reduction->kept_strides[reduction->kept_rank - 1];
+    NN_TYPE identity = matrix_reduce_identity(operation);
+
+    for (size_t column = 0; column < (width + 3) / 4 * 4; column++) {
+        accumulators[column] = identity;
+        at[column]           = 0;
+    }
+
+    for (size_t index = from; index < to; index++) {
+        size_t position;
+        size_t offset = base + tensor_reduction_element(reduction, index, &position);
+
+        for (size_t column = 0; column < width; column += 4) {
+            size_t count      = width - column < 4 ? width - column : 4;
+            v4sf   block_mean = {0};
+            v4sf   x, accumulator, block_at;
+
+            if (1 == stride) {
+                x = matrix_reduce_load(&values[offset + column], count, identity);
+            } else {
+                x = (v4sf) {0} + identity;
+                for (size_t lane = 0; lane < count; lane++) {
+                    x[lane] = values[offset + (column + lane) * stride];
+                }
+            }
+            if (mean) {
+                block_mean = matrix_reduce_load(&mean[column], count, 0);
+            }
+            memcpy(&accumulator, &accumulators[column], sizeof(accumulator));
+            memcpy(&block_at, &at[column], sizeof(block_at));
+
+            matrix_reduce_step(operation, x, block_mean, (v4sf) {0} + (NN_TYPE)position,
+                               &accumulator, &block_at);
+
+            memcpy(&accumulators[column], &accumulator, sizeof(accumulator));
+            memcpy(&at[column], &block_at, sizeof(block_at));
+        }
+    }
+}
+
+/**
+ * Computes the results of a reduction, unit by unit.
+ *
+ * Units are spread over the threads when there are enough of them.
+ * Otherwise, e.g. for the sum of a whole tensor, the reduced loops are split
+ * into blocks, one per thread, whose accumulators are merged in order.
+ *
+ * @param results Receives the results, `width` per unit.
+ * @param mean The mean of every result in the same order, for the variance, or NULL.
+ * @return 0 on success, 1 on error.
+ */
+static int tensor_reduction_apply(const struct tensor_reduction *reduction, const tensor *T,
+                                  enum nn_reduction operation, const NN_TYPE *mean,
+                                  NN_TYPE *results)
+{
+    const NN_TYPE *values   = &VECTOR(T->number.values, 0);
+    size_t         span     = reduction->is_streamed ? (reduction->width + 3) / 4 * 4 : 1;
+    size_t         work     = reduction->units * reduction->width * reduction->length;
+    size_t         blocks   = 1;
+    NN_TYPE       *partials = NULL;
+
+    if (work >= TENSOR_PARALLEL && reduction->units < (size_t)omp_get_max_threads()) {
+        blocks = omp_get_max_threads();
+        blocks = blocks < reduction->length ? blocks : reduction->length;
+    }
+
+    /* Accumulators then positions of every unit of every block */
+    partials = malloc(2 * blocks * reduction->units * span * sizeof(NN_TYPE));
+    CHECK_MEMORY(partials);
+
+    #pragma omp parallel for schedule(static) if (work >= TENSOR_PARALLEL)
+    for (size_t job = 0; job < blocks * reduction->units; job++) {
+        size_t   block = job / reduction->units, unit = job % reduction->units;
+        size_t   from  = reduction->length * block / blocks;
+        size_t   to    = reduction->length * (block + 1) / blocks;
+        NN_TYPE *accumulators = &partials[2 * job * span];
+        size_t   output;
+        size_t   base = tensor_reduction_unit(reduction, unit, &output);
+
+        if (reduction->is_streamed) {
+            tensor_reduction_stream(reduction, values, base, operation,
+                                    mean ? &mean[unit * reduction->width] : NULL, from, to,
+                                    accumulators, accumulators + span);
+        } else {
+            tensor_reduction_run(reduction, values, base, operation, mean ? mean[unit] : 0, from,
+                                 to, accumulators, accumulators + 1);
+        }
+    }
+
+    for (size_t unit = 0; unit < reduction->units; unit++) {
+        NN_TYPE *first = &partials[2 * unit * span];
+
+        for (size_t element = 0; element < reduction->width; element++) {
+            for (size_t block = 1; block < blocks; block++) {
+                NN_TYPE *other = &partials[2 * (block * reduction->units + unit) * span];
+
+                matrix_reduce_merge(operation, &first[element], &first[span + element],
+                                    other[element], other[span + element]);
+            }
+            results[unit * reduction->width + element] = matrix_reduce_finish(
+                operation, first[element], first[span + element], reduction->length);
+        }
+    }
+
+    free(partials);
+
+    return 0;
+
+error:
+    return 1;
+}
+
+/**
+ * Reduces a tensor along some of its dimensions, e.g. the mean of every
+ * channel of an N x C x H x W batch over the dimensions 0, 2 and 3.
+ *
+ * The tensor is read in place, views included, without transposing it: see
+ * tensor_reduction_init() for the loops, which run in parallel for large
+ * tensors. The variance is the population variance, taking a second pass
+ * from the means. Argmin and argmax give the position of the first extremum
+ * in the row-major order of the reduced dimensions, which is the index along
+ * the dimension when only one is reduced; they are refused when more than
+ * MATRIX_REDUCE_POSITIONS elements are reduced into one result.
+ *
+ * @param T A pointer to the tensor.
+ * @param count The number of dimensions to reduce.
+ * @param axes The dimensions to reduce, or NULL to reduce all of them.
+ * @param reduction NN_SUM, NN_MEAN, NN_MIN, NN_MAX, NN_ARGMIN, NN_ARGMAX,
+ * NN_VARIANCE, NN_L1_NORM or NN_L2_NORM.
+ * @param keepdims 1 to keep the reduced dimensions with a size of 1, 0 to drop them.
+ * @return A new contiguous tensor with the results, of shape [1] when every
+ * dimension is dropped, or NULL on error.
+ */
+tensor *tensor_reduce(const tensor *T, size_t count, const size_t *axes,
+                      enum nn_reduction reduction, int keepdims)
+{
+    struct tensor_reduction loops;
+    int                     is_reduced[TENSOR_MAX_RANK] = {0};
+    size_t                  shape[TENSOR_MAX_RANK];
+    size_t                  rank     = 0;
+    NN_TYPE                *results  = NULL;
+    NN_TYPE                *mean     = NULL;
+    tensor                 *instance = NULL;
+
+    TENSOR_CHECK(T);
+    CHECK(reduction >= NN_SUM && reduction <= NN_L2_NORM, "Unknown reduction %d", reduction);
+
+    for (size_t axis = 0; axis < (axes ? count : T->rank); axis++) {
+        size_t dimension = axes ? axes[axis] : axis;
+
+        CHECK(dimension < T->rank, "Wrong dimension %zu of a rank %zu tensor", dimension, T->rank);
+        CHECK(!is_reduced[dimension], "Dimension %zu is reduced twice", dimension);
+        is_reduced[dimension] = 1;
+    }
+
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        if (!is_reduced[axis] || keepdims) {
+            shape[rank++] = is_reduced[axis] ? 1 : T->shape[axis];
+        }
+    }
+    if (0 == rank) {
+        shape[rank++] = 1;
+    }
+
+    tensor_reduction_init(&loops, T, is_reduced);
+    CHECK((NN_ARGMIN != reduction && NN_ARGMAX != reduction) || loops.length <= MATRIX_REDUCE_POSITIONS,
+          "Positions of %zu reduced elements don't fit in NN_TYPE", loops.length);
+
+    instance = tensor_create(rank, shape);
+    CHECK_MEMORY(instance);
+    results = malloc(instance->length * sizeof(NN_TYPE));
+    CHECK_MEMORY(results);
+
+    if (NN_VARIANCE == reduction) {
+        mean = malloc(instance->length * sizeof(NN_TYPE));
+        CHECK_MEMORY(mean);
+        CHECK(0 == tensor_reduction_apply(&loops, T, NN_MEAN, NULL, mean), "Mean failed");
+    }
+    CHECK(0 == tensor_reduction_apply(&loops, T, reduction, mean, results), "Reduction failed");
+
+    // Results to their place in the row-major result
+    for (size_t unit = 0; unit < loops.units; unit++) {
+        size_t output;
+        size_t step = loops.is_streamed ? loops.kept_outputs[loops.kept_rank - 1] : 0;
+
+        tensor_reduction_unit(&loops, unit, &output);
+        for (size_t element = 0; element < loops.width; element++) {
+            VECTOR(instance->number.values, output + element * step)
+                = results[unit * loops.width + element];
+        }
+    }
+
+    free(results);
+    free(mean);
+
+    return instance;
+
+error:
+    free(results);
+    free(mean);
+    if (instance) {
+        number_delete((number *)instance);
+    }
+
+    return NULL;
+}
+
+void tensor_print(const tensor *T)
+{
+    size_t indexes[TENSOR_MAX_RANK] = {0};
+
+    TENSOR_CHECK(T);
+
+    printf("\tTensor shape = [");
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        printf(axis ? ", %zu" : "%zu", T->shape[axis]);
+    }
+    printf("]\n\t\t[\t");
+
+    for (size_t index = 0; index < T->length; index++) {
+        if (index < 5 || index + 5 > T->length) {
+            printf("%.4f,\n\t\t\t", VECTOR(T->number.values, tensor_offset(T, indexes)));
+        }
+
+        if (index == 6) {
+            printf("...,\n\t\t\t");
+        }
+
+        for (size_t axis = T->rank; axis-- > 0;) {
+            if (++indexes[axis] < T->shape[axis]) {
+                break;
+            }
+            indexes[axis] = 0;
+        }
+    }
+
+    printf("\t\t\t]\n");
+
+error:
+    return;
+}
@@ -4,11 +4,23 @@
 #include "util/error.h"
 #include "utils.h"
 #include <math.h>
+#include <omp.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 
 
 #define VECTOR_COMMON_SIZE      128
+#define VECTOR_SORT_PARALLEL    (1 << 16)
+#define VECTOR_SEARCH_SORTED    64
+#define VECTOR_SCAN_PARALLEL    (1 << 16)
+#define VECTOR_MAP_PARALLEL     (1 << 14)
+#define NN_SWAP(a, b)                                                          \
+    do {                                                                       \
+        __typeof__(a) swapped = (a);                                           \
+        (a)                   = (b);                                           \
+        (b)                   = swapped;                                       \
+    } while (0)
 #define COPY_ALIGMENT           32
 #define COPY_ALIGMENT_THRESHOLD 32 * 4
 #define PRAGMA(x)               _Pragma(#x)
@@ -53,6 +65,7 @@ vector *vector_create(size_t length)
     instance->number.ref_count = 1;
     instance->length           = length;
     instance->number.values    = values;
+    instance->prefix           = NULL;
 
     return instance;
 
@@ -63,6 +76,53 @@ error:
     return NULL;
 }
 
+/**
+ * Fills a vector with uniform random values within a range, in parallel.
+ *
+ * The values come from a bulk fill seeded by the generator of the calling
+ * thread, so they are reproducible after random_seed_global().
+ *
+ * @param instance A pointer to the vector to fill.
+ * @param min The lower bound.
+ * @param max The upper bound, excluded.
+ * @return A pointer to the filled vector, or NULL on error.
+ */
+vector *vector_random_uniform(vector *instance, NN_TYPE min, NN_TYPE max)
+{
+    VECTOR_CHECK(instance);
+    vector_prefix_invalidate(instance);
+
+    random_fill_uniform(&VECTOR(instance, 0), instance->length, min, max,
+                        random_next(random_thread()));
+
+    return instance;
+
+error:
+    return NULL;
+}
+
+/**
+ * Fills a vector with normal random values, in parallel.
+ *
+ * @param instance A pointer to the vector to fill.
+ * @param mean The mean of the values.
+ * @param deviation The standard deviation of the values.
+ * @return A pointer to the filled vector, or NULL on error.
+ */
+vector *vector_random_normal(vector *instance, NN_TYPE mean, NN_TYPE deviation)
+{
+    VECTOR_CHECK(instance);
+    vector_prefix_invalidate(instance);
+
+    random_fill_normal(&VECTOR(instance, 0), instance->length, mean, deviation,
+                       random_next(random_thread()));
+
+    return instance;
+
+error:
+    return NULL;
+}
+
 /**
  * Initializes a vector with either a default value or random values within a
  * range.
@@ -79,15 +139,16 @@ vector *vector_seed(vector *instance, NN_TYPE default_value)
 {
     // Check for NULL instance
     VECTOR_CHECK(instance);
+    vector_prefix_invalidate(instance);
 
     // Seed the vector with either default values or random values
+    if (!default_value) {
+        return vector_random_uniform(instance, -1, 1);
+    }
+
     VECTOR_FOREACH(instance)
     {
-        if (default_value) {
-            VECTOR(instance, index) = default_value;
-        } else {
-            VECTOR(instance, index) = nn_random_range(-1, 1);
-        }
+        VECTOR(instance, index) = default_value;
     }
 
     // Return the initialized vector
@@ -140,6 +201,7 @@ vector *vector_from_list(size_t length, NN_TYPE values[])
     instance->number.ref_count = 1;
     instance->length           = length;
     instance->number.values    = vector_values;
+    instance->prefix           = NULL;
 
     return instance;
 
@@ -176,7 +238,8 @@ error:
  * reshaped vector.
  *
  * @note If the new length is greater than the current length, the additional
- * elements will be initialized to 0.
+ * elements will be initialized to 0. If it is the current length, nothing is
+ * reallocated.
  */
 vector *vector_reshape(vector *instance, size_t length)
 {
@@ -185,6 +248,13 @@ vector *vector_reshape(vector *instance, size_t length)
 
     VECTOR_CHECK(instance);
 
+    // Same length: the elements and their cached prefix sums stay valid
+    if (length == instance->length) {
+        return instance;
+    }
+
+    vector_prefix_invalidate(instance);
+
     // Reallocate memory for the reshaped vector
     reshaped = realloc(instance->number.values, length * sizeof(NN_TYPE));
     CHECK_MEMORY(reshaped);
@@ -206,7 +276,8 @@ error:
 }
 
 /**
- * Shuffles the elements of a vector instance.
+ * Shuffles the elements of a vector instance, every permutation being
+ * equally likely (Fisher-Yates, or a parallel MergeShuffle for long vectors).
  *
  * @param v A pointer to the vector instance to be shuffled.
  *
@@ -214,28 +285,64 @@ error:
  */
 vector *vector_shuffle(const vector *v)
 {
-    size_t size = v->length;
-    for (size_t index = 0; index < size; index++) {
-        NN_TYPE shuffled_value;
-        size_t  shuffled;
+    VECTOR_CHECK(v);
+    vector_prefix_invalidate((vector *)v);
 
-        shuffled = (size_t)nn_random_range(0, size);
-        if (shuffled == index) {
-            if (index == size - 1) {
-                if (index != 0) {
-                    shuffled = index - 1;
-                }
-            } else {
-                shuffled = index + 1;
-            }
+    random_shuffle(&VECTOR(v, 0), v->length, sizeof(NN_TYPE), random_next(random_thread()));
+
+    return (vector *)v;
+
+error:
+    return NULL;
+}
+
+/**
+ * Reorders the elements of a vector in place, so that element `index`
+ * becomes the former element `permutation[index]`.
+ *
+ * Follows the cycles of the permutation, so every element moves once.
+ *
+ * @param instance A pointer to the vector.
+ * @param permutation A permutation of the indexes of the vector, e.g. from random_permutation().
+ * @return A pointer to the vector, or NULL on error.
+ */
+vector *vector_permute(vector *instance, const size_t *permutation)
+{
+    char *visited = NULL;
+
+    VECTOR_CHECK(instance);
+    CHECK_MEMORY(permutation);
+    vector_prefix_invalidate(instance);
+
+    visited = calloc(instance->length, 1);
+    CHECK_MEMORY(visited);
+
+    VECTOR_FOREACH(instance)
+    {
+        NN_TYPE first = VECTOR(instance, index);
+        size_t  current = index;
+
+        if (visited[index]) {
+            continue;
         }
 
-        shuffled_value      = VECTOR(v, index);
-        VECTOR(v, index)    = VECTOR(v, shuffled);
-        VECTOR(v, shuffled) = shuffled_value;
+        while (permutation[current] != index) {
+            VECTOR(instance, current) = VECTOR(instance, permutation[current]);
+            visited[current]          = 1;
+            current                   = permutation[current];
+        }
+        VECTOR(instance, current) = first;
+        visited[current]          = 1;
     }
 
-    return v;
+    free(visited);
+
+    return instance;
+
+error:
+    free(visited);
+
+    return NULL;
 }
 
 
@@ -263,22 +370,26 @@ vector *vector_shuffle(const vector *v)
 #define VECTOR_METHOD_OPERATION(name, operation)                               \
     vector *vector_##name(vector *v, const number *w)                          \
     {                                                                          \
-        int   power;                                                           \
-        void *values_added_ptr;                                                \
+        int    power;                                                          \
+        size_t blocks;                                                         \
+        void  *values_added_ptr = NULL;                                        \
                                                                                \
         VECTOR_CHECK(v);                                                       \
         NUMBER_CHECK(w);                                                       \
+        vector_prefix_invalidate(v);                                           \
                                                                                \
         /* This code uses the __builtin_clz function, which counts the         \
          * number of leading zero bits in an integer, and bit shifting         \
-         * to calculate the nearest power of 2 that is greater than or equal   \
-         * to the length of the vector. */                                     \
-        power = v->length >= 128                                               \
-                    ? 128                                                      \
-                    : 1 << (sizeof(int) * 8 - __builtin_clz(v->length));       \
+         * to calculate the largest power of 2 that is less than or equal      \
+         * to the length of the vector. Whole blocks are processed first,      \
+         * then the rest one by one. */                                        \
+        power  = v->length >= 128                                              \
+                     ? 128                                                     \
+                     : 1 << (sizeof(int) * 8 - 1 - __builtin_clz(v->length));  \
+        blocks = power > 1 ? v->length / power * power : 0;                    \
                                                                                \
         PRAGMA(omp for schedule(auto))                                         \
-        for (size_t index = 0; index < (v)->length; index = index + power) {   \
+        for (size_t index = 0; index < blocks; index = index + power) {        \
             void *block_ptr = (NN_TYPE *)(v->number.values) + index;           \
                                                                                \
             if (NN_VECTOR == w->type) {                                        \
@@ -304,7 +415,11 @@ vector *vector_shuffle(const vector *v)
                                       operation);                              \
             }                                                                  \
         }                                                                      \
-        number_unref((number*)w);                                                       \
+        for (size_t index = blocks; index < v->length; index++) {              \
+            VECTOR(v, index) = VECTOR(v, index) operation                      \
+                (NN_VECTOR == w->type ? VECTOR(w, index) : w->floated);        \
+        }                                                                      \
+        number_unref((number*)w);                                              \
                                                                                \
         return v;                                                              \
                                                                                \
@@ -319,22 +434,26 @@ VECTOR_METHOD_OPERATION(division, /);
 
 vector *vector_addition_func(vector *v, const number *w)
 {
-    int   power;
-    void *values_added_ptr;
+    int    power;
+    size_t blocks;
+    void  *values_added_ptr = NULL;
 
     VECTOR_CHECK(v);
     NUMBER_CHECK(w);
+    vector_prefix_invalidate(v);
 
     /* This code uses the __builtin_clz function, which counts the
      * number of leading zero bits in an integer, and bit shifting
-     * to calculate the nearest power of 2 that is greater than or equal to
-     * the length of the vector. */
-    power = v->length >= 128
-                ? 128
-                : 1 << (sizeof(int) * 8 - __builtin_clz(v->length));
+     * to calculate the largest power of 2 that is less than or equal to
+     * the length of the vector. Whole blocks are processed first, then the
+     * rest one by one. */
+    power  = v->length >= 128
+                 ? 128
+                 : 1 << (sizeof(int) * 8 - 1 - __builtin_clz(v->length));
+    blocks = power > 1 ? v->length / power * power : 0;
 
 #pragma omp for schedule(auto)
-    for (size_t index = 0; index < (v)->length; index = index + power) {
+    for (size_t index = 0; index < blocks; index = index + power) {
         void *block_ptr = (NN_TYPE *)(v->number.values) + index;
 
         if (NN_VECTOR == w->type) {
@@ -354,6 +473,10 @@ vector *vector_addition_func(vector *v, const number *w)
         }
     }
 
+    for (size_t index = blocks; index < v->length; index++) {
+        VECTOR(v, index) += NN_VECTOR == w->type ? VECTOR(w, index) : w->floated;
+    }
+
     number_unref((number*)w);
 
     return v;
@@ -362,6 +485,74 @@ error:
     return NULL;
 }
 
+/* Element-wise operations on strided runs, four elements at a time when `x`
+ * is contiguous and `y` is contiguous or repeats one value (stride 0) */
+#define VECTOR_RUN_OPERATION(name, operation)                                  \
+    static void vector_##name##_run(NN_TYPE *x, size_t x_stride,               \
+                                    const NN_TYPE *y, size_t y_stride,         \
+                                    size_t length)                             \
+    {                                                                          \
+        size_t index = 0;                                                      \
+                                                                               \
+        if (1 == x_stride && 1 >= y_stride) {                                  \
+            v4sf y_block = {y[0], y[0], y[0], y[0]};                           \
+                                                                               \
+            for (; index + 4 <= length; index += 4) {                          \
+                v4sf x_block;                                                  \
+                                                                               \
+                memcpy(&x_block, &x[index], sizeof(x_block));                  \
+                if (y_stride) {                                                \
+                    memcpy(&y_block, &y[index], sizeof(y_block));              \
+                }                                                              \
+                x_block = x_block operation y_block;                           \
+                memcpy(&x[index], &x_block, sizeof(x_block));                  \
+            }                                                                  \
+        }                                                                      \
+                                                                               \
+        for (; index < length; index++) {                                      \
+            x[index * x_stride] = x[index * x_stride] operation                \
+                y[index * y_stride];                                           \
+        }                                                                      \
+    }
+
+VECTOR_RUN_OPERATION(addition, +)
+VECTOR_RUN_OPERATION(subtraction, -)
+VECTOR_RUN_OPERATION(multiplication, *)
+VECTOR_RUN_OPERATION(division, /)
+
+/**
+ * Applies an element-wise operation to a strided run of values, in place,
+ * x[i * x_stride] = x[i * x_stride] operation y[i * y_stride].
+ *
+ * A `y_stride` of 0 repeats the same value of `y` along the run, which is how
+ * matrices and tensors broadcast an operand without expanding it.
+ *
+ * @param operation NN_ADDITION, NN_SUBTRACTION, NN_MULTIPLICATION or NN_DIVISION.
+ * @param x The values to update.
+ * @param x_stride The elements between two values of `x`.
+ * @param y The operand.
+ * @param y_stride The elements between two values of `y`.
+ * @param length The number of values.
+ */
+void vector_operation_values(enum nn_operation operation, NN_TYPE *x, size_t x_stride,
+                             const NN_TYPE *y, size_t y_stride, size_t length)
+{
+    switch (operation) {
+    case NN_ADDITION:
+        vector_addition_run(x, x_stride, y, y_stride, length);
+        break;
+    case NN_SUBTRACTION:
+        vector_subtraction_run(x, x_stride, y, y_stride, length);
+        break;
+    case NN_MULTIPLICATION:
+        vector_multiplication_run(x, x_stride, y, y_stride, length);
+        break;
+    case NN_DIVISION:
+        vector_division_run(x, x_stride, y, y_stride, length);
+        break;
+    }
+}
+
 /**
  * Calculates the dot product of two vectors.
  *
@@ -417,17 +608,21 @@ error:
 
 vector *vector_map(vector *v, NN_TYPE operation(NN_TYPE))
 {
-    int   power;
-    void *values_added_ptr;
+    int    power;
+    size_t blocks;
 
     VECTOR_CHECK(v);
+    vector_prefix_invalidate(v);
 
+    /* Whole blocks of the largest power of 2 that fits, then the rest one by
+     * one, so no block reaches past the end of the vector. */
     power = v->length >= 128
                 ? 128
-                : 1 << (sizeof(int) * 8 - __builtin_clz(v->length));
+                : 1 << (sizeof(int) * 8 - 1 - __builtin_clz(v->length));
+    blocks = power > 1 ? v->length / power * power : 0;
 
 #pragma omp for schedule(static)
-    for (size_t index = 0; index < (v)->length; index = index + power) {
+    for (size_t index = 0; index < blocks; index = index + power) {
         void *block_ptr = (NN_TYPE *)(v->number.values) + index;
 
         __builtin_prefetch(block_ptr + power, 1, 1);
@@ -443,6 +638,10 @@ vector *vector_map(vector *v, NN_TYPE operation(NN_TYPE))
         }
     }
 
+    for (size_t index = blocks; index < v->length; index++) {
+        VECTOR(v, index) = operation(VECTOR(v, index));
+    }
+
     return v;
 
 error:
@@ -459,17 +658,21 @@ error:
 vector *vector_map_value(vector *v, NN_TYPE operation(NN_TYPE, NN_TYPE *),
                          NN_TYPE *value)
 {
-    int   power;
-    void *values_added_ptr;
+    int    power;
+    size_t blocks;
 
     VECTOR_CHECK(v);
+    vector_prefix_invalidate(v);
 
+    /* Whole blocks of the largest power of 2 that fits, then the rest one by
+     * one, so no block reaches past the end of the vector. */
     power = v->length >= 128
                 ? 128
-                : 1 << (sizeof(int) * 8 - __builtin_clz(v->length));
+                : 1 << (sizeof(int) * 8 - 1 - __builtin_clz(v->length));
+    blocks = power > 1 ? v->length / power * power : 0;
 
 #pragma omp for schedule(static)
-    for (size_t index = 0; index < (v)->length; index = index + power) {
+    for (size_t index = 0; index < blocks; index = index + power) {
         void *block_ptr = (NN_TYPE *)(v->number.values) + index;
 
         __builtin_prefetch(block_ptr + power, 1, 1);
@@ -485,221 +688,1559 @@ vector *vector_map_value(vector *v, NN_TYPE operation(NN_TYPE, NN_TYPE *),
         }
     }
 
+    for (size_t index = blocks; index < v->length; index++) {
+        VECTOR(v, index) = operation(VECTOR(v, index), value);
+    }
+
     return v;
 
 error:
     return NULL;
 }
 
-int vector_index_of(const vector *v, NN_TYPE needle)
+/* Picks the lanes of `a` where `mask` is set and the lanes of `b` elsewhere */
+static inline v4sf vector_select(v4si mask, v4sf a, v4sf b)
 {
-    VECTOR_CHECK(v);
-
-    VECTOR_FOREACH(v)
-    {
-        if (VECTOR(v, index) == needle) {
-            return (int)index;
-        }
-    }
-
-    return -1;
+    return (v4sf)(((v4si)a & mask) | ((v4si)b & ~mask));
+}
 
-error:
-    return -1;
+/* Rounds to the nearest integer, halves away from zero */
+static inline v4si vector_round(v4sf x)
+{
+    return __builtin_convertvector(x + vector_select(x < 0, (v4sf) {0} - 0.5f, (v4sf) {0} + 0.5f), v4si);
 }
 
-NN_TYPE vector_length(const vector *v)
+/**
+ * e^x: x = n ln(2) + r with |r| <= ln(2) / 2, e^r from a polynomial and 2^n
+ * built in the exponent bits, in two halves so that results close to the
+ * float limits, including the denormals, don't overflow the exponent.
+ */
+static v4sf vector_exp_kernel(v4sf x, enum nn_accuracy accuracy)
 {
-    VECTOR_CHECK(v);
+    v4si overflow  = x > 88.7228391f;
+    v4si underflow = x < -103.972084f;
+    v4sf clamped   = vector_select(overflow, (v4sf) {0} + 88.7228391f, x);
+    v4sf result;
+    v4sf r;
+    v4si n;
+    v4si half;
+
+    clamped = vector_select(underflow, (v4sf) {0} - 103.972084f, clamped);
+    n       = vector_round(clamped * 1.44269504f);
+    r       = clamped - __builtin_convertvector(n, v4sf) * 0.693359375f
+        + __builtin_convertvector(n, v4sf) * 2.12194440e-4f;
+
+    if (NN_FAST == accuracy) {
+        result = 1 + r * (1 + r * (0.5f + r * (1.66666667e-1f + r * 4.16666667e-2f)));
+    } else {
+        result = ((((1.9875691500e-4f * r + 1.3981999507e-3f) * r + 8.3334519073e-3f) * r
+                   + 4.1665795894e-2f) * r + 1.6666665459e-1f) * r + 5.0000001201e-1f;
+        result = result * r * r + r + 1;
+    }
 
-    return sqrt(vector_dot_product(v, v));
+    half   = n >> 1;
+    result = result * (v4sf)((half + 127) << 23) * (v4sf)((n - half + 127) << 23);
 
-error:
-    return 0;
+    result = vector_select(overflow, (v4sf) {0} + INFINITY, result);
+    result = vector_select(underflow, (v4sf) {0}, result);
+
+    return vector_select(x != x, x, result);
 }
 
-NN_TYPE vector_sum(const vector *v)
+/**
+ * ln(x): x = m 2^e with m in [sqrt(1/2), sqrt(2)), then
+ * ln(m) = 2 atanh(s) with s = (m - 1) / (m + 1), |s| <= 0.172, from its odd
+ * series.
+ */
+static v4sf vector_log_kernel(v4sf x, enum nn_accuracy accuracy)
 {
-    VECTOR_CHECK(v);
-
-    NN_TYPE sum = 0;
-
-    // #pragma omp parallel for simd reduction (+:sum)
-    VECTOR_FOREACH(v) { sum += VECTOR(v, index); }
+    v4si denormal = x < 1.17549435e-38f;
+    v4sf scaled   = vector_select(denormal, x * 8388608.0f, x);
+    v4si bits     = (v4si)scaled;
+    v4si e        = ((bits >> 23) & 0xff) - 126 - (denormal & 23);
+    v4sf m        = (v4sf)((bits & 0x007fffff) | 0x3f000000);
+    v4si small    = m < 0.707106781f;
+    v4sf k;
+    v4sf s;
+    v4sf z;
+    v4sf result;
+
+    m = vector_select(small, m + m, m) - 1;
+    e = e + small;
+    k = __builtin_convertvector(e, v4sf);
+    s = m / (2 + m);
+    z = s * s;
+
+    if (NN_FAST == accuracy) {
+        result = s * (2 + z * 6.66666667e-1f) + k * 0.693147181f;
+    } else {
+        result = s * (2 + z * (6.66666667e-1f + z * (4e-1f + z * (2.85714286e-1f + z * 2.22222222e-1f))));
+        result = result + k * -2.12194440e-4f + k * 0.693359375f;
+    }
 
-    return sum;
+    result = vector_select(x == INFINITY, x, result);
+    result = vector_select(x == 0, (v4sf) {0} - INFINITY, result);
 
-error:
-    return 0;
+    return vector_select((x < 0) | (x != x), (v4sf) {0} + NAN, result);
 }
 
-NN_TYPE vector_sum_to(const vector *v, size_t to_index)
+/* |x| with the sign of `sign` */
+static inline v4sf vector_copysign(v4sf x, v4sf sign)
 {
-    VECTOR_CHECK(v);
+    return (v4sf)(((v4si)x & 0x7fffffff) | ((v4si)sign & (int)0x80000000));
+}
 
-    NN_TYPE sum = 0;
+/**
+ * tanh(x) = 1 - 2 / (e^2|x| + 1) with the sign of x, from the odd
+ * polynomial near 0 where the subtraction would cancel.
+ */
+static v4sf vector_tanh_kernel(v4sf x, enum nn_accuracy accuracy)
+{
+    v4sf a      = vector_copysign(x, (v4sf) {0});
+    v4sf z      = a * a;
+    v4sf result = 1 - 2 / (vector_exp_kernel(a + a, accuracy) + 1);
+    v4sf near   = ((((-5.70498872745e-3f * z + 2.06390887954e-2f) * z - 5.37397155531e-2f) * z
+                    + 1.33314422036e-1f) * z - 3.33332819422e-1f) * z * a + a;
 
-    VECTOR_FOREACH(v)
-    {
-        sum += VECTOR(v, index);
-        if (index == to_index) {
-            return sum;
-        }
-    }
+    result = vector_select(a < 0.625f, near, result);
 
-    return sum;
+    return vector_select(x != x, x, vector_copysign(result, x));
+}
 
-error:
-    return 0;
+static inline v4sf vector_sigmoid_kernel(v4sf x, enum nn_accuracy accuracy)
+{
+    return 1 / (1 + vector_exp_kernel(-x, accuracy));
 }
 
-NN_TYPE vector_sum_between(const vector *v, size_t from_index, size_t to_index)
+static inline v4sf vector_sqrt_kernel(v4sf x)
 {
-    VECTOR_CHECK(v);
+    v4sf result;
 
-    NN_TYPE sum = 0;
+    simde_mm_storeu_ps((NN_TYPE *)&result, simde_mm_sqrt_ps(simde_mm_loadu_ps((NN_TYPE *)&x)));
 
-    for (size_t index = from_index; index < to_index; index++) {
-        sum += VECTOR(v, index);
-    }
+    return result;
+}
 
-    return sum;
+/**
+ * Applies a kernel to `length` values four at a time, padding the last
+ * block with ones.
+ */
+#define VECTOR_MAP_KERNEL(values, length, kernel, ...)                         \
+    do {                                                                       \
+        size_t blocks = (length) / 4 * 4;                                      \
+                                                                               \
+        PRAGMA(omp parallel for schedule(static)                               \
+                   if ((length) >= VECTOR_MAP_PARALLEL))                       \
+        for (size_t index = 0; index < blocks; index += 4) {                   \
+            v4sf block;                                                        \
+                                                                               \
+            memcpy(&block, &(values)[index], sizeof(block));                   \
+            block = kernel(block, ##__VA_ARGS__);                              \
+            memcpy(&(values)[index], &block, sizeof(block));                   \
+        }                                                                      \
+                                                                               \
+        if (blocks < (length)) {                                               \
+            v4sf   block = {1, 1, 1, 1};                                       \
+            size_t tail  = ((length) - blocks) * sizeof(NN_TYPE);              \
+                                                                               \
+            memcpy(&block, &(values)[blocks], tail);                           \
+            block = kernel(block, ##__VA_ARGS__);                              \
+            memcpy(&(values)[blocks], &block, tail);                           \
+        }                                                                      \
+    } while (0)
 
-error:
-    return 0;
-}
-vector *vector_unique(const vector *instance)
+/**
+ * Raises four values to a power: e^(y ln|x|), with the sign of x for odd
+ * integer powers and NaN for negative values and fractional powers.
+ */
+static v4sf vector_pow_kernel(v4sf x, NN_TYPE exponent, enum nn_accuracy accuracy)
 {
-    size_t   size;
-    NN_TYPE *unique_values;
-    vector  *unique_vector;
-
-    VECTOR_CHECK(instance);
+    int  is_integer = exponent == floorf(exponent);
+    int  is_odd     = is_integer && fmodf(exponent, 2) != 0;
+    v4sf a          = vector_copysign(x, (v4sf) {0});
+    v4sf result;
 
-    size = 0;
-    unique_values
-        = nn_unique_numbers(instance->number.values, instance->length, &size);
-    CHECK_MEMORY(unique_values);
+    if (0 == exponent) {
+        return (v4sf) {0} + 1;
+    }
 
-    unique_vector = vector_from_list(size, unique_values);
-    free(unique_values);
+    result = vector_exp_kernel(vector_log_kernel(a, accuracy) * exponent, accuracy);
 
-    return unique_vector;
+    if (is_odd) {
+        result = vector_copysign(result, x);
+    } else if (!is_integer) {
+        result = vector_select(x < 0, (v4sf) {0} + NAN, result);
+    }
 
-error:
-    return NULL;
+    return vector_select(x != x, x, result);
 }
 
 /**
- * Returns a new vector that is the unit vector of the input vector.
- *
- * @param v A pointer to the vector to be normalized.
- *
- * @return A pointer to a new vector that is the unit vector of the input
- * vector.
- *
- * @throws NULL if the input vector is NULL.
- * @throws NULL if there is an error during the normalization process.
+ * Applies a built-in operation to every element of a vector, in place.
  *
- * This function takes a pointer to a vector and returns a new vector that is
- * the unit vector of the input vector. The input vector is not modified. The
- * unit vector is a vector with the same direction as the input vector, but with
- * a length of 1.
+ * Unlike vector_map(), the operation is not called through a pointer: four
+ * elements at a time go through a polynomial approximation, in parallel for
+ * long vectors. NN_PRECISE keeps the relative error within a few float ulps,
+ * NN_FAST trades it for shorter polynomials, within about 2e-4. NN_SQRT is
+ * always exact.
  *
+ * @param v A pointer to the vector.
+ * @param operation The operation: NN_EXP, NN_LOG, NN_TANH, NN_SIGMOID or NN_SQRT.
+ * @param accuracy NN_PRECISE or NN_FAST.
+ * @return A pointer to the vector, or NULL on error.
  */
-vector *vector_unit(const vector *v)
+vector *vector_map_builtin(vector *v, enum nn_map operation, enum nn_accuracy accuracy)
 {
-    vector *unit_vector;
     VECTOR_CHECK(v);
+    CHECK(operation <= NN_SQRT, "Unknown operation %d", operation);
+    vector_prefix_invalidate(v);
 
-    number *length = number_create(vector_length(v));
-    NUMBER_CHECK(length);
+    vector_map_builtin_values(&VECTOR(v, 0), v->length, operation, accuracy);
 
-    unit_vector = vector_division(vector_clone(v), length);
-    number_delete(length);
-
-    return unit_vector;
+    return v;
 
 error:
-    if (length) {
-        number_delete(length);
-    }
     return NULL;
 }
 
 /**
- * Calculates the L-norm of a given vector raised to a specified power.
- *
- * @param v A pointer to the vector to calculate the L-norm of.
- * @param power An integer specifying the power to raise the L-norm to.
+ * Applies a built-in operation to an array of values, in place, see
+ * vector_map_builtin().
  *
- * @return The L-norm of the vector raised to the specified power.
+ * @param values The values.
+ * @param length The number of values.
+ * @param operation The operation: NN_EXP, NN_LOG, NN_TANH, NN_SIGMOID or NN_SQRT.
+ * @param accuracy NN_PRECISE or NN_FAST.
+ */
+void vector_map_builtin_values(NN_TYPE *values, size_t length, enum nn_map operation,
+                               enum nn_accuracy accuracy)
+{
+    switch (operation) {
+    case NN_EXP:
+        VECTOR_MAP_KERNEL(values, length, vector_exp_kernel, accuracy);
+        break;
+    case NN_LOG:
+        VECTOR_MAP_KERNEL(values, length, vector_log_kernel, accuracy);
+        break;
+    case NN_TANH:
+        VECTOR_MAP_KERNEL(values, length, vector_tanh_kernel, accuracy);
+        break;
+    case NN_SIGMOID:
+        VECTOR_MAP_KERNEL(values, length, vector_sigmoid_kernel, accuracy);
+        break;
+    case NN_SQRT:
+        VECTOR_MAP_KERNEL(values, length, vector_sqrt_kernel);
+        break;
+    }
+}
+
+/**
+ * Raises every element of a vector to a power, in place, four elements at a
+ * time like vector_map_builtin().
  *
- * @throws A null pointer exception if the vector pointer is null.
- * @throws An invalid argument exception if the power is 0.
+ * @param v A pointer to the vector.
+ * @param exponent The power.
+ * @param accuracy NN_PRECISE or NN_FAST.
+ * @return A pointer to the vector, or NULL on error.
  */
-NN_TYPE vector_l_norm(const vector *v, int power)
+vector *vector_pow(vector *v, NN_TYPE exponent, enum nn_accuracy accuracy)
 {
     VECTOR_CHECK(v);
-    CHECK(power, "P = 0 for L_norm");
-
-    NN_TYPE l_norm = 0;
-
-    size_t index = v->length;
-    while (index--) {
-        l_norm += pow(fabs(VECTOR(v, index)), power);
-    }
+    vector_prefix_invalidate(v);
 
-    l_norm = pow(l_norm, (NN_TYPE)1 / power);
+    VECTOR_MAP_KERNEL(&VECTOR(v, 0), v->length, vector_pow_kernel, exponent, accuracy);
 
-    return l_norm;
+    return v;
 
 error:
-    return 0;
+    return NULL;
 }
 
-NN_TYPE vector_max_norm(const vector *v)
+/* Largest of `length` values, four at a time */
+static NN_TYPE vector_max_block(const NN_TYPE *values, size_t length)
 {
-    VECTOR_CHECK(v);
+    simde__m128 max = simde_mm_set1_ps(-INFINITY);
+    NN_TYPE     lanes[4];
+    NN_TYPE     result;
+    size_t      index;
 
-    NN_TYPE max = 0;
+    for (index = 0; index < length / 4 * 4; index += 4) {
+        max = simde_mm_max_ps(max, simde_mm_loadu_ps(&values[index]));
+    }
 
-    size_t index = v->length;
-    while (index--) {
-        NN_TYPE value = fabs(VECTOR(v, index));
-        if (value > max) {
-            max = value;
+    simde_mm_storeu_ps(lanes, max);
+    result = fmaxf(fmaxf(lanes[0], lanes[1]), fmaxf(lanes[2], lanes[3]));
+
+    for (; index < length; index++) {
+        result = fmaxf(result, values[index]);
+    }
+
+    return result;
+}
+
+/**
+ * Sums e^(x - shift) over `length` values, four at a time, and stores the
+ * exponentials in `result` unless it is NULL.
+ */
+static NN_TYPE vector_exp_sum_block(const NN_TYPE *values, NN_TYPE *result, size_t length, NN_TYPE shift)
+{
+    v4sf    sum = {0};
+    v4sf    block;
+    size_t  index;
+    size_t  tail;
+
+    for (index = 0; index < length / 4 * 4; index += 4) {
+        memcpy(&block, &values[index], sizeof(block));
+        block = vector_exp_kernel(block - shift, NN_PRECISE);
+        sum += block;
+        if (result) {
+            memcpy(&result[index], &block, sizeof(block));
         }
     }
 
-    return max;
+    tail = (length - index) * sizeof(NN_TYPE);
+    if (tail) {
+        /* e^-inf adds nothing to the sum */
+        block = (v4sf) {-INFINITY, -INFINITY, -INFINITY, -INFINITY};
+        memcpy(&block, &values[index], tail);
+        block = vector_exp_kernel(block - shift, NN_PRECISE);
+        sum += block;
+        if (result) {
+            memcpy(&result[index], &block, tail);
+        }
+    }
 
-error:
-    return 0;
+    return sum[0] + sum[1] + sum[2] + sum[3];
 }
 
-size_t vector_max_index(const vector *v)
+/* Multiplies `length` values by a factor, four at a time */
+static void vector_scale_block(NN_TYPE *values, size_t length, NN_TYPE factor)
 {
-    VECTOR_CHECK(v);
+    size_t index;
 
-    NN_TYPE max       = 0;
-    size_t  max_index = 0;
+    for (index = 0; index < length / 4 * 4; index += 4) {
+        simde_mm_storeu_ps(&values[index],
+                           simde_mm_mul_ps(simde_mm_loadu_ps(&values[index]), simde_mm_set1_ps(factor)));
+    }
 
-    size_t index = v->length;
-    while (index--) {
-        NN_TYPE value = fabs(VECTOR(v, index));
-        if (value > max) {
-            max       = value;
-            max_index = index;
-        }
+    for (; index < length; index++) {
+        values[index] *= factor;
     }
+}
 
-    return max_index;
+/**
+ * Calculates log(sum(e^x)) over an array without overflowing, by shifting
+ * the values by their maximum first.
+ *
+ * @param values The values.
+ * @param length The number of values.
+ * @return The log-sum-exp, -inf for no values.
+ */
+NN_TYPE vector_log_sum_exp_values(const NN_TYPE *values, size_t length)
+{
+    NN_TYPE max = vector_max_block(values, length);
+
+    if (isinf(max)) {
+        return max;
+    }
+
+    return max + logf(vector_exp_sum_block(values, NULL, length, max));
+}
+
+/**
+ * Replaces an array by its softmax, e^x / sum(e^x), or by its log-softmax,
+ * x - log(sum(e^x)), in place.
+ *
+ * Takes a pass for the maximum, one for the exponentials and their sum,
+ * and one to scale (softmax) or shift (log-softmax) the values.
+ *
+ * @param values The values.
+ * @param length The number of values.
+ * @param is_log 1 for the log-softmax, 0 for the softmax.
+ */
+void vector_softmax_values(NN_TYPE *values, size_t length, int is_log)
+{
+    NN_TYPE max = vector_max_block(values, length);
+
+    if (is_log) {
+        NN_TYPE shift = max + logf(vector_exp_sum_block(values, NULL, length, max));
+        size_t  index;
+
+        for (index = 0; index < length / 4 * 4; index += 4) {
+            simde_mm_storeu_ps(&values[index], simde_mm_sub_ps(simde_mm_loadu_ps(&values[index]),
+                                                                simde_mm_set1_ps(shift)));
+        }
+        for (; index < length; index++) {
+            values[index] -= shift;
+        }
+    } else {
+        vector_scale_block(values, length, 1 / vector_exp_sum_block(values, values, length, max));
+    }
+}
+
+/**
+ * Divides an array by its L1 norm, sum(|x|), or its L2 norm, sqrt(sum(x^2)),
+ * in place. An array of zeros is left unchanged.
+ *
+ * @param values The values.
+ * @param length The number of values.
+ * @param power 1 for the L1 norm, 2 for the L2 norm.
+ */
+void vector_normalize_values(NN_TYPE *values, size_t length, int power)
+{
+    simde__m128 sum  = simde_mm_setzero_ps();
+    simde__m128 sign = simde_mm_set1_ps(-0.0f);
+    NN_TYPE     lanes[4];
+    NN_TYPE     norm;
+    size_t      index;
+
+    for (index = 0; index < length / 4 * 4; index += 4) {
+        simde__m128 block = simde_mm_loadu_ps(&values[index]);
+
+        sum = simde_mm_add_ps(sum, 1 == power ? simde_mm_andnot_ps(sign, block) : simde_mm_mul_ps(block, block));
+    }
+
+    simde_mm_storeu_ps(lanes, sum);
+    norm = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    for (; index < length; index++) {
+        norm += 1 == power ? fabsf(values[index]) : values[index] * values[index];
+    }
+
+    if (2 == power) {
+        norm = sqrtf(norm);
+    }
+
+    if (norm > 0) {
+        vector_scale_block(values, length, 1 / norm);
+    }
+}
+
+/**
+ * Calculates log(sum(e^x)) over the elements of a vector without
+ * overflowing.
+ *
+ * @param v A pointer to the vector.
+ * @return The log-sum-exp, or 0 on error.
+ */
+NN_TYPE vector_log_sum_exp(const vector *v)
+{
+    VECTOR_CHECK(v);
+
+    return vector_log_sum_exp_values(&VECTOR(v, 0), v->length);
+
+error:
+    return 0;
+}
+
+/**
+ * Replaces the elements of a vector by their softmax, e^x / sum(e^x), in a
+ * numerically stable way.
+ *
+ * @param v A pointer to the vector.
+ * @return A pointer to the vector, or NULL on error.
+ */
+vector *vector_softmax(vector *v)
+{
+    VECTOR_CHECK(v);
+    vector_prefix_invalidate(v);
+
+    vector_softmax_values(&VECTOR(v, 0), v->length, 0);
+
+    return v;
+
+error:
+    return NULL;
+}
+
+/**
+ * Replaces the elements of a vector by their log-softmax,
+ * x - log(sum(e^x)).
+ *
+ * @param v A pointer to the vector.
+ * @return A pointer to the vector, or NULL on error.
+ */
+vector *vector_log_softmax(vector *v)
+{
+    VECTOR_CHECK(v);
+    vector_prefix_invalidate(v);
+
+    vector_softmax_values(&VECTOR(v, 0), v->length, 1);
+
+    return v;
+
+error:
+    return NULL;
+}
+
+/**
+ * Divides a vector by its L1 or L2 norm, in place.
+ *
+ * @param v A pointer to the vector.
+ * @param power 1 for the L1 norm, 2 for the L2 norm.
+ * @return A pointer to the vector, or NULL on error.
+ */
+vector *vector_normalize(vector *v, int power)
+{
+    VECTOR_CHECK(v);
+    CHECK(1 == power || 2 == power, "Normalization supports the L1 and L2 norms, not L%d", power);
+    vector_prefix_invalidate(v);
+
+    vector_normalize_values(&VECTOR(v, 0), v->length, power);
+
+    return v;
+
+error:
+    return NULL;
+}
+
+/**
+ * Finds the first element of a vector equal to a value.
+ *
+ * Compares four elements at a time and picks the first match from the
+ * movemask of the comparison.
+ *
+ * @param v A pointer to the vector.
+ * @param needle The value to look for.
+ * @return The index of the first equal element, or -1 if there is none.
+ */
+int vector_index_of(const vector *v, NN_TYPE needle)
+{
+    simde__m128 needles = simde_mm_set1_ps(needle);
+    size_t      index;
+
+    VECTOR_CHECK(v);
+
+    for (index = 0; index < v->length / 4 * 4; index += 4) {
+        int mask = simde_mm_movemask_ps(simde_mm_cmpeq_ps(simde_mm_loadu_ps(&VECTOR(v, index)), needles));
+
+        if (mask) {
+            return (int)(index + __builtin_ctz(mask));
+        }
+    }
+
+    for (; index < v->length; index++) {
+        if (VECTOR(v, index) == needle) {
+            return (int)index;
+        }
+    }
+
+    return -1;
+
+error:
+    return -1;
+}
+
+/**
+ * Finds the first element of a vector equal to each of many values.
+ *
+ * Few needles, or short vectors, are scanned in parallel. When scanning would cost more
+ * than sorting, the vector is argsorted once and every needle is found with
+ * a binary search, O((n + m) log n) instead of O(n * m).
+ *
+ * @param v A pointer to the vector.
+ * @param needles The values to look for.
+ * @param result An array of at least as many indexes as needles for the results, or NULL to allocate one.
+ * @return The array with the index of every needle, -1 for the missing ones, or NULL on error.
+ */
+int *vector_index_of_batch(const vector *v, const vector *needles, int *result)
+{
+    int    *allocated = NULL;
+    size_t *order     = NULL;
+    vector *sorted    = NULL;
+
+    VECTOR_CHECK(v);
+    VECTOR_CHECK(needles);
+
+    if (!result) {
+        result = allocated = malloc(needles->length * sizeof(int));
+        CHECK_MEMORY(result);
+    }
+
+    if (needles->length < VECTOR_SEARCH_SORTED || v->length < VECTOR_SEARCH_SORTED) {
+        #pragma omp parallel for
+        for (size_t needle = 0; needle < needles->length; needle++) {
+            result[needle] = vector_index_of(v, VECTOR(needles, needle));
+        }
+
+        return result;
+    }
+
+    /* Stable order, so the first of equal elements is the smallest index */
+    order = vector_argsort(v, NULL);
+    CHECK_MEMORY(order);
+    sorted = vector_create(v->length);
+    VECTOR_CHECK(sorted);
+    VECTOR_FOREACH(v)
+    {
+        VECTOR(sorted, index) = VECTOR(v, order[index]);
+    }
+
+    #pragma omp parallel for
+    for (size_t needle = 0; needle < needles->length; needle++) {
+        size_t rank = vector_lower_bound(sorted, VECTOR(needles, needle));
+
+        result[needle] = rank < sorted->length && VECTOR(sorted, rank) == VECTOR(needles, needle)
+                             ? (int)order[rank]
+                             : -1;
+    }
+
+    free(order);
+    number_delete(sorted);
+
+    return result;
+
+error:
+    free(allocated);
+    free(order);
+    if (sorted) {
+        number_delete(sorted);
+    }
+
+    return NULL;
+}
+
+/**
+ * Finds the first element of a sorted vector not smaller than a value.
+ *
+ * Branchless binary search: the halving step is a conditional move, so the
+ * loop runs log2(n) iterations without mispredictions.
+ *
+ * @param sorted A pointer to a vector sorted in ascending order.
+ * @param needle The value to look for.
+ * @return The index of the first element not smaller than the needle, or the length of the vector.
+ */
+size_t vector_lower_bound(const vector *sorted, NN_TYPE needle)
+{
+    const NN_TYPE *base;
+    size_t         length;
+
+    VECTOR_CHECK(sorted);
+
+    if (!sorted->length) {
+        return 0;
+    }
+
+    base   = &VECTOR(sorted, 0);
+    length = sorted->length;
+
+    while (length > 1) {
+        size_t half = length / 2;
+
+        base = base[half - 1] < needle ? base + half : base;
+        length -= half;
+    }
+
+    return (size_t)(base - &VECTOR(sorted, 0)) + (*base < needle);
+
+error:
+    return 0;
+}
+
+/* Fills an Eytzinger layout from sorted values, in order of a BFS of the tree */
+static size_t vector_eytzinger_fill(const vector *sorted, vector *layout, size_t rank, size_t node)
+{
+    if (node <= layout->length) {
+        rank                     = vector_eytzinger_fill(sorted, layout, rank, 2 * node);
+        VECTOR(layout, node - 1) = VECTOR(sorted, rank++);
+        rank                     = vector_eytzinger_fill(sorted, layout, rank, 2 * node + 1);
+    }
+
+    return rank;
+}
+
+/**
+ * Lays a sorted vector out in Eytzinger (BFS) order, where the children of
+ * element k - 1 are the elements 2k - 1 and 2k. Searches then walk down
+ * contiguous cache lines and can prefetch several levels ahead, which pays
+ * off on large event lists.
+ *
+ * @param sorted A pointer to a vector sorted in ascending order.
+ * @param result A vector of the same length for the layout, or NULL to allocate one.
+ * @return The vector in Eytzinger order, or NULL on error.
+ */
+vector *vector_eytzinger(const vector *sorted, vector *result)
+{
+    VECTOR_CHECK(sorted);
+    CHECK(!result || result->length == sorted->length, "Layout should have %zu elements", sorted->length);
+
+    if (!result) {
+        result = vector_create(sorted->length);
+        VECTOR_CHECK(result);
+    }
+
+    vector_eytzinger_fill(sorted, result, 0, 1);
+
+    return result;
+
+error:
+    return NULL;
+}
+
+/**
+ * Finds the first element of an Eytzinger layout not smaller than a value.
+ *
+ * @param layout A pointer to a vector from vector_eytzinger().
+ * @param needle The value to look for.
+ * @return The index in the layout of the first element not smaller than the needle, or the length of the layout.
+ */
+size_t vector_eytzinger_lower_bound(const vector *layout, NN_TYPE needle)
+{
+    const NN_TYPE *values;
+    size_t         node = 1;
+
+    VECTOR_CHECK(layout);
+
+    values = &VECTOR(layout, 0);
+
+    while (node <= layout->length) {
+        /* The 16 great-great-grandchildren share one or two cache lines */
+        __builtin_prefetch(values + 16 * node - 1);
+        node = 2 * node + (values[node - 1] < needle);
+    }
+
+    /* Climb back up past the right turns to the last left turn */
+    node >>= __builtin_ffsll(~node);
+
+    return node ? node - 1 : layout->length;
+
+error:
+    return 0;
+}
+
+NN_TYPE vector_length(const vector *v)
+{
+    VECTOR_CHECK(v);
+
+    return sqrt(vector_dot_product(v, v));
+
+error:
+    return 0;
+}
+
+/**
+ * Inclusive scan of `length` values into `result`, starting from `carry`,
+ * four values at a time: the lanes of a block are summed with two shifted
+ * additions, then the running total is added to all of them.
+ *
+ * @return The total of the carry and the values.
+ */
+static NN_TYPE vector_scan_block(const NN_TYPE *values, NN_TYPE *result, size_t length, NN_TYPE carry)
+{
+    size_t index;
+
+    for (index = 0; index < length / 4 * 4; index += 4) {
+        v4sf block;
+
+        memcpy(&block, &values[index], sizeof(block));
+        block += (v4sf) {0, block[0], block[1], block[2]};
+        block += (v4sf) {0, 0, block[0], block[1]};
+        block += carry;
+        memcpy(&result[index], &block, sizeof(block));
+
+        carry = block[3];
+    }
+
+    for (; index < length; index++) {
+        carry += values[index];
+        result[index] = carry;
+    }
+
+    return carry;
+}
+
+/* Sums `length` values four at a time */
+static NN_TYPE vector_sum_block(const NN_TYPE *values, size_t length)
+{
+    simde__m128 sum = simde_mm_setzero_ps();
+    NN_TYPE      lanes[4];
+    NN_TYPE      total;
+    size_t       index;
+
+    for (index = 0; index < length / 4 * 4; index += 4) {
+        sum = simde_mm_add_ps(sum, simde_mm_loadu_ps(&values[index]));
+    }
+
+    simde_mm_storeu_ps(lanes, sum);
+    total = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+
+    for (; index < length; index++) {
+        total += values[index];
+    }
+
+    return total;
+}
+
+/**
+ * Scans `length` values into `result`, which may be the values themselves.
+ *
+ * Long inputs take two parallel passes: every thread sums its chunk, then
+ * scans it from the total of the chunks before it.
+ *
+ * @param is_inclusive 1 for inclusive sums, 0 for exclusive ones.
+ */
+static void vector_scan_values(const NN_TYPE *values, NN_TYPE *result, size_t length, int is_inclusive)
+{
+    size_t   chunks = length >= VECTOR_SCAN_PARALLEL ? (size_t)omp_get_max_threads() : 1;
+    NN_TYPE  carries[chunks + 1];
+
+    carries[0] = 0;
+
+    if (chunks > 1) {
+        #pragma omp parallel for num_threads(chunks)
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            size_t begin = length * chunk / chunks;
+
+            carries[chunk + 1] = vector_sum_block(&values[begin], length * (chunk + 1) / chunks - begin);
+        }
+
+        for (size_t chunk = 1; chunk <= chunks; chunk++) {
+            carries[chunk] += carries[chunk - 1];
+        }
+    }
+
+    #pragma omp parallel for num_threads(chunks)
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        size_t begin = length * chunk / chunks;
+
+        vector_scan_block(&values[begin], &result[begin], length * (chunk + 1) / chunks - begin,
+                          carries[chunk]);
+    }
+
+    if (!is_inclusive && length) {
+        /* Inclusive sums shifted by one, which also works in place */
+        memmove(&result[1], &result[0], (length - 1) * sizeof(NN_TYPE));
+        result[0] = 0;
+    }
+}
+
+/**
+ * Calculates the inclusive prefix sums of a vector: element i of the result
+ * is the sum of the elements 0 .. i.
+ *
+ * @param v A pointer to the vector.
+ * @param result A vector of the same length for the sums, `v` itself to scan in place, or NULL to allocate one.
+ * @return The vector with the sums, or NULL on error.
+ */
+vector *vector_scan_inclusive(const vector *v, vector *result)
+{
+    VECTOR_CHECK(v);
+    CHECK(!result || result->length == v->length, "Result should have %zu elements", v->length);
+
+    if (!result) {
+        result = vector_create(v->length);
+        VECTOR_CHECK(result);
+    }
+
+    vector_prefix_invalidate(result);
+    vector_scan_values(&VECTOR(v, 0), &VECTOR(result, 0), v->length, 1);
+
+    return result;
+
+error:
+    return NULL;
+}
+
+/**
+ * Calculates the exclusive prefix sums of a vector: element i of the result
+ * is the sum of the elements 0 .. i - 1, the first one is 0.
+ *
+ * @param v A pointer to the vector.
+ * @param result A vector of the same length for the sums, `v` itself to scan in place, or NULL to allocate one.
+ * @return The vector with the sums, or NULL on error.
+ */
+vector *vector_scan_exclusive(const vector *v, vector *result)
+{
+    VECTOR_CHECK(v);
+    CHECK(!result || result->length == v->length, "Result should have %zu elements", v->length);
+
+    if (!result) {
+        result = vector_create(v->length);
+        VECTOR_CHECK(result);
+    }
+
+    vector_prefix_invalidate(result);
+    vector_scan_values(&VECTOR(v, 0), &VECTOR(result, 0), v->length, 0);
+
+    return result;
+
+error:
+    return NULL;
+}
+
+/**
+ * Attaches cached prefix sums to a vector, so vector_sum_to() and
+ * vector_sum_between() answer in O(1).
+ *
+ * The library functions that modify a vector drop its cache. Code writing
+ * elements directly with VECTOR() should call vector_prefix_invalidate().
+ *
+ * @param v A pointer to the vector.
+ * @return The same vector, or NULL on error.
+ */
+vector *vector_prefix_cache(vector *v)
+{
+    VECTOR_CHECK(v);
+
+    if (!v->prefix) {
+        v->prefix = malloc((v->length + 1) * sizeof(NN_TYPE));
+        CHECK_MEMORY(v->prefix);
+
+        v->prefix[0] = 0;
+        vector_scan_values(&VECTOR(v, 0), &v->prefix[1], v->length, 1);
+    }
+
+    return v;
+
+error:
+    return NULL;
+}
+
+/**
+ * Drops the cached prefix sums of a vector, if any.
+ *
+ * @param v A pointer to the vector.
+ */
+void vector_prefix_invalidate(vector *v)
+{
+    if (v && v->prefix) {
+        free(v->prefix);
+        v->prefix = NULL;
+    }
+}
+
+NN_TYPE vector_sum(const vector *v)
+{
+    VECTOR_CHECK(v);
+
+    return vector_sum_block(&VECTOR(v, 0), v->length);
+
+error:
+    return 0;
+}
+
+/**
+ * Sums the elements 0 .. to_index of a vector, in O(1) when the vector has
+ * cached prefix sums.
+ *
+ * @param v A pointer to the vector.
+ * @param to_index The index of the last element to sum.
+ * @return The sum.
+ */
+NN_TYPE vector_sum_to(const vector *v, size_t to_index)
+{
+    size_t length;
+
+    VECTOR_CHECK(v);
+
+    length = to_index < v->length ? to_index + 1 : v->length;
+    if (v->prefix) {
+        return v->prefix[length];
+    }
+
+    return vector_sum_block(&VECTOR(v, 0), length);
+
+error:
+    return 0;
+}
+
+/**
+ * Sums the elements from_index .. to_index - 1 of a vector, in O(1) when the
+ * vector has cached prefix sums.
+ *
+ * @param v A pointer to the vector.
+ * @param from_index The index of the first element to sum.
+ * @param to_index The index after the last element to sum.
+ * @return The sum.
+ */
+NN_TYPE vector_sum_between(const vector *v, size_t from_index, size_t to_index)
+{
+    VECTOR_CHECK(v);
+    CHECK(to_index <= v->length, "Index %zu out of %zu elements", to_index, v->length);
+
+    if (from_index >= to_index) {
+        return 0;
+    }
+    if (v->prefix) {
+        return v->prefix[to_index] - v->prefix[from_index];
+    }
+
+    return vector_sum_block(&VECTOR(v, from_index), to_index - from_index);
+
+error:
+    return 0;
+}
+
+vector *vector_unique(const vector *instance)
+{
+    size_t   size;
+    NN_TYPE *unique_values;
+    vector  *unique_vector;
+
+    VECTOR_CHECK(instance);
+
+    size = 0;
+    unique_values
+        = nn_unique_numbers(instance->number.values, instance->length, &size);
+    CHECK_MEMORY(unique_values);
+
+    unique_vector = vector_from_list(size, unique_values);
+    free(unique_values);
+
+    return unique_vector;
+
+error:
+    return NULL;
+}
+
+/**
+ * Returns a new vector that is the unit vector of the input vector.
+ *
+ * @param v A pointer to the vector to be normalized.
+ *
+ * @return A pointer to a new vector that is the unit vector of the input
+ * vector.
+ *
+ * @throws NULL if the input vector is NULL.
+ * @throws NULL if there is an error during the normalization process.
+ *
+ * This function takes a pointer to a vector and returns a new vector that is
+ * the unit vector of the input vector. The input vector is not modified. The
+ * unit vector is a vector with the same direction as the input vector, but with
+ * a length of 1.
+ *
+ */
+vector *vector_unit(const vector *v)
+{
+    VECTOR_CHECK(v);
+
+    return vector_normalize(vector_clone(v), 2);
+
+error:
+    return NULL;
+}
+
+/**
+ * Calculates the L-norm of a given vector raised to a specified power.
+ *
+ * @param v A pointer to the vector to calculate the L-norm of.
+ * @param power An integer specifying the power to raise the L-norm to.
+ *
+ * @return The L-norm of the vector raised to the specified power.
+ *
+ * @throws A null pointer exception if the vector pointer is null.
+ * @throws An invalid argument exception if the power is 0.
+ */
+NN_TYPE vector_l_norm(const vector *v, int power)
+{
+    VECTOR_CHECK(v);
+    CHECK(power, "P = 0 for L_norm");
+
+    NN_TYPE l_norm = 0;
+
+    size_t index = v->length;
+    while (index--) {
+        l_norm += pow(fabs(VECTOR(v, index)), power);
+    }
+
+    l_norm = pow(l_norm, (NN_TYPE)1 / power);
+
+    return l_norm;
+
+error:
+    return 0;
+}
+
+NN_TYPE vector_max_norm(const vector *v)
+{
+    VECTOR_CHECK(v);
+
+    NN_TYPE max = 0;
+
+    size_t index = v->length;
+    while (index--) {
+        NN_TYPE value = fabs(VECTOR(v, index));
+        if (value > max) {
+            max = value;
+        }
+    }
+
+    return max;
+
+error:
+    return 0;
+}
+
+size_t vector_max_index(const vector *v)
+{
+    VECTOR_CHECK(v);
+
+    NN_TYPE max       = 0;
+    size_t  max_index = 0;
+
+    size_t index = v->length;
+    while (index--) {
+        NN_TYPE value = fabs(VECTOR(v, index));
+        if (value > max) {
+            max       = value;
+            max_index = index;
+        }
+    }
+
+    return max_index;
 
 error:
     return 0;
 }
 
+/**
+ * Maps a float to an unsigned key with the same order, so floats can be
+ * radix sorted by their bit patterns: negative floats get all their bits
+ * flipped, positive ones only their sign bit. NaNs lose their sign bit, so
+ * all of them sort after +inf.
+ */
+static inline uint32_t vector_sort_key(NN_TYPE value)
+{
+    uint32_t bits;
+
+    memcpy(&bits, &value, sizeof(bits));
+    bits = (bits & 0x7FFFFFFFu) > 0x7F800000u ? bits & 0x7FFFFFFFu : bits;
+
+    return bits ^ ((uint32_t)((int32_t)bits >> 31) | 0x80000000u);
+}
+
+/* Inverse of vector_sort_key() */
+static inline NN_TYPE vector_sort_value(uint32_t key)
+{
+    uint32_t bits = key ^ (((key >> 31) - 1) | 0x80000000u);
+    NN_TYPE  value;
+
+    memcpy(&value, &bits, sizeof(value));
+
+    return value;
+}
+
+/**
+ * Stable LSD radix sort of keys, 8 bits per pass, carrying their indexes
+ * along when `indexes` isn't NULL.
+ *
+ * Long inputs are cut in one chunk per thread: every chunk counts its digits
+ * in parallel, then scatters to its own offsets in parallel, so the sort
+ * stays stable. Passes where all keys share a digit are skipped.
+ *
+ * @param keys The keys, sorted in place.
+ * @param indexes The indexes carried along, or NULL.
+ * @param length The number of keys.
+ * @return 0 on success, 1 on failure.
+ */
+static int vector_radix_sort(uint32_t *keys, size_t *indexes, size_t length)
+{
+    size_t    chunks          = length >= VECTOR_SORT_PARALLEL ? (size_t)omp_get_max_threads() : 1;
+    size_t  (*counts)[256]    = NULL;
+    uint32_t *keys_buffer     = NULL;
+    size_t   *indexes_buffer  = NULL;
+    uint32_t *from_keys       = keys;
+    size_t   *from_indexes    = indexes;
+
+    counts = malloc(chunks * sizeof(*counts));
+    CHECK_MEMORY(counts);
+    keys_buffer = malloc(length * sizeof(uint32_t));
+    CHECK_MEMORY(keys_buffer);
+    if (indexes) {
+        indexes_buffer = malloc(length * sizeof(size_t));
+        CHECK_MEMORY(indexes_buffer);
+    }
+
+    for (int shift = 0; shift < 32; shift += 8) {
+        uint32_t *to_keys    = from_keys == keys ? keys_buffer : keys;
+        size_t   *to_indexes = from_indexes == indexes ? indexes_buffer : indexes;
+        size_t    offset     = 0;
+        int       is_skipped = 0;
+
+        #pragma omp parallel for num_threads(chunks)
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            memset(counts[chunk], 0, sizeof(counts[chunk]));
+            for (size_t index = length * chunk / chunks; index < length * (chunk + 1) / chunks; index++) {
+                counts[chunk][(from_keys[index] >> shift) & 0xFF]++;
+            }
+        }
+
+        /* Offsets of every chunk in every digit, digit by digit */
+        for (size_t digit = 0; digit < 256; digit++) {
+            size_t total = 0;
+
+            for (size_t chunk = 0; chunk < chunks; chunk++) {
+                size_t count = counts[chunk][digit];
+
+                counts[chunk][digit] = offset + total;
+                total += count;
+            }
+
+            is_skipped |= total == length;
+            offset += total;
+        }
+
+        if (is_skipped) {
+            continue;
+        }
+
+        #pragma omp parallel for num_threads(chunks)
+        for (size_t chunk = 0; chunk < chunks; chunk++) {
+            for (size_t index = length * chunk / chunks; index < length * (chunk + 1) / chunks; index++) {
+                size_t position = counts[chunk][(from_keys[index] >> shift) & 0xFF]++;
+
+                to_keys[position] = from_keys[index];
+                if (indexes) {
+                    to_indexes[position] = from_indexes[index];
+                }
+            }
+        }
+
+        from_keys    = to_keys;
+        from_indexes = to_indexes;
+    }
+
+    if (from_keys != keys) {
+        memcpy(keys, from_keys, length * sizeof(uint32_t));
+        if (indexes) {
+            memcpy(indexes, from_indexes, length * sizeof(size_t));
+        }
+    }
+
+    free(counts);
+    free(keys_buffer);
+    free(indexes_buffer);
+
+    return 0;
+
+error:
+    free(counts);
+    free(keys_buffer);
+    free(indexes_buffer);
+
+    return 1;
+}
+
+/**
+ * Sorts the elements of a vector in ascending order, in place.
+ *
+ * Radix sort on the bit patterns of the elements, O(n) and parallel for
+ * long vectors. NaNs go last.
+ *
+ * @param instance A pointer to the vector.
+ * @return A pointer to the sorted vector, or NULL on error.
+ */
+vector *vector_sort(vector *instance)
+{
+    uint32_t *keys = NULL;
+
+    VECTOR_CHECK(instance);
+    vector_prefix_invalidate(instance);
+
+    keys = malloc(instance->length * sizeof(uint32_t));
+    CHECK_MEMORY(keys);
+
+    #pragma omp parallel for simd if (instance->length >= VECTOR_SORT_PARALLEL)
+    for (size_t index = 0; index < instance->length; index++) {
+        keys[index] = vector_sort_key(VECTOR(instance, index));
+    }
+
+    CHECK(vector_radix_sort(keys, NULL, instance->length) == 0, "Radix sort failed");
+
+    #pragma omp parallel for simd if (instance->length >= VECTOR_SORT_PARALLEL)
+    for (size_t index = 0; index < instance->length; index++) {
+        VECTOR(instance, index) = vector_sort_value(keys[index]);
+    }
+
+    free(keys);
+
+    return instance;
+
+error:
+    free(keys);
+
+    return NULL;
+}
+
+/**
+ * Finds the order of the elements of a vector: the indexes of its elements
+ * from the smallest to the largest. Equal elements keep their order.
+ *
+ * @param instance A pointer to the vector.
+ * @param indexes An array of at least as many indexes as elements for the result, or NULL to allocate one.
+ * @return The array of indexes, to be freed by the caller if allocated, or NULL on error.
+ */
+size_t *vector_argsort(const vector *instance, size_t *indexes)
+{
+    uint32_t *keys      = NULL;
+    size_t   *allocated = NULL;
+
+    VECTOR_CHECK(instance);
+
+    keys = malloc(instance->length * sizeof(uint32_t));
+    CHECK_MEMORY(keys);
+    if (!indexes) {
+        indexes = allocated = malloc(instance->length * sizeof(size_t));
+        CHECK_MEMORY(indexes);
+    }
+
+    #pragma omp parallel for simd if (instance->length >= VECTOR_SORT_PARALLEL)
+    for (size_t index = 0; index < instance->length; index++) {
+        keys[index]    = vector_sort_key(VECTOR(instance, index));
+        indexes[index] = index;
+    }
+
+    CHECK(vector_radix_sort(keys, indexes, instance->length) == 0, "Radix sort failed");
+
+    free(keys);
+
+    return indexes;
+
+error:
+    free(keys);
+    free(allocated);
+
+    return NULL;
+}
+
+/**
+ * Selects the element that would be at position `n` if the vector were
+ * sorted, like C++ nth_element: the vector is reordered in place so that no
+ * element before `n` is greater and no element after it is smaller.
+ *
+ * Quickselect with median of three pivots, O(n) on average. Elements are
+ * compared by their sort keys, so NaNs rank last like in vector_sort().
+ *
+ * @param instance A pointer to the vector.
+ * @param n The position in sorted order.
+ * @return The n-th smallest element, or NAN on error.
+ */
+NN_TYPE vector_nth(vector *instance, size_t n)
+{
+    size_t   low;
+    size_t   high;
+    NN_TYPE *values;
+
+    VECTOR_CHECK(instance);
+    CHECK(n < instance->length, "Position %zu out of %zu elements", n, instance->length);
+    vector_prefix_invalidate(instance);
+
+    values = &VECTOR(instance, 0);
+    low    = 0;
+    high   = instance->length - 1;
+
+    while (low < high) {
+        size_t   middle = low + (high - low) / 2;
+        uint32_t pivot;
+        size_t   left  = low;
+        size_t   right = high;
+
+        /* Median of three */
+        if (vector_sort_key(values[middle]) < vector_sort_key(values[low])) NN_SWAP(values[middle], values[low]);
+        if (vector_sort_key(values[high]) < vector_sort_key(values[low])) NN_SWAP(values[high], values[low]);
+        if (vector_sort_key(values[high]) < vector_sort_key(values[middle])) NN_SWAP(values[high], values[middle]);
+        pivot = vector_sort_key(values[middle]);
+
+        while (left <= right) {
+            while (vector_sort_key(values[left]) < pivot) left++;
+            while (vector_sort_key(values[right]) > pivot) right--;
+            if (left <= right) {
+                NN_SWAP(values[left], values[right]);
+                left++;
+                if (right == 0) {
+                    break;
+                }
+                right--;
+            }
+        }
+
+        if (n <= right) {
+            high = right;
+        } else if (n >= left) {
+            low = left;
+        } else {
+            break;
+        }
+    }
+
+    return values[n];
+
+error:
+    return NAN;
+}
+
+/* A (value, index) pair in a top-k heap */
+struct vector_ranked {
+    NN_TYPE value;
+    size_t  index;
+};
+
+/* Restores a min-heap of ranked elements from its root down */
+static void vector_heap_down(struct vector_ranked *heap, size_t size, size_t parent)
+{
+    for (;;) {
+        size_t smallest = parent;
+        size_t left     = 2 * parent + 1;
+        size_t right    = left + 1;
+
+        if (left < size && heap[left].value < heap[smallest].value) smallest = left;
+        if (right < size && heap[right].value < heap[smallest].value) smallest = right;
+        if (smallest == parent) {
+            return;
+        }
+
+        NN_SWAP(heap[parent], heap[smallest]);
+        parent = smallest;
+    }
+}
+
+/* Offers an element to a min-heap holding the k largest elements seen so far */
+static void vector_heap_offer(struct vector_ranked *heap, size_t *size, size_t k, NN_TYPE value, size_t index)
+{
+    if (*size < k) {
+        size_t child = (*size)++;
+
+        heap[child] = (struct vector_ranked) {value, index};
+        while (child && heap[(child - 1) / 2].value > heap[child].value) {
+            NN_SWAP(heap[(child - 1) / 2], heap[child]);
+            child = (child - 1) / 2;
+        }
+    } else if (value > heap[0].value) {
+        heap[0] = (struct vector_ranked) {value, index};
+        vector_heap_down(heap, k, 0);
+    }
+}
+
+/**
+ * Finds the indexes of the `k` largest elements of a vector, from the
+ * largest down.
+ *
+ * Every thread keeps a min-heap of the k largest elements of its part of
+ * the vector, O(n log k), then the heaps are merged.
+ *
+ * @param instance A pointer to the vector.
+ * @param k The number of elements, at most the length of the vector.
+ * @param indexes An array of at least `k` indexes for the result, or NULL to allocate one.
+ * @return The array of indexes, to be freed by the caller if allocated, or NULL on error.
+ */
+size_t *vector_top_k(const vector *instance, size_t k, size_t *indexes)
+{
+    size_t                chunks    = 1;
+    struct vector_ranked *heaps     = NULL;
+    size_t               *sizes     = NULL;
+    size_t               *allocated = NULL;
+    size_t                size      = 0;
+
+    VECTOR_CHECK(instance);
+    CHECK(k && k <= instance->length, "Can't find %zu of %zu elements", k, instance->length);
+
+    if (instance->length >= VECTOR_SORT_PARALLEL) {
+        chunks = (size_t)omp_get_max_threads();
+    }
+
+    heaps = malloc(chunks * k * sizeof(struct vector_ranked));
+    CHECK_MEMORY(heaps);
+    sizes = calloc(chunks, sizeof(size_t));
+    CHECK_MEMORY(sizes);
+    if (!indexes) {
+        indexes = allocated = malloc(k * sizeof(size_t));
+        CHECK_MEMORY(indexes);
+    }
+
+    #pragma omp parallel for num_threads(chunks)
+    for (size_t chunk = 0; chunk < chunks; chunk++) {
+        for (size_t index = instance->length * chunk / chunks;
+             index < instance->length * (chunk + 1) / chunks; index++) {
+            vector_heap_offer(&heaps[chunk * k], &sizes[chunk], k, VECTOR(instance, index), index);
+        }
+    }
+
+    /* The first heap collects the others */
+    size = sizes[0];
+    for (size_t chunk = 1; chunk < chunks; chunk++) {
+        for (size_t element = 0; element < sizes[chunk]; element++) {
+            vector_heap_offer(heaps, &size, k, heaps[chunk * k + element].value,
+                              heaps[chunk * k + element].index);
+        }
+    }
+
+    /* Popping the min-heap gives the largest element last */
+    while (size) {
+        indexes[size - 1] = heaps[0].index;
+        heaps[0]          = heaps[--size];
+        vector_heap_down(heaps, size, 0);
+    }
+
+    free(heaps);
+    free(sizes);
+
+    return indexes;
+
+error:
+    free(heaps);
+    free(sizes);
+    free(allocated);
+
+    return NULL;
+}
+
+/**
+ * Calculates quantiles of the elements of a vector, interpolating linearly
+ * between the closest ranks.
+ *
+ * The elements are sorted once for all the quantiles, in parallel for long
+ * vectors. NaN elements sort last, so they only show up in the upper
+ * quantiles.
+ *
+ * @param instance A pointer to the vector.
+ * @param probabilities The probabilities of the quantiles, in [0, 1].
+ * @param result A vector of at least as many elements as probabilities for the results, or NULL to allocate one.
+ * @return The vector with the quantiles, or NULL on error.
+ */
+vector *vector_quantiles(const vector *instance, const vector *probabilities, vector *result)
+{
+    vector *sorted = NULL;
+
+    VECTOR_CHECK(instance);
+    VECTOR_CHECK(probabilities);
+    CHECK(instance->length, "Quantiles of an empty vector");
+    CHECK(!result || result->length >= probabilities->length, "Result vector is too short");
+    VECTOR_FOREACH(probabilities)
+    {
+        CHECK(VECTOR(probabilities, index) >= 0 && VECTOR(probabilities, index) <= 1,
+              "Probability %f of a quantile isn't in [0, 1]", VECTOR(probabilities, index));
+    }
+
+    sorted = vector_sort(vector_clone(instance));
+    VECTOR_CHECK(sorted);
+
+    if (!result) {
+        result = vector_create(probabilities->length);
+        VECTOR_CHECK(result);
+    }
+
+    VECTOR_FOREACH(probabilities)
+    {
+        NN_TYPE rank  = VECTOR(probabilities, index) * (sorted->length - 1);
+        size_t  lower = (size_t)floor(rank);
+        size_t  upper = lower + 1 < sorted->length ? lower + 1 : lower;
+
+        VECTOR(result, index) = VECTOR(sorted, lower)
+                              + (rank - lower) * (VECTOR(sorted, upper) - VECTOR(sorted, lower));
+    }
+
+    number_delete(sorted);
+
+    return result;
+
+error:
+    if (sorted) {
+        number_delete(sorted);
+    }
+
+    return NULL;
+}
+
 /**
  * Calculates the angle between two vectors in degrees.
  *
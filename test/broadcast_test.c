@@ -0,0 +1,176 @@
+/**
+ * Test for the broadcasting operations in the Naive Numbers library
+ *
+ * This test verifies the element-wise operations of matrices and tensors
+ * with scalars, vectors, matrices and tensors broadcast to their shape.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+static NN_TYPE clip(NN_TYPE x, NN_TYPE bound) {
+    return x > bound ? bound : x;
+}
+
+// Test a bias row, a column and a full matrix, small and large enough to run in parallel
+int test_matrix_broadcast() {
+    printf("\n=== Testing Matrix Broadcast ===\n");
+
+    size_t shapes[][2] = {{3, 5}, {300, 257}};
+
+    for (size_t test = 0; test < 2; test++) {
+        size_t rows = shapes[test][0], columns = shapes[test][1];
+        matrix *A = matrix_create(rows, columns);
+        vector *bias = vector_create(columns);
+        matrix *scale = matrix_create(rows, 1);
+
+        MATRIX_FOREACH(A) {
+            MATRIX(A, row, column) = (NN_TYPE)(row + column);
+        }
+        VECTOR_FOREACH(bias) {
+            VECTOR(bias, index) = (NN_TYPE)index;
+        }
+        for (size_t row = 0; row < rows; row++) {
+            MATRIX(scale, row, 0) = (NN_TYPE)(row % 3 + 1);
+        }
+
+        matrix *B = matrix_clone(A);
+
+        matrix_addition(A, (number*)bias);
+        matrix_hadamard_product(A, (number*)scale);
+        matrix_subtraction(A, number_create(1));
+        matrix_division(A, (number*)matrix_clone(B));
+
+        int matches = 1;
+        MATRIX_FOREACH(A) {
+            NN_TYPE x = (NN_TYPE)(row + column);
+            NN_TYPE expected = ((x + column) * (row % 3 + 1) - 1) / x;
+            matches &= x == 0 || fabs(MATRIX(A, row, column) - expected) < 1e-5;
+        }
+        test_assert(matches, "Row, column, scalar and full operands on %zux%zu", rows, columns);
+
+        matrix *bound = matrix_create(1, columns);
+        for (size_t column = 0; column < columns; column++) {
+            MATRIX(bound, 0, column) = (NN_TYPE)column;
+        }
+        matrix_map_with(B, clip, (number*)bound);
+        matches = 1;
+        MATRIX_FOREACH(B) {
+            matches &= MATRIX(B, row, column) == (NN_TYPE)column;
+        }
+        test_assert(matches, "Map with a broadcast row on %zux%zu", rows, columns);
+
+        matrix *mismatched = matrix_create(2, columns);
+        test_assert(matrix_addition(A, (number*)mismatched) == NULL,
+                    "Mismatched rows are rejected");
+
+        number_delete((number*)A);
+        number_delete((number*)B);
+        number_delete((number*)bound);
+        number_delete((number*)mismatched);
+    }
+
+    return 0;
+}
+
+// Test NumPy-style broadcasting of tensors and vectors over a batch
+int test_tensor_broadcast() {
+    printf("\n=== Testing Tensor Broadcast ===\n");
+
+    size_t shape[] = {8, 3, 32, 33};
+    tensor *T = tensor_create(4, shape);
+    for (size_t i = 0; i < T->length; i++) {
+        VECTOR(T->number.values, i) = (NN_TYPE)(i % 11);
+    }
+    tensor *original = tensor_clone(T);
+
+    // Per-channel scale, C x 1 x 1
+    size_t channel_shape[] = {3, 1, 1};
+    tensor *channel = tensor_from_list(3, channel_shape, (NN_TYPE[]){1, 2, 3});
+    tensor_multiplication(T, (number*)channel);
+
+    // Bias along the last dimension
+    vector *bias = vector_create(33);
+    VECTOR_FOREACH(bias) {
+        VECTOR(bias, index) = (NN_TYPE)index;
+    }
+    tensor_addition(T, (number*)bias);
+
+    int matches = 1;
+    TENSOR_FOREACH4(T, n, c, h, w, position) {
+        NN_TYPE x = TENSOR4(original, n, c, h, w);
+        matches &= VECTOR(T->number.values, position) == x * (c + 1) + w;
+    }
+    test_assert(matches, "Channel scale and bias over a 4-D batch");
+
+    // Broadcast view without copying, then a contiguous copy of it
+    size_t row_shape[] = {1, 33};
+    tensor *row = tensor_view(original, 2, row_shape, NULL, 0);
+    tensor *expanded = tensor_broadcast(row, 4, shape);
+    test_assert(expanded && expanded->strides[0] == 0 && expanded->strides[2] == 0
+                && expanded->strides[3] == 1, "Broadcast view has strides of 0");
+    number *one = number_create(1);
+    test_assert(tensor_addition(expanded, one) == NULL, "Broadcast views can't be written");
+    number_delete(one);
+
+    tensor *copy = tensor_clone(expanded);
+    test_assert(TENSOR4(copy, 7, 2, 31, 32) == TENSOR2(row, 0, 32), "Clone of a broadcast view");
+
+    // The first row of a matrix subtracted from every row of the same storage
+    size_t matrix_shape[] = {4, 6};
+    tensor *M = tensor_create(2, matrix_shape);
+    for (size_t i = 0; i < M->length; i++) {
+        VECTOR(M->number.values, i) = (NN_TYPE)i;
+    }
+    tensor *first = tensor_view(M, 2, (size_t[]){1, 6}, NULL, 0);
+    tensor_subtraction(M, (number*)first);
+    matches = 1;
+    TENSOR_FOREACH2(M, i, j, position) {
+        matches &= VECTOR(M->number.values, position) == (NN_TYPE)(i * 6);
+    }
+    test_assert(matches, "Operand overlapping the tensor is read before the update");
+
+    tensor *bound = tensor_from_list(1, (size_t[]){6}, (NN_TYPE[]){0, 1, 2, 3, 4, 5});
+    tensor_map_with(M, clip, bound);
+    test_assert(TENSOR2(M, 3, 5) == 5 && TENSOR2(M, 3, 0) == 0 && TENSOR2(M, 0, 4) == 0,
+                "Map with a broadcast tensor");
+
+    test_assert(tensor_addition(T, (number*)bound) == NULL, "Mismatched shapes are rejected");
+
+    number_delete((number*)T);
+    number_delete((number*)original);
+    number_delete((number*)row);
+    number_delete((number*)expanded);
+    number_delete((number*)copy);
+    number_delete((number*)M);
+    number_delete((number*)bound);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Broadcast Test ===\n");
+
+    int result = 0;
+    result |= test_matrix_broadcast();
+    result |= test_tensor_broadcast();
+
+    if (result == 0) {
+        printf("\nAll broadcast tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
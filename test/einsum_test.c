@@ -0,0 +1,207 @@
+/**
+ * Test for the tensor contractions in the Naive Numbers library
+ *
+ * This test verifies the blocked matrix product and tensor_einsum() against
+ * naive loops: matrix products with transposed operands, batched products,
+ * chains of operands, diagonals, traces, sums and outer products.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+static tensor *random_tensor(size_t rank, size_t *shape) {
+    tensor *T = tensor_create(rank, shape);
+    vector_random_uniform(T->number.values, -1, 1);
+    return T;
+}
+
+static int is_close(NN_TYPE x, NN_TYPE y) {
+    return fabs(x - y) <= 1e-4 * (1 + fabs(y));
+}
+
+// Test the blocked product with sizes that don't fill the blocks, and a transposed operand
+int test_gemm() {
+    printf("\n=== Testing Blocked Matrix Product ===\n");
+
+    size_t sizes[][3] = {{1, 1, 1}, {5, 3, 7}, {37, 53, 29}, {130, 300, 1100}};
+
+    for (size_t test = 0; test < 4; test++) {
+        size_t M = sizes[test][0], K = sizes[test][1], N = sizes[test][2];
+        tensor *A = random_tensor(2, (size_t[]){M, K});
+        tensor *Bt = random_tensor(2, (size_t[]){N, K});
+        tensor *C = tensor_create(2, (size_t[]){M, N});
+        NN_TYPE *a = &VECTOR(A->number.values, 0);
+        NN_TYPE *b = &VECTOR(Bt->number.values, 0);
+
+        // B is read transposed in place: B[p][j] = Bt[j][p]
+        test_assert(matrix_gemm_values(M, N, K, a, K, 1, b, 1, K,
+                                       &VECTOR(C->number.values, 0), N) == 0,
+                    "Product of %zux%zu and %zux%zu", M, K, K, N);
+
+        int matches = 1;
+        for (size_t i = 0; i < M; i++) {
+            for (size_t j = 0; j < N; j++) {
+                double sum = 0;
+                for (size_t p = 0; p < K; p++) {
+                    sum += a[i * K + p] * b[j * K + p];
+                }
+                matches &= is_close(TENSOR2(C, i, j), sum);
+            }
+        }
+        test_assert(matches, "Blocked product matches the naive one");
+
+        number_delete((number*)A);
+        number_delete((number*)Bt);
+        number_delete((number*)C);
+    }
+
+    return 0;
+}
+
+// Test matrix products, transposed operands and batched attention scores
+int test_einsum_products() {
+    printf("\n=== Testing Einsum Products ===\n");
+
+    tensor *A = random_tensor(2, (size_t[]){37, 53});
+    tensor *B = random_tensor(2, (size_t[]){53, 29});
+
+    tensor *C = tensor_einsum("ij,jk->ik", 2, (tensor*[]){A, B});
+    tensor *implicit = tensor_einsum("ij,jk", 2, (tensor*[]){A, B});
+    tensor *Ct = tensor_einsum("ij,jk->ki", 2, (tensor*[]){A, B});
+    test_assert(C && C->rank == 2 && C->shape[0] == 37 && C->shape[1] == 29,
+                "Matrix product has the shape of the output");
+
+    int matches = tensor_is_equal(C, implicit) == 1;
+    for (size_t i = 0; i < 37; i++) {
+        for (size_t k = 0; k < 29; k++) {
+            double sum = 0;
+            for (size_t j = 0; j < 53; j++) {
+                sum += TENSOR2(A, i, j) * TENSOR2(B, j, k);
+            }
+            matches &= is_close(TENSOR2(C, i, k), sum) && TENSOR2(Ct, k, i) == TENSOR2(C, i, k);
+        }
+    }
+    test_assert(matches, "Matrix product, implicit output and transposed output");
+
+    // A transposed view of A is read in place
+    tensor *At = tensor_view(A, 2, (size_t[]){53, 37}, (size_t[]){1, 53}, 0);
+    tensor *D = tensor_einsum("ji,jk->ik", 2, (tensor*[]){At, B});
+    test_assert(D && tensor_is_equal(C, D) == 1, "Product of a transposed view");
+
+    // Attention scores: batch x heads x queries x keys
+    tensor *Q = random_tensor(4, (size_t[]){2, 3, 17, 8});
+    tensor *K = random_tensor(4, (size_t[]){2, 3, 19, 8});
+    tensor *S = tensor_einsum("bhqd,bhkd->bhqk", 2, (tensor*[]){Q, K});
+    matches = S && S->shape[2] == 17 && S->shape[3] == 19;
+    TENSOR_FOREACH4(S, b, h, q, k, position) {
+        double sum = 0;
+        for (size_t d = 0; d < 8; d++) {
+            sum += TENSOR4(Q, b, h, q, d) * TENSOR4(K, b, h, k, d);
+        }
+        matches &= is_close(VECTOR(S->number.values, position), sum);
+    }
+    test_assert(matches, "Batched attention scores");
+
+    number_delete((number*)A);
+    number_delete((number*)B);
+    number_delete((number*)C);
+    number_delete((number*)implicit);
+    number_delete((number*)Ct);
+    number_delete((number*)At);
+    number_delete((number*)D);
+    number_delete((number*)Q);
+    number_delete((number*)K);
+    number_delete((number*)S);
+
+    return 0;
+}
+
+// Test chains of operands, diagonals, sums and outer products
+int test_einsum_reductions() {
+    printf("\n=== Testing Einsum Reductions ===\n");
+
+    tensor *x = random_tensor(1, (size_t[]){6});
+    tensor *W = random_tensor(2, (size_t[]){6, 7});
+    tensor *y = random_tensor(1, (size_t[]){7});
+
+    tensor *bilinear = tensor_einsum("i,ij,j->", 3, (tensor*[]){x, W, y});
+    double sum = 0;
+    for (size_t i = 0; i < 6; i++) {
+        for (size_t j = 0; j < 7; j++) {
+            sum += TENSOR1(x, i) * TENSOR2(W, i, j) * TENSOR1(y, j);
+        }
+    }
+    test_assert(bilinear && bilinear->length == 1 && is_close(TENSOR1(bilinear, 0), sum),
+                "Bilinear form of three operands");
+
+    tensor *M = random_tensor(2, (size_t[]){5, 5});
+    tensor *trace = tensor_einsum("ii->", 1, (tensor*[]){M});
+    tensor *diagonal = tensor_einsum("ii->i", 1, (tensor*[]){M});
+    tensor *rows = tensor_einsum("ij->i", 1, (tensor*[]){M});
+    tensor *transposed = tensor_einsum("ij->ji", 1, (tensor*[]){M});
+    sum = 0;
+    int matches = 1;
+    for (size_t i = 0; i < 5; i++) {
+        double row = 0;
+        sum += TENSOR2(M, i, i);
+        matches &= TENSOR1(diagonal, i) == TENSOR2(M, i, i);
+        for (size_t j = 0; j < 5; j++) {
+            row += TENSOR2(M, i, j);
+            matches &= TENSOR2(transposed, j, i) == TENSOR2(M, i, j);
+        }
+        matches &= is_close(TENSOR1(rows, i), row);
+    }
+    test_assert(matches && is_close(TENSOR1(trace, 0), sum), "Trace, diagonal, row sums and transpose");
+
+    tensor *outer = tensor_einsum("i,j->ij", 2, (tensor*[]){x, y});
+    tensor *again = tensor_einsum("i,j->ij", 2, (tensor*[]){x, y});
+    test_assert(outer && TENSOR2(outer, 5, 6) == TENSOR1(x, 5) * TENSOR1(y, 6)
+                && tensor_is_equal(outer, again) == 1, "Outer product, planned once");
+
+    tensor_einsum_cache_clear();
+    test_assert(tensor_einsum("ij,jk->ik", 2, (tensor*[]){W, W}) == NULL, "Mismatched sizes are rejected");
+    test_assert(tensor_einsum("ij,jk->ik", 1, (tensor*[]){W}) == NULL, "Missing operands are rejected");
+    test_assert(tensor_einsum("ijk->i", 1, (tensor*[]){W}) == NULL, "Wrong ranks are rejected");
+
+    number_delete((number*)x);
+    number_delete((number*)W);
+    number_delete((number*)y);
+    number_delete((number*)bilinear);
+    number_delete((number*)M);
+    number_delete((number*)trace);
+    number_delete((number*)diagonal);
+    number_delete((number*)rows);
+    number_delete((number*)transposed);
+    number_delete((number*)outer);
+    number_delete((number*)again);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Einsum Test ===\n");
+
+    int result = 0;
+    result |= test_gemm();
+    result |= test_einsum_products();
+    result |= test_einsum_reductions();
+
+    if (result == 0) {
+        printf("\nAll einsum tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
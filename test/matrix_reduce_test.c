@@ -0,0 +1,142 @@
+/**
+ * Test for the axis reductions in the Naive Numbers library
+ *
+ * This test verifies matrix_reduce_rows, matrix_reduce_columns and the
+ * matrix norms against plain loops, for matrices large enough to be reduced
+ * in parallel.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+static const char *names[] = {"sum", "mean", "min", "max", "argmin", "argmax", "variance", "L1 norm", "L2 norm"};
+
+// Reduces `count` values `stride` apart with plain loops
+static double reduce(const NN_TYPE *values, size_t count, size_t stride, enum nn_reduction reduction) {
+    double result = reduction == NN_MIN || reduction == NN_ARGMIN ? INFINITY
+                  : reduction == NN_MAX || reduction == NN_ARGMAX ? -INFINITY : 0;
+    double mean = 0;
+    size_t at = 0;
+
+    for (size_t i = 0; i < count; i++) {
+        mean += values[i * stride] / (double)count;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        double x = values[i * stride];
+
+        switch (reduction) {
+        case NN_SUM: case NN_MEAN: result += x; break;
+        case NN_VARIANCE: result += (x - mean) * (x - mean); break;
+        case NN_L1_NORM: result += fabs(x); break;
+        case NN_L2_NORM: result += x * x; break;
+        case NN_MIN: case NN_ARGMIN: if (x < result) { result = x; at = i; } break;
+        case NN_MAX: case NN_ARGMAX: if (x > result) { result = x; at = i; } break;
+        }
+    }
+
+    switch (reduction) {
+    case NN_MEAN: case NN_VARIANCE: return result / count;
+    case NN_L2_NORM: return sqrt(result);
+    case NN_ARGMIN: case NN_ARGMAX: return at;
+    default: return result;
+    }
+}
+
+// Test every reduction over both axes against plain loops
+int test_matrix_reduce(size_t rows, size_t columns) {
+    printf("\n=== Testing Matrix Reduce %zux%zu ===\n", rows, columns);
+
+    matrix *A = matrix_random_uniform(matrix_create(rows, columns), -1, 1);
+    // Repeated extrema must give the first position
+    MATRIX(A, rows - 1, columns - 1) = 2;
+    MATRIX(A, rows / 2, columns - 1) = 2;
+
+    for (enum nn_reduction reduction = NN_SUM; reduction <= NN_L2_NORM; reduction++) {
+        vector *by_row = matrix_reduce_rows(A, reduction, NULL);
+        vector *by_column = matrix_reduce_columns(A, reduction, NULL);
+        int matches = by_row && by_column && by_row->length == rows && by_column->length == columns;
+
+        for (size_t row = 0; matches && row < rows; row++) {
+            double expected = reduce(&MATRIX(A, row, 0), columns, 1, reduction);
+            matches &= fabs(VECTOR(by_row, row) - expected) <= 1e-4 * fmax(1, fabs(expected));
+        }
+        test_assert(matches, "Row %s", names[reduction]);
+
+        for (size_t column = 0; matches && column < columns; column++) {
+            double expected = reduce(&MATRIX(A, 0, column), rows, columns, reduction);
+            matches &= fabs(VECTOR(by_column, column) - expected) <= 1e-4 * fmax(1, fabs(expected));
+        }
+        test_assert(matches, "Column %s", names[reduction]);
+
+        number_delete((number*)by_row);
+        number_delete((number*)by_column);
+    }
+
+    number_delete((number*)A);
+
+    return 0;
+}
+
+// Test the streaming norms against plain loops, narrow and wide enough for several stripes
+int test_matrix_norms(size_t rows, size_t columns) {
+    printf("\n=== Testing Matrix Norms %zux%zu ===\n", rows, columns);
+
+    matrix *A = matrix_random_uniform(matrix_create(rows, columns), -1, 1);
+    double squares = 0, max = 0, one = 0, infinity = 0;
+
+    for (size_t row = 0; row < rows; row++) {
+        infinity = fmax(infinity, reduce(&MATRIX(A, row, 0), columns, 1, NN_L1_NORM));
+    }
+    for (size_t column = 0; column < columns; column++) {
+        one = fmax(one, reduce(&MATRIX(A, 0, column), rows, columns, NN_L1_NORM));
+    }
+    for (size_t index = 0; index < rows * columns; index++) {
+        NN_TYPE value = VECTOR(A->number.values, index);
+        squares += value * value;
+        max = fmax(max, fabs(value));
+    }
+
+    test_assert(fabs(matrix_frobenius_norm(A) - sqrt(squares)) < 1e-4 * sqrt(squares), "Frobenius norm");
+    test_assert(fabs(matrix_frobenius_norm_by_trace(A) - sqrt(squares)) < 1e-4 * sqrt(squares),
+                "Frobenius norm by trace");
+    test_assert(matrix_max_norm(A) == max, "Max norm");
+    test_assert(fabs(matrix_one_norm(A) - one) < 1e-4 * one, "1-norm");
+    test_assert(fabs(matrix_infinity_norm(A) - infinity) < 1e-4 * infinity, "Infinity-norm");
+
+    number_delete((number*)A);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Matrix Reduce Test ===\n");
+
+    int result = 0;
+    result |= test_matrix_reduce(1, 1);
+    result |= test_matrix_reduce(7, 5);
+    result |= test_matrix_reduce(33, 8);
+    result |= test_matrix_reduce(3001, 13);
+    result |= test_matrix_norms(3, 5);
+    result |= test_matrix_norms(2001, 9);
+    result |= test_matrix_norms(40, 1030);
+
+    if (result == 0) {
+        printf("\nAll matrix reduce tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
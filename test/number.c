@@ -9,6 +9,7 @@
 #include <nn.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 // Simple test assertion macro
@@ -174,6 +175,138 @@ int test_complex_memory_management()
     return 0;
 }
 
+// Test the random generators and bulk fills
+int test_random()
+{
+    printf("\n=== Testing Random Numbers ===\n");
+
+    struct nn_random generator, split;
+    random_seed(&generator, 42);
+    split = generator;
+    random_jump(&split);
+    test_assert(random_next(&generator) != random_next(&split), "Jumped generator gives another stream");
+
+    size_t length = 100003;
+    NN_TYPE *values = malloc(length * sizeof(NN_TYPE));
+    NN_TYPE *again  = malloc(length * sizeof(NN_TYPE));
+    test_assert(values && again, "Buffers allocated");
+
+    random_fill_uniform(values, length, -2, 2, 7);
+    random_fill_uniform(again, length, -2, 2, 7);
+    NN_TYPE mean = 0, minimum = INFINITY, maximum = -INFINITY;
+    for (size_t index = 0; index < length; index++) {
+        mean += values[index] / length;
+        minimum = fmin(minimum, values[index]);
+        maximum = fmax(maximum, values[index]);
+    }
+    test_assert(memcmp(values, again, length * sizeof(NN_TYPE)) == 0, "Uniform fill is reproducible");
+    test_assert(minimum >= -2 && maximum < 2, "Uniform fill stays in range");
+    test_assert(fabs(mean) < 0.02, "Uniform fill is centered: %f", mean);
+
+    random_fill_normal(values, length, 3, 2, 11);
+    NN_TYPE variance = 0;
+    mean = 0;
+    for (size_t index = 0; index < length; index++) {
+        mean += values[index] / length;
+    }
+    for (size_t index = 0; index < length; index++) {
+        variance += (values[index] - mean) * (values[index] - mean) / length;
+    }
+    test_assert(fabs(mean - 3) < 0.03, "Normal fill mean: %f", mean);
+    test_assert(fabs(variance - 4) < 0.1, "Normal fill variance: %f", variance);
+
+    random_seed_global(5);
+    NN_TYPE first = nn_random_range(0, 1);
+    random_seed_global(5);
+    test_assert(nn_random_range(0, 1) == first, "Global seed makes draws reproducible");
+    test_assert(nn_random_range(-1, 0) <= 0, "Negative ranges are kept");
+
+    matrix *m = matrix_create(64, 64);
+    test_assert(matrix_random_normal(m, 0, 1) == m, "Matrix filled with normal values");
+    number_delete(m);
+
+    free(values);
+    free(again);
+
+    return 0;
+}
+
+// Test shuffles and permutations
+int test_shuffle()
+{
+    printf("\n=== Testing Shuffles ===\n");
+
+    /* Every order of 3 elements should come up about as often */
+    size_t orders[3][3] = {{0}};
+    vector *small = vector_create(3);
+    for (size_t round = 0; round < 60000; round++) {
+        for (size_t index = 0; index < 3; index++) {
+            VECTOR(small, index) = index;
+        }
+        vector_shuffle(small);
+        for (size_t index = 0; index < 3; index++) {
+            orders[index][(size_t)VECTOR(small, index)]++;
+        }
+    }
+    for (size_t index = 0; index < 3; index++) {
+        for (size_t value = 0; value < 3; value++) {
+            test_assert(fabs(orders[index][value] / 60000.0 - 1 / 3.0) < 0.01,
+                        "Value %zu lands at %zu uniformly", value, index);
+        }
+    }
+    number_delete(small);
+
+    /* Long arrays go through the parallel merge */
+    size_t length = 3 * NN_RANDOM_SHUFFLE_BLOCK + 17;
+    size_t *permutation = malloc(length * sizeof(size_t));
+    char *seen = calloc(length, 1);
+    test_assert(permutation && seen, "Buffers allocated");
+    random_permutation(permutation, length, 3);
+    size_t fixed = 0, valid = 1;
+    for (size_t index = 0; index < length; index++) {
+        valid &= !seen[permutation[index]];
+        seen[permutation[index]] = 1;
+        fixed += permutation[index] == index;
+    }
+    test_assert(valid, "Long permutation holds every index once");
+    test_assert(fixed < 10, "Long permutation is mixed: %zu fixed points", fixed);
+    size_t *other = malloc(length * sizeof(size_t));
+    test_assert(other, "Buffer allocated");
+    random_permutation(other, length, 4);
+    size_t same = 0;
+    for (size_t index = 0; index < length; index++) {
+        same += permutation[index] == other[index];
+    }
+    test_assert(same < 10, "Seeds give different permutations: %zu shared positions", same);
+    free(permutation);
+    free(other);
+    free(seen);
+
+    /* Rows of two matrices shuffled together */
+    matrix *samples = matrix_create(100, 3);
+    vector *labels  = vector_create(100);
+    size_t rows[100];
+    for (size_t row = 0; row < 100; row++) {
+        for (size_t column = 0; column < 3; column++) {
+            MATRIX(samples, row, column) = row * 10 + column;
+        }
+        VECTOR(labels, row) = row;
+    }
+    random_permutation(rows, 100, 9);
+    test_assert(matrix_permute_rows(samples, rows) == samples, "Matrix rows permuted");
+    test_assert(vector_permute(labels, rows) == labels, "Vector permuted");
+    size_t together = 1;
+    for (size_t row = 0; row < 100; row++) {
+        together &= VECTOR(labels, row) == rows[row] && MATRIX(samples, row, 0) == rows[row] * 10
+                    && MATRIX(samples, row, 2) == rows[row] * 10 + 2;
+    }
+    test_assert(together, "Rows and labels stay together");
+    number_delete(samples);
+    number_delete(labels);
+
+    return 0;
+}
+
 int main()
 {
     printf("=== Naive Numbers Number Test ===\n");
@@ -188,6 +321,8 @@ int main()
     result |= test_vector_reference_counting();
     result |= test_null_reference_counting();
     result |= test_complex_memory_management();
+    result |= test_random();
+    result |= test_shuffle();
 
     if (result == 0) {
         printf("\nAll number tests passed successfully!\n");
@@ -1,4 +1,5 @@
 #include "probability.h"
+#include "bayes.h"
 #include "matrix.h"
 #include "vector.h"
 #include <math.h>
@@ -383,6 +384,601 @@ int test_probability_conditional()
         return 0; 
 }
 
+int test_probability_append()
+{
+    NN_TYPE values[] = {0.8, 0.2, 0.2, 0.4, 0.5, 0.7, 0.2, 0.9};
+    const char *fields[] = {"field1\0", "field2\0"};
+
+    matrix *head = matrix_create_from_list(2, 2, values);
+    matrix *tail = matrix_create_from_list(2, 2, values + 4);
+    matrix *all = matrix_create_from_list(4, 2, values);
+    test_assert(head && tail && all, "Matrices allocated");
+
+    probability *p = probability_from_matrix(head, (char **)fields);
+    probability *expected = probability_from_matrix(all, (char **)fields);
+    test_assert(probability_append(p, tail) == p, "Rows appended");
+    test_assert(p->samples->rows == 4, "Samples grown to 4 rows");
+
+    test_assert(fabs(probability_mass_of(p, "field1", 0.2) - 0.5) < 1e-6,
+                "Mass of repeated event updated");
+    test_assert(fabs(p->variance[0] - expected->variance[0]) < 1e-6,
+                "Appended variance matches full rebuild");
+    test_assert(fabs(probability_covariance(p, "field1", "field2")
+                     - probability_covariance(expected, "field1", "field2"))
+                    < 1e-6,
+                "Appended covariance matches full rebuild");
+    test_assert(fabs(probability_correlation(p, "field1", "field2")
+                     - probability_correlation(expected, "field1", "field2"))
+                    < 1e-5,
+                "Appended correlation matches full rebuild");
+    probability_delete(expected);
+
+    expected = probability_from_matrix(tail, (char **)fields);
+    test_assert(probability_retract(p, 2) == p, "Oldest rows retracted");
+    test_assert(p->samples->rows == 2, "Samples shrunk to 2 rows");
+    test_assert(probability_mass_of(p, "field1", 0.8) == 0,
+                "Retracted event has zero mass");
+    test_assert(fabs(probability_expected_value(p, "field2") - 0.8) < 1e-6,
+                "Expected value follows the window");
+    test_assert(fabs(probability_covariance(p, "field1", "field2")
+                     - probability_covariance(expected, "field1", "field2"))
+                    < 1e-6,
+                "Retracted covariance matches window rebuild");
+    test_assert(probability_retract(p, 2) == NULL,
+                "Retracting every sample is rejected");
+
+    number_delete(head);
+    number_delete(tail);
+    number_delete(all);
+    probability_delete(expected);
+    probability_delete(p);
+
+    return 0;
+}
+
+int test_probability_sliding_window()
+{
+    const char *fields[] = {"field1\0", "field2\0", "constant\0"};
+    NN_TYPE values[3 * 40];
+
+    for (size_t row = 0; row < 40; row++) {
+        values[3 * row] = (NN_TYPE)(row % 5);
+        values[3 * row + 1] = (NN_TYPE)((row * 7) % 11);
+        values[3 * row + 2] = 1;
+    }
+
+    matrix *window = matrix_create_from_list(10, 3, values);
+    probability *p = probability_from_matrix(window, (char **)fields);
+    size_t stored = 0;
+
+    for (size_t row = 10; row < 40; row++) {
+        matrix *batch = matrix_create_from_list(1, 3, &values[3 * row]);
+
+        probability_append(p, batch);
+        probability_retract(p, 1);
+        stored = p->samples->rows > stored ? p->samples->rows : stored;
+        number_delete(batch);
+    }
+    test_assert(stored <= 2 * 10 + 1, "Window of 10 samples stores at most 21 rows");
+
+    matrix *last = matrix_create_from_list(10, 3, &values[3 * 30]);
+    probability *expected = probability_from_matrix(last, (char **)fields);
+    test_assert(fabs(probability_mass_of(p, "field2", 2) - probability_mass_of(expected, "field2", 2)) < 1e-6,
+                "Sliding window mass matches window rebuild");
+    test_assert(fabs(probability_covariance(p, "field1", "field2")
+                     - probability_covariance(expected, "field1", "field2")) < 1e-4,
+                "Sliding window covariance matches window rebuild");
+    test_assert(probability_correlation(p, "field1", "constant") == 0,
+                "Correlation with a constant field is 0");
+
+    number_delete(window);
+    number_delete(last);
+    probability_delete(p);
+    probability_delete(expected);
+
+    return 0;
+}
+
+int test_probability_from_matrix_ref()
+{
+    NN_TYPE values[] = {0.8, 0.2, 0.2, 0.4, 0.5, 0.7};
+    NN_TYPE columns[] = {0.8, 0.2, 0.5, 0.2, 0.4, 0.7};
+    const char *fields[] = {"field1\0", "field2\0"};
+
+    matrix *rows = matrix_create_from_list(3, 2, values);
+    matrix *by_field = matrix_create_from_list(2, 3, columns);
+    matrix *batch = matrix_create_from_list(1, 2, (NN_TYPE[]){0.2, 0.9});
+    test_assert(rows && by_field && batch, "Matrices allocated");
+
+    probability *p = probability_from_matrix_ref(rows, (char **)fields, NN_ROW_MAJOR);
+    test_assert(p && p->samples == rows, "Row-major space shares the samples");
+    test_assert(rows->number.ref_count == 2, "Samples are borrowed by reference");
+
+    probability *q = probability_from_matrix_ref(by_field, (char **)fields, NN_COLUMN_MAJOR);
+    number_unref((number *)by_field);
+    test_assert(q && q->samples == by_field, "Column-major space owns the samples");
+    test_assert(fabs(probability_mass_of(q, "field2", 0.4) - 1.0 / 3) < 1e-6,
+                "Column-major mass of event");
+    test_assert(fabs(probability_covariance(p, "field1", "field2")
+                     - probability_covariance(q, "field1", "field2"))
+                    < 1e-6,
+                "Layouts give the same covariance");
+
+    probability_append(p, batch);
+    probability_append(q, batch);
+    test_assert(q->samples->rows == 2 && q->samples->columns == 4,
+                "Column-major samples grown by one sample");
+    test_assert(MATRIX(q->samples, 0, 2) == (NN_TYPE)0.5
+                    && MATRIX(q->samples, 1, 3) == (NN_TYPE)0.9,
+                "Column-major fields spread after append");
+    test_assert(fabs(probability_correlation(p, "field1", "field2")
+                     - probability_correlation(q, "field1", "field2"))
+                    < 1e-5,
+                "Layouts give the same correlation after append");
+
+    probability_retract(q, 2);
+    test_assert(MATRIX(q->samples, 0, 0) == (NN_TYPE)0.5
+                    && MATRIX(q->samples, 1, 1) == (NN_TYPE)0.9,
+                "Column-major fields packed after retract");
+    char *joint_fields[] = {"field1", "field2", NULL};
+    test_assert(fabs(probability_mass_and(q, joint_fields, (NN_TYPE[]){0.2, 0.9}) - 0.5) < 1e-6,
+                "Column-major joint mass after retract");
+
+    probability_delete(p);
+    probability_delete(q);
+    test_assert(rows->number.ref_count == 1, "Samples released by the space");
+
+    number_delete(rows);
+    number_delete(batch);
+
+    return 0;
+}
+
+int test_probability_batch()
+{
+    matrix *m = matrix_create_from_list(4, 2, (NN_TYPE[]){0.8, 0.2, 0.2, 0.4, 0.5, 0.7, 0.2, 0.4});
+    test_assert(m, "Matrix m allocated");
+
+    char *fields[] = {"field1", "field2"};
+    probability *p = probability_from_matrix(m, fields);
+    test_assert(p != NULL, "Probability p is not NULL");
+
+    char *A_fields[] = {"field1", "field1", "field2", "field1"};
+    NN_TYPE A_values[] = {0.2, 0.2, 0.4, 0.8};
+    char *B_fields[] = {"field2", "field2", "field1", "field2"};
+    NN_TYPE B_values[] = {0.4, 0.4, 0.2, 0.4};
+
+    vector *masses = probability_mass_batch(p, 4, A_fields, A_values, NULL);
+    test_assert(masses && masses->length == 4, "Mass batch allocated its result");
+    for(size_t query = 0; query < 4; query++) {
+        test_assert(VECTOR(masses, query) == probability_mass_of(p, A_fields[query], A_values[query]),
+                    "Batched mass matches probability_mass_of for query %zu", query);
+    }
+
+    vector *conditional = vector_create(4);
+    test_assert(probability_conditional_batch(p, 4, A_fields, A_values, B_fields, B_values, conditional)
+                    == conditional,
+                "Conditional batch wrote into the given vector");
+    vector *bayes = probability_bayes_batch(p, 4, A_fields, A_values, B_fields, B_values, NULL);
+    test_assert(bayes != NULL, "Bayes batch allocated its result");
+
+    for(size_t query = 0; query < 4; query++) {
+        NN_TYPE expected = probability_conditional(p, A_fields[query], A_values[query],
+                                                   B_fields[query], B_values[query]);
+        test_assert(fabs(VECTOR(conditional, query) - expected) < 1e-6,
+                    "Batched conditional matches for query %zu: %f = %f",
+                    query, VECTOR(conditional, query), expected);
+        test_assert(fabs(VECTOR(bayes, query) - expected) < 1e-6,
+                    "Batched Bayes matches for query %zu", query);
+    }
+
+    number_delete(m);
+    number_delete(masses);
+    number_delete(conditional);
+    number_delete(bayes);
+    probability_delete(p);
+
+    return 0;
+}
+
+int test_probability_cache()
+{
+    matrix *m = matrix_create_from_list(3, 2, (NN_TYPE[]){0.8, 0.2, 0.2, 0.4, 0.5, 0.7});
+    matrix *batch = matrix_create_from_list(1, 2, (NN_TYPE[]){0.8, 0.2});
+    test_assert(m && batch, "Matrices allocated");
+
+    char *fields[] = {"field1", "field2"};
+    probability *p = probability_from_matrix(m, fields);
+    test_assert(probability_cache_enable(p, 2) == p, "Cache enabled");
+    size_t hits, misses, size;
+
+    NN_TYPE mass = probability_mass_of(p, "field1", 0.8);
+    test_assert(probability_mass_of(p, "field1", 0.8) == mass, "Cached marginal is returned");
+    probability_cache_stats(p, &hits, &misses, NULL);
+    test_assert(hits == 1 && misses == 1, "Marginal hit counted");
+
+    char *joint[] = {"field1", "field2", NULL};
+    char *reversed[] = {"field2", "field1", NULL};
+    mass = probability_mass_and(p, joint, (NN_TYPE[]){0.8, 0.2});
+    test_assert(probability_mass_and(p, reversed, (NN_TYPE[]){0.2, 0.8}) == mass,
+                "Joint mass is cached in any field order");
+    probability_cache_stats(p, &hits, NULL, &size);
+    test_assert(hits == 2 && size == 2, "Joint hit counted");
+
+    probability_mass_of(p, "field2", 0.4);
+    probability_cache_stats(p, NULL, NULL, &size);
+    test_assert(size == 2, "Cache is bounded");
+    probability_mass_of(p, "field1", 0.8);
+    probability_cache_stats(p, NULL, &misses, NULL);
+    test_assert(misses == 4, "Least recently used mass was evicted");
+
+    probability_append(p, batch);
+    probability_cache_stats(p, NULL, NULL, &size);
+    test_assert(size == 0, "Append invalidates the cache");
+    test_assert(fabs(probability_mass_and(p, joint, (NN_TYPE[]){0.8, 0.2}) - 0.5) < 1e-6,
+                "Joint mass recomputed after append");
+
+    number_delete(m);
+    number_delete(batch);
+    probability_delete(p);
+
+    return 0;
+}
+
+int test_probability_sketched()
+{
+    size_t rows = 20000;
+    matrix *m = matrix_create(rows, 2);
+    test_assert(m, "Matrix m allocated");
+
+    /* field1 has a frequent value 7 and thousands of rare ones */
+    for(size_t row = 0; row < rows; row++) {
+        MATRIX(m, row, 0) = row % 4 == 0 ? 7 : (NN_TYPE)(row % 5000) + 10;
+        MATRIX(m, row, 1) = (NN_TYPE)(row % 3);
+    }
+
+    char *fields[] = {"field1", "field2"};
+    char *sketched[] = {"field1", NULL};
+    probability *exact = probability_from_matrix(m, fields);
+    probability *p = probability_from_matrix_sketched(m, fields, sketched);
+    test_assert(p != NULL, "Sketched probability space created");
+
+    test_assert(p->events[0]->length <= NN_SKETCH_HEAVY, "Sketched events are bounded");
+    test_assert(vector_index_of(p->events[0], 7) >= 0, "Frequent value is a heavy hitter");
+
+    NN_TYPE bound = 2.72 / NN_SKETCH_WIDTH;
+    NN_TYPE mass = probability_mass_of(p, "field1", 7);
+    test_assert(mass >= probability_mass_of(exact, "field1", 7)
+                    && mass - probability_mass_of(exact, "field1", 7) <= bound,
+                "Sketched mass of heavy hitter is within the bound");
+    mass = probability_mass_of(p, "field1", 11);
+    test_assert(mass >= probability_mass_of(exact, "field1", 11)
+                    && mass - probability_mass_of(exact, "field1", 11) <= bound,
+                "Sketched mass of rare value is within the bound");
+    test_assert(probability_mass_of(p, "field2", 1) == probability_mass_of(exact, "field2", 1),
+                "Exact field is unchanged");
+
+    size_t distinct = probability_distinct_count(p, "field1");
+    test_assert(fabs((NN_TYPE)distinct - 3751) < 3751 * 0.05,
+                "Distinct count estimated: %zu of 3751", distinct);
+    test_assert(probability_distinct_count(exact, "field1") == 3751, "Exact distinct count");
+    test_assert(fabs(probability_expected_value(p, "field1") - probability_expected_value(exact, "field1"))
+                    < 1e-1,
+                "Sketched expected value comes from the moments");
+
+    /* The sketched marginal of 19 overestimates, its counted joint mass shares the key */
+    char *joint[] = {"field1", NULL};
+    test_assert(probability_cache_enable(p, 4) == p, "Cache enabled");
+    mass = probability_mass_of(p, "field1", 19);
+    test_assert(probability_mass_and(p, joint, (NN_TYPE[]){19}) == probability_mass_of(exact, "field1", 19),
+                "Cached sketched marginal isn't returned as a joint mass");
+    test_assert(probability_mass_of(p, "field1", 19) == mass,
+                "Cached joint mass isn't returned as a sketched marginal");
+
+    number_unref((number *)m);
+    probability_delete(exact);
+    probability_delete(p);
+
+    return 0;
+}
+
+int test_probability_binned()
+{
+    size_t rows = 10000;
+    matrix *m = matrix_create(rows, 2);
+    test_assert(m, "Matrix m allocated");
+
+    /* field1 is uniform over [0, 100), field2 is categorical */
+    for(size_t row = 0; row < rows; row++) {
+        MATRIX(m, row, 0) = (NN_TYPE)(row % 1000) / 10;
+        MATRIX(m, row, 1) = (NN_TYPE)(row % 2);
+    }
+
+    char *fields[] = {"field1", "field2"};
+    char *binned[] = {"field1", NULL};
+    enum nn_binning binnings[] = {NN_BINNING_WIDTH, NN_BINNING_QUANTILE, NN_BINNING_STREAMING};
+
+    for(size_t binning = 0; binning < 3; binning++) {
+        probability *p = probability_from_matrix_binned(m, fields, binned, binnings[binning], 20);
+        test_assert(p != NULL, "Binned probability space created with binning %d", binnings[binning]);
+
+        test_assert(p->events[0]->length <= 20, "Binned events are bounded");
+        test_assert(fabs(probability_mass_of(p, "field1", 12.3) - 0.05) < 0.02,
+                    "Mass of a bin: %f", probability_mass_of(p, "field1", 12.3));
+        test_assert(probability_mass_of(p, "field2", 1) == (NN_TYPE)0.5, "Categorical field is unchanged");
+        test_assert(fabs(probability_expected_value(p, "field1") - 49.95) < 1e-2,
+                    "Binned expected value comes from the moments");
+
+        NN_TYPE density = probability_density(p, "field1", 50);
+        test_assert(fabs(density - 0.01) < 0.002, "Density of a uniform field: %f", density);
+        NN_TYPE between = probability_density_between(p, "field1", 25, 75);
+        test_assert(fabs(between - 0.5) < 0.02, "Probability between two values: %f", between);
+
+        vector *grid = vector_create(101);
+        test_assert(probability_density_grid(p, "field1", 0, 100, grid) == grid, "Density grid evaluated");
+        test_assert(fabs(VECTOR(grid, 50) - density) < 1e-5, "Density grid matches pointwise density");
+        number_delete(grid);
+
+        probability_delete(p);
+    }
+
+    number_delete(m);
+
+    /* x is uniform over [0, 1) but for a NaN, y is 1 over the first half of x */
+    m = matrix_create(1000, 2);
+    test_assert(m, "Matrix m allocated");
+    for(size_t row = 0; row < 1000; row++) {
+        MATRIX(m, row, 0) = row ? (NN_TYPE)row / 1000 : NAN;
+        MATRIX(m, row, 1) = row < 500;
+    }
+
+    char *xy[] = {"x", "y"};
+    char *x[] = {"x", NULL};
+    probability *p = probability_from_matrix_binned(m, xy, x, NN_BINNING_WIDTH, 4);
+    test_assert(p != NULL, "Binned probability space created with a NaN");
+    test_assert(VECTOR(p->bins[0]->edges, 0) == (NN_TYPE)0.001, "NaN is left out of the bin range");
+
+    NN_TYPE conditional = probability_conditional(p, "y", 1, "x", 0.1);
+    test_assert(fabs(conditional - 1) < 0.01, "Conditional on a binned field: %f", conditional);
+    conditional = probability_conditional(p, "x", 0.1, "y", 1);
+    test_assert(fabs(conditional - 0.5) < 0.01, "Conditional of a binned field: %f", conditional);
+
+    vector *batch = probability_conditional_batch(p, 2, (char *[]){"y", "x"}, (NN_TYPE[]){1, 0.1},
+                                                  (char *[]){"x", "y"}, (NN_TYPE[]){0.1, 1}, NULL);
+    test_assert(batch != NULL, "Batch on a binned field computed");
+    test_assert(fabs(VECTOR(batch, 0) - probability_conditional(p, "y", 1, "x", 0.1)) < 1e-6
+                    && fabs(VECTOR(batch, 1) - probability_conditional(p, "x", 0.1, "y", 1)) < 1e-6,
+                "Batched conditionals on a binned field match");
+
+    number_delete(batch);
+    probability_delete(p);
+    number_delete(m);
+
+    return 0;
+}
+
+static NN_TYPE test_identity(NN_TYPE x) { return x; }
+static NN_TYPE test_square(NN_TYPE x) { return x * x; }
+static NN_TYPE test_log(NN_TYPE x) { return log(x); }
+
+int test_probability_expected_value_of_function()
+{
+    size_t rows = 1000;
+    matrix *m = matrix_create(rows, 1);
+    test_assert(m, "Matrix m allocated");
+
+    for(size_t row = 0; row < rows; row++) {
+        MATRIX(m, row, 0) = (NN_TYPE)(row % 10) + 1;
+    }
+
+    char *fields[] = {"field1"};
+    probability *p = probability_from_matrix(m, fields);
+    test_assert(p != NULL, "Probability p is not NULL");
+
+    test_assert(fabs(probability_matrix_expected_value_of_function(p, "field1", test_square) - 38.5) < 1e-4,
+                "Expected value of x^2");
+
+    NN_TYPE (*operations[])(NN_TYPE) = {test_identity, test_square, test_log};
+    NN_TYPE moments[3];
+    test_assert(probability_matrix_expected_value_of_function_batch(p, "field1", 3, operations, moments) == moments,
+                "Batch of functions evaluated");
+    test_assert(fabs(moments[0] - probability_expected_value(p, "field1")) < 1e-5, "Batch E[x]");
+    test_assert(fabs(moments[1] - 38.5) < 1e-4, "Batch E[x^2]");
+    test_assert(fabs(moments[2] - log(3628800.0) / 10) < 1e-5, "Batch E[log(x)]");
+    test_assert(fabs(probability_variance(p, "field1") - (moments[1] - moments[0] * moments[0])) < 1e-4,
+                "Variance matches E[x^2] - E[x]^2");
+    test_assert(probability_matrix_expected_value_of_function_batch(p, "unknown", 3, operations, moments) == NULL,
+                "Unknown field is refused");
+
+    number_delete(m);
+    probability_delete(p);
+
+    return 0;
+}
+
+int test_probability_mutual_information()
+{
+    size_t rows = 1000;
+    matrix *m = matrix_create(rows, 5);
+    test_assert(m, "Matrix m allocated");
+
+    /* field2 is a copy of field1, field3 is independent of both, field4 and field5 are unique keys */
+    for(size_t row = 0; row < rows; row++) {
+        MATRIX(m, row, 0) = (NN_TYPE)(row % 4);
+        MATRIX(m, row, 1) = (NN_TYPE)(row % 4);
+        MATRIX(m, row, 2) = (NN_TYPE)(row / 4 % 2);
+        MATRIX(m, row, 3) = (NN_TYPE)row;
+        MATRIX(m, row, 4) = (NN_TYPE)(rows - row);
+    }
+
+    char *fields[] = {"field1", "field2", "field3", "field4", "field5"};
+    probability *p = probability_from_matrix(m, fields);
+    test_assert(p != NULL, "Probability p is not NULL");
+
+    test_assert(fabs(probability_entropy(p, "field1") - 2) < 1e-5, "Entropy of 4 uniform events");
+    test_assert(fabs(probability_joint_entropy(p, "field1", "field2") - 2) < 1e-5, "Joint entropy of copies");
+    test_assert(fabs(probability_joint_entropy(p, "field1", "field3") - 3) < 1e-5,
+                "Joint entropy of independent fields");
+
+    matrix *information = probability_mutual_information(p);
+    test_assert(information != NULL, "Mutual information computed");
+    test_assert(fabs(MATRIX(information, 0, 1) - 2) < 1e-5, "Copies share all their information");
+    test_assert(fabs(MATRIX(information, 0, 2)) < 1e-5, "Independent fields share no information");
+    test_assert(MATRIX(information, 2, 0) == MATRIX(information, 0, 2), "Mutual information is symmetric");
+    test_assert(fabs(MATRIX(information, 2, 2) - 1) < 1e-5, "Entropy on the diagonal");
+    test_assert(fabs(MATRIX(information, 3, 4) - log2(rows)) < 1e-3, "Sparse contingency of unique keys");
+    test_assert(probability_mutual_information(p) == information, "Mutual information is cached");
+
+    matrix *batch = matrix_create(1, 5);
+    MATRIX(batch, 0, 0) = 0;
+    MATRIX(batch, 0, 1) = 1;
+    MATRIX(batch, 0, 2) = 0;
+    MATRIX(batch, 0, 3) = 0;
+    MATRIX(batch, 0, 4) = 0;
+    test_assert(probability_append(p, batch) != NULL, "Sample appended");
+    test_assert(p->mutual_information == NULL, "Appending invalidates the mutual information");
+    test_assert(MATRIX(probability_mutual_information(p), 0, 1) < 2, "Mutual information recomputed");
+
+    MATRIX(batch, 0, 2) = NAN;
+    MATRIX(batch, 0, 3) = NAN;
+    test_assert(probability_append(p, batch) != NULL, "Sample with NaN appended");
+    information = probability_mutual_information(p);
+    test_assert(information && isfinite(MATRIX(information, 2, 3)) && isfinite(MATRIX(information, 3, 4)),
+                "Samples with NaN are left out of the contingency counts");
+
+    number_delete(batch);
+    number_delete(m);
+    probability_delete(p);
+
+    return 0;
+}
+
+int test_bayes()
+{
+    size_t rows = 1200;
+    matrix *m = matrix_create(rows, 3);
+    test_assert(m, "Matrix m allocated");
+
+    /* The class is mostly given by field1, field2 is continuous and tells the classes apart */
+    for(size_t row = 0; row < rows; row++) {
+        NN_TYPE class = (NN_TYPE)(row % 3);
+
+        MATRIX(m, row, 0) = class;
+        MATRIX(m, row, 1) = row % 10 == 0 ? (NN_TYPE)((row / 10) % 3) : class;
+        MATRIX(m, row, 2) = class * 10 + (NN_TYPE)(row % 7);
+    }
+
+    char *fields[] = {"class", "field1", "field2"};
+    char *binned[] = {"field2", NULL};
+    char *features[] = {"field1", "field2", NULL};
+    probability *p = probability_from_matrix_binned(m, fields, binned, NN_BINNING_WIDTH, 8);
+    test_assert(p != NULL, "Probability p is not NULL");
+
+    bayes *model = bayes_create(p, "class", features, 1);
+    test_assert(model != NULL, "Naive Bayes model trained");
+    test_assert(model->classes->length == 3, "Classes found");
+
+    matrix *samples = matrix_create(4, 2);
+    NN_TYPE expected[] = {0, 1, 2, 2};
+    MATRIX(samples, 0, 0) = 0;
+    MATRIX(samples, 0, 1) = 3;
+    MATRIX(samples, 1, 0) = 1;
+    MATRIX(samples, 1, 1) = 12;
+    MATRIX(samples, 2, 0) = 2;
+    MATRIX(samples, 2, 1) = 25;
+    /* Unseen category, the continuous feature decides */
+    MATRIX(samples, 3, 0) = 42;
+    MATRIX(samples, 3, 1) = 24;
+
+    vector *predicted = bayes_predict(model, samples, NULL);
+    test_assert(predicted != NULL, "Classes predicted");
+    for(size_t row = 0; row < 4; row++) {
+        test_assert(VECTOR(predicted, row) == expected[row], "Class of sample %zu is %f", row, VECTOR(predicted, row));
+    }
+
+    matrix *posterior = bayes_log_posterior(model, samples, NULL);
+    test_assert(posterior != NULL, "Log posteriors calculated");
+    NN_TYPE total = 0;
+    for(size_t class = 0; class < 3; class++) {
+        total += exp(MATRIX(posterior, 1, class));
+    }
+    test_assert(fabs(total - 1) < 1e-5, "Posteriors sum to one");
+    test_assert(MATRIX(posterior, 1, 1) > MATRIX(posterior, 1, 0), "Posterior favours the predicted class");
+
+    test_assert(bayes_create(p, "unknown", features, 1) == NULL, "Unknown class field is refused");
+
+    matrix *unlabelled = matrix_create_from_list(1, 3, (NN_TYPE[]){NAN, 1, 12});
+    test_assert(probability_append(p, unlabelled) != NULL, "Sample without a class appended");
+    bayes *relabelled = bayes_create(p, "class", features, 1);
+    test_assert(relabelled != NULL && relabelled->classes->length == 3,
+                "Samples without a class are left out of the training");
+    bayes_delete(relabelled);
+    number_delete(unlabelled);
+
+    number_delete(posterior);
+    number_delete(predicted);
+    number_delete(samples);
+    bayes_delete(model);
+    probability_delete(p);
+    number_delete(m);
+
+    return 0;
+}
+
+int test_probability_sampler()
+{
+    size_t rows = 1000;
+    matrix *m = matrix_create(rows, 2);
+    test_assert(m, "Matrix m allocated");
+
+    /* field1 is 1 in 10% of the samples, 2 in 20% and 3 in 70% */
+    for(size_t row = 0; row < rows; row++) {
+        MATRIX(m, row, 0) = row % 10 < 1 ? 1 : row % 10 < 3 ? 2 : 3;
+        MATRIX(m, row, 1) = MATRIX(m, row, 0) * 10;
+    }
+
+    char *fields[] = {"field1", "field2"};
+    probability *p = probability_from_matrix(m, fields);
+    test_assert(p != NULL, "Probability p is not NULL");
+
+    probability_sampler *sampler = probability_sampler_create(p, "field1");
+    test_assert(sampler != NULL, "Sampler created");
+
+    vector *draws = vector_create(100000);
+    test_assert(probability_sampler_draw(sampler, draws) == draws, "Events drawn");
+
+    NN_TYPE counts[4] = {0};
+    VECTOR_FOREACH(draws) {
+        counts[(size_t)VECTOR(draws, index)]++;
+    }
+    test_assert(counts[0] == 0, "Only events are drawn");
+    test_assert(fabs(counts[1] / draws->length - 0.1) < 0.01, "Draws of 1 follow P: %f", counts[1] / draws->length);
+    test_assert(fabs(counts[2] / draws->length - 0.2) < 0.01, "Draws of 2 follow P: %f", counts[2] / draws->length);
+    test_assert(fabs(counts[3] / draws->length - 0.7) < 0.01, "Draws of 3 follow P: %f", counts[3] / draws->length);
+
+    matrix *joint = matrix_create(1000, 2);
+    test_assert(probability_draw_samples(p, joint) == joint, "Joint samples drawn");
+    size_t consistent = 0;
+    for(size_t row = 0; row < joint->rows; row++) {
+        consistent += MATRIX(joint, row, 1) == MATRIX(joint, row, 0) * 10;
+    }
+    test_assert(consistent == joint->rows, "Joint samples keep the relation between fields");
+
+    char *sketched[] = {"field1", NULL};
+    probability *summary = probability_from_matrix_sketched(m, fields, sketched);
+    test_assert(summary != NULL, "Sketched probability space created");
+    test_assert(probability_sampler_create(summary, "field1") == NULL, "Sketched field isn't sampled");
+    probability_delete(summary);
+
+    number_delete(joint);
+    number_delete(draws);
+    probability_sampler_delete(sampler);
+    probability_delete(p);
+    number_delete(m);
+
+    return 0;
+}
+
 int main() { 
     test_probability_from_matrix(); 
     test_probability_mass_of();
@@ -390,5 +986,16 @@ int main() {
     test_probability_variance();
     test_probability_covariance();
     test_probability_correlation();
+    test_probability_append();
+    test_probability_sliding_window();
+    test_probability_from_matrix_ref();
+    test_probability_batch();
+    test_probability_cache();
+    test_probability_sketched();
+    test_probability_binned();
+    test_probability_expected_value_of_function();
+    test_probability_mutual_information();
+    test_bayes();
+    test_probability_sampler();
    // test_probability_conditional();
 }
@@ -0,0 +1,143 @@
+/**
+ * Test for the softmax and normalization methods in the Naive Numbers library
+ *
+ * This test verifies softmax, log-softmax, log-sum-exp and L1/L2
+ * normalization for vectors and for every row of a matrix.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+// Test the vector kernels, including values that overflow a naive e^x
+int test_vector_softmax() {
+    printf("\n=== Testing Vector Softmax ===\n");
+
+    NN_TYPE values[] = {1, 2, 3, 4, 5, 6, 7};
+    double sum = 0;
+    for (size_t i = 0; i < 7; i++) {
+        sum += exp(values[i]);
+    }
+
+    vector *v = vector_from_list(7, values);
+    test_assert(fabs(vector_log_sum_exp(v) - log(sum)) < 1e-5, "Log-sum-exp of small values");
+
+    vector_softmax(v);
+    int matches = 1;
+    for (size_t i = 0; i < 7; i++) {
+        matches &= fabs(VECTOR(v, i) - exp(values[i]) / sum) < 1e-6;
+    }
+    test_assert(matches, "Softmax matches e^x / sum(e^x)");
+    test_assert(fabs(vector_sum(v) - 1) < 1e-6, "Softmax sums to 1");
+    number_delete((number*)v);
+
+    v = vector_from_list(7, values);
+    vector_log_softmax(v);
+    matches = 1;
+    for (size_t i = 0; i < 7; i++) {
+        matches &= fabs(VECTOR(v, i) - (values[i] - log(sum))) < 1e-5;
+    }
+    test_assert(matches, "Log-softmax matches x - log(sum(e^x))");
+    number_delete((number*)v);
+
+    v = vector_from_list(3, (NN_TYPE[]){1000, 1000, -INFINITY});
+    test_assert(fabs(vector_log_sum_exp(v) - (1000 + log(2))) < 1e-3, "Log-sum-exp doesn't overflow");
+    vector_softmax(v);
+    test_assert(fabs(VECTOR(v, 0) - 0.5) < 1e-6 && VECTOR(v, 2) == 0, "Softmax doesn't overflow");
+    number_delete((number*)v);
+
+    return 0;
+}
+
+// Test L1 and L2 normalization and vector_unit
+int test_vector_normalize() {
+    printf("\n=== Testing Vector Normalize ===\n");
+
+    vector *v = vector_normalize(vector_from_list(5, (NN_TYPE[]){3, -4, 0, 0, 0}), 2);
+    test_assert(fabs(VECTOR(v, 0) - 0.6) < 1e-6 && fabs(VECTOR(v, 1) + 0.8) < 1e-6, "L2 normalization");
+    number_delete((number*)v);
+
+    v = vector_normalize(vector_from_list(5, (NN_TYPE[]){1, -1, 2, 0, 4}), 1);
+    test_assert(fabs(VECTOR(v, 1) + 0.125) < 1e-6 && fabs(VECTOR(v, 4) - 0.5) < 1e-6, "L1 normalization");
+    number_delete((number*)v);
+
+    v = vector_normalize(vector_create(6), 2);
+    test_assert(v && VECTOR(v, 0) == 0, "Zero vector is left unchanged");
+    test_assert(vector_normalize(v, 3) == NULL, "Other norms are rejected");
+    number_delete((number*)v);
+
+    vector *original = vector_from_list(2, (NN_TYPE[]){6, 8});
+    vector *unit = vector_unit(original);
+    test_assert(fabs(VECTOR(unit, 0) - 0.6) < 1e-6 && VECTOR(original, 0) == 6, "Unit vector is a normalized copy");
+    number_delete((number*)original);
+    number_delete((number*)unit);
+
+    return 0;
+}
+
+// Test the row-wise kernels on a matrix big enough to run in parallel
+int test_matrix_rows() {
+    printf("\n=== Testing Matrix Rows ===\n");
+
+    matrix *A = matrix_random_uniform(matrix_create(500, 37), -10, 10);
+    matrix *B = matrix_clone(A);
+    vector *lse = matrix_log_sum_exp_rows(A, NULL);
+    int matches = 1;
+
+    matrix_softmax_rows(A);
+    matrix_log_softmax_rows(B);
+    for (size_t row = 0; row < A->rows; row++) {
+        double sum = 0;
+        for (size_t column = 0; column < A->columns; column++) {
+            sum += MATRIX(A, row, column);
+            matches &= fabs(log(MATRIX(A, row, column)) - MATRIX(B, row, column)) < 1e-4;
+        }
+        matches &= fabs(sum - 1) < 1e-5;
+    }
+    test_assert(matches, "Every row sums to 1 and log-softmax is its log");
+    test_assert(lse && lse->length == A->rows, "Log-sum-exp of every row");
+
+    matrix_normalize_rows(matrix_random_uniform(A, -1, 1), 2);
+    matches = 1;
+    for (size_t row = 0; row < A->rows; row++) {
+        double norm = 0;
+        for (size_t column = 0; column < A->columns; column++) {
+            norm += MATRIX(A, row, column) * MATRIX(A, row, column);
+        }
+        matches &= fabs(norm - 1) < 1e-5;
+    }
+    test_assert(matches, "Every row has an L2 norm of 1");
+
+    number_delete((number*)A);
+    number_delete((number*)B);
+    number_delete((number*)lse);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Softmax Test ===\n");
+
+    int result = 0;
+    result |= test_vector_softmax();
+    result |= test_vector_normalize();
+    result |= test_matrix_rows();
+
+    if (result == 0) {
+        printf("\nAll softmax tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
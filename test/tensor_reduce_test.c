@@ -0,0 +1,213 @@
+/**
+ * Test for the tensor reductions in the Naive Numbers library
+ *
+ * This test verifies tensor_reduce against plain loops over every element,
+ * for sets of dimensions, views and tensors large enough to be reduced in
+ * parallel.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+static const char *names[] = {"sum", "mean", "min", "max", "argmin", "argmax", "variance", "L1 norm", "L2 norm"};
+
+// Reduces the dimensions of T flagged in `is_reduced` with plain loops, into row-major results
+static double *reduce(const tensor *T, const int *is_reduced, enum nn_reduction reduction) {
+    size_t outputs = 1, length = 1, indexes[TENSOR_MAX_RANK] = {0};
+    for (size_t axis = 0; axis < T->rank; axis++) {
+        if (is_reduced[axis]) length *= T->shape[axis]; else outputs *= T->shape[axis];
+    }
+
+    double *result = malloc(outputs * sizeof(double));
+    double *mean = calloc(outputs, sizeof(double));
+    size_t *at = calloc(outputs, sizeof(size_t));
+    for (size_t output = 0; output < outputs; output++) {
+        result[output] = reduction == NN_MIN || reduction == NN_ARGMIN ? INFINITY
+                       : reduction == NN_MAX || reduction == NN_ARGMAX ? -INFINITY : 0;
+    }
+
+    for (int pass = 0; pass < 2; pass++) {
+        for (size_t element = 0; element < T->length; element++) {
+            size_t output = 0, position = 0;
+            for (size_t axis = 0; axis < T->rank; axis++) {
+                if (is_reduced[axis]) position = position * T->shape[axis] + indexes[axis];
+                else output = output * T->shape[axis] + indexes[axis];
+            }
+            double x = tensor_get(T, indexes);
+
+            if (0 == pass) {
+                mean[output] += x / length;
+            } else {
+                switch (reduction) {
+                case NN_SUM: case NN_MEAN: result[output] += x; break;
+                case NN_VARIANCE: result[output] += (x - mean[output]) * (x - mean[output]); break;
+                case NN_L1_NORM: result[output] += fabs(x); break;
+                case NN_L2_NORM: result[output] += x * x; break;
+                case NN_MIN: result[output] = fmin(result[output], x); break;
+                case NN_MAX: result[output] = fmax(result[output], x); break;
+                case NN_ARGMIN:
+                    if (x < result[output] || (x == result[output] && position < at[output])) {
+                        result[output] = x; at[output] = position;
+                    }
+                    break;
+                case NN_ARGMAX:
+                    if (x > result[output] || (x == result[output] && position < at[output])) {
+                        result[output] = x; at[output] = position;
+                    }
+                    break;
+                }
+            }
+
+            for (size_t axis = T->rank; axis-- > 0;) {
+                if (++indexes[axis] < T->shape[axis]) break;
+                indexes[axis] = 0;
+            }
+        }
+    }
+
+    for (size_t output = 0; output < outputs; output++) {
+        switch (reduction) {
+        case NN_MEAN: case NN_VARIANCE: result[output] /= length; break;
+        case NN_L2_NORM: result[output] = sqrt(result[output]); break;
+        case NN_ARGMIN: case NN_ARGMAX: result[output] = at[output]; break;
+        default: break;
+        }
+    }
+
+    free(mean);
+    free(at);
+    return result;
+}
+
+// Checks every reduction of T over `axes` against the plain loops
+static int check_reductions(const tensor *T, size_t count, const size_t *axes, const char *label) {
+    int is_reduced[TENSOR_MAX_RANK] = {0};
+    for (size_t axis = 0; axis < count; axis++) {
+        is_reduced[axes[axis]] = 1;
+    }
+
+    for (int reduction = NN_SUM; reduction <= NN_L2_NORM; reduction++) {
+        tensor *R = tensor_reduce(T, count, axes, reduction, 1);
+        double *expected = reduce(T, is_reduced, reduction);
+        int matches = R != NULL && R->rank == T->rank;
+
+        for (size_t axis = 0; matches && axis < T->rank; axis++) {
+            matches &= R->shape[axis] == (is_reduced[axis] ? 1 : T->shape[axis]);
+        }
+        for (size_t i = 0; matches && i < R->length; i++) {
+            double x = VECTOR(R->number.values, i);
+            matches &= fabs(x - expected[i]) <= 1e-3 * (1 + fabs(expected[i]));
+        }
+        free(expected);
+        number_delete((number*)R);
+        test_assert(matches, "%s of %s", names[reduction], label);
+    }
+
+    return 0;
+}
+
+// Test reductions over sets of dimensions of contiguous tensors and views
+int test_tensor_reduce() {
+    printf("\n=== Testing Tensor Reductions ===\n");
+
+    // Small integers, so that argmin and argmax meet ties
+    size_t shape[] = {4, 3, 5, 6};
+    tensor *T = tensor_create(4, shape);
+    for (size_t i = 0; i < T->length; i++) {
+        VECTOR(T->number.values, i) = (NN_TYPE)((i * 7919) % 13) - 6;
+    }
+
+    int result = 0;
+    result |= check_reductions(T, 3, (size_t[]){0, 2, 3}, "every channel of N x C x H x W");
+    result |= check_reductions(T, 1, (size_t[]){3}, "the last dimension");
+    result |= check_reductions(T, 1, (size_t[]){0}, "the first dimension");
+    result |= check_reductions(T, 2, (size_t[]){3, 1}, "two dimensions apart");
+    result |= check_reductions(T, 4, (size_t[]){0, 1, 2, 3}, "every dimension");
+    result |= check_reductions(T, 0, (size_t[]){0}, "no dimension");
+
+    tensor *P = tensor_permute(T, (size_t[]){2, 0, 3, 1});
+    result |= check_reductions(P, 2, (size_t[]){1, 3}, "a permuted view");
+    tensor *S = tensor_view(T, 3, (size_t[]){4, 3, 3}, (size_t[]){90, 30, 2}, 7);
+    result |= check_reductions(S, 1, (size_t[]){2}, "a strided view");
+    result |= check_reductions(S, 2, (size_t[]){0, 1}, "the outer dimensions of a strided view");
+    if (result) {
+        return result;
+    }
+
+    tensor *dropped = tensor_reduce(T, 2, (size_t[]){1, 3}, NN_MAX, 0);
+    tensor *all = tensor_reduce(T, 0, NULL, NN_SUM, 0);
+    test_assert(dropped && dropped->rank == 2 && dropped->shape[0] == 4 && dropped->shape[1] == 5
+                && all && all->rank == 1 && all->shape[0] == 1, "Reduced dimensions are dropped");
+
+    test_assert(tensor_reduce(T, 1, (size_t[]){4}, NN_SUM, 1) == NULL, "Wrong dimensions are rejected");
+    test_assert(tensor_reduce(T, 2, (size_t[]){1, 1}, NN_SUM, 1) == NULL, "Repeated dimensions are rejected");
+
+    // A broadcast view reduces more elements than NN_TYPE positions can tell apart, without storing them
+    tensor *one = tensor_create(1, (size_t[]){1});
+    tensor *wide = tensor_broadcast(one, 1, (size_t[]){MATRIX_REDUCE_POSITIONS + 1});
+    test_assert(wide && tensor_reduce(wide, 0, NULL, NN_ARGMAX, 0) == NULL,
+                "Argmax of more than MATRIX_REDUCE_POSITIONS elements is rejected");
+    number_delete((number*)one);
+    number_delete((number*)wide);
+
+    number_delete((number*)T);
+    number_delete((number*)P);
+    number_delete((number*)S);
+    number_delete((number*)dropped);
+    number_delete((number*)all);
+
+    return 0;
+}
+
+// Test tensors large enough to be reduced in parallel, over few and over many results
+int test_tensor_reduce_parallel() {
+    printf("\n=== Testing Parallel Tensor Reductions ===\n");
+
+    size_t shape[] = {3000, 7, 11};
+    tensor *T = tensor_create(3, shape);
+    vector_random_uniform(T->number.values, -1, 1);
+    VECTOR(T->number.values, 12345) = 2;
+
+    int result = 0;
+    result |= check_reductions(T, 1, (size_t[]){0}, "the batch of 3000 x 7 x 11");
+    result |= check_reductions(T, 2, (size_t[]){1, 2}, "every sample of 3000 x 7 x 11");
+    result |= check_reductions(T, 3, (size_t[]){0, 1, 2}, "all of 3000 x 7 x 11");
+    if (result) {
+        return result;
+    }
+
+    tensor *at = tensor_reduce(T, 0, NULL, NN_ARGMAX, 0);
+    test_assert(TENSOR1(at, 0) == 12345, "Argmax of a whole tensor is its flat index");
+
+    number_delete((number*)T);
+    number_delete((number*)at);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Tensor Reduce Test ===\n");
+
+    int result = 0;
+    result |= test_tensor_reduce();
+    result |= test_tensor_reduce_parallel();
+
+    if (result == 0) {
+        printf("\nAll tensor reduce tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
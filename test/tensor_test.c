@@ -0,0 +1,302 @@
+/**
+ * Test for the tensors in the Naive Numbers library
+ *
+ * This test verifies the creation of 4-D and 5-D tensors, strided views over
+ * their storage, contiguous copies, element-wise operations and deletion.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+// Test the layout of a N x C x H x W batch created from a flat vector
+int test_tensor_create() {
+    printf("\n=== Testing Tensor Creation ===\n");
+
+    size_t shape[] = {2, 3, 4, 5};
+    vector *v = vector_create(120);
+    for (size_t i = 0; i < v->length; i++) {
+        VECTOR(v, i) = (NN_TYPE)i;
+    }
+
+    tensor *T = tensor_from_vector(v, 4, shape);
+    test_assert(T && T->length == 120 && tensor_is_contiguous(T), "4-D tensor over a vector");
+    test_assert(T->strides[0] == 60 && T->strides[1] == 20 && T->strides[2] == 5
+                && T->strides[3] == 1, "Row-major strides");
+    test_assert(TENSOR(T, (size_t)1, (size_t)2, (size_t)3, (size_t)4) == 119
+                && TENSOR4(T, 1, 2, 3, 4) == 119,
+                "Variadic accessor reads the last element");
+
+    size_t indexes[] = {1, 0, 2, 3};
+    tensor_set(T, indexes, -1);
+    test_assert(VECTOR(v, 60 + 10 + 3) == -1 && tensor_get(T, indexes) == -1,
+                "Tensor shares the elements of the vector");
+
+    number_unref((number*)v);
+    test_assert(tensor_get(T, indexes) == -1, "Tensor keeps the storage alive");
+
+    size_t wrong[] = {7, 7};
+    test_assert(tensor_from_vector(T->number.values, 2, wrong) == NULL,
+                "Shape must match the vector length");
+
+    size_t shape5[] = {2, 1, 3, 2, 2};
+    tensor *U = tensor_create(5, shape5);
+    test_assert(U && U->length == 24 && VECTOR(U->number.values, 23) == 0, "5-D tensor of zeros");
+
+    number_delete((number*)T);
+    number_delete((number*)U);
+
+    return 0;
+}
+
+// Test views sharing the storage of a tensor
+int test_tensor_view() {
+    printf("\n=== Testing Tensor Views ===\n");
+
+    size_t shape[] = {2, 3, 4, 5};
+    tensor *T = tensor_create(4, shape);
+    for (size_t i = 0; i < T->length; i++) {
+        VECTOR(T->number.values, i) = (NN_TYPE)i;
+    }
+
+    // Channel 1 of every sample, every other column
+    size_t view_shape[] = {2, 4, 3};
+    size_t view_strides[] = {60, 5, 2};
+    tensor *V = tensor_view(T, 3, view_shape, view_strides, 20);
+    test_assert(V && !tensor_is_contiguous(V), "Strided view is not contiguous");
+
+    size_t at[] = {1, 3, 2};
+    test_assert(tensor_get(V, at) == 60 + 20 + 15 + 4, "View reads through its strides");
+
+    tensor *C = tensor_clone(V);
+    test_assert(C && tensor_is_contiguous(C) && tensor_is_equal(C, V) == 1,
+                "Clone of a view is contiguous and equal");
+
+    size_t too_far[] = {3, 4, 3};
+    test_assert(tensor_view(T, 3, too_far, view_strides, 20) == NULL,
+                "View can't reach past the storage");
+
+    // Transposed view of the last two dimensions
+    size_t t_shape[] = {2, 3, 5, 4};
+    size_t t_strides[] = {60, 20, 1, 5};
+    tensor *Tt = tensor_view(T, 4, t_shape, t_strides, 0);
+    size_t t_at[] = {1, 2, 4, 3};
+    size_t at_t[] = {1, 2, 3, 4};
+    test_assert(tensor_get(Tt, t_at) == tensor_get(T, at_t), "Transposed view");
+
+    number_delete((number*)T);
+    test_assert(tensor_get(V, at) == 99, "View outlives the tensor");
+
+    number_delete((number*)V);
+    number_delete((number*)C);
+    number_delete((number*)Tt);
+
+    return 0;
+}
+
+// Test permuted and reshaped views, and reshaped matrices
+int test_tensor_permute_reshape() {
+    printf("\n=== Testing Tensor Permute and Reshape ===\n");
+
+    // N x H x W x C batch seen as N x C x H x W
+    size_t shape[] = {2, 4, 5, 3};
+    tensor *T = tensor_create(4, shape);
+    for (size_t i = 0; i < T->length; i++) {
+        VECTOR(T->number.values, i) = (NN_TYPE)i;
+    }
+
+    tensor *P = tensor_permute(T, (size_t[]){0, 3, 1, 2});
+    test_assert(P && P->number.values == T->number.values && P->shape[1] == 3
+                && P->strides[1] == 1 && P->strides[3] == 3, "Permute swaps the strides");
+    test_assert(TENSOR4(P, 1, 2, 3, 4) == TENSOR4(T, 1, 3, 4, 2), "Permuted view reads the tensor");
+    test_assert(tensor_permute(T, (size_t[]){0, 1, 1, 2}) == NULL, "Repeated axes are rejected");
+
+    // Splitting and merging contiguous dimensions is a view
+    tensor *R = tensor_reshape(T, 3, (size_t[]){8, 5, 3});
+    test_assert(R && R->number.values == T->number.values && tensor_is_contiguous(R)
+                && TENSOR3(R, 7, 4, 2) == TENSOR4(T, 1, 3, 4, 2), "Reshape of a contiguous tensor is a view");
+
+    // Splitting the last dimension of the permuted view keeps the strides
+    tensor *S = tensor_reshape(P, 5, (size_t[]){2, 3, 4, 1, 5});
+    test_assert(S && S->number.values == T->number.values
+                && TENSOR5(S, 1, 2, 3, 0, 4) == TENSOR4(P, 1, 2, 3, 4), "Compatible reshape of a permuted view");
+
+    // Merging C with H needs a copy
+    tensor *F = tensor_reshape(P, 3, (size_t[]){2, 12, 5});
+    test_assert(F && F->number.values != T->number.values
+                && TENSOR3(F, 1, 11, 4) == TENSOR4(P, 1, 2, 3, 4), "Incompatible reshape is copied");
+    test_assert(tensor_reshape(T, 2, (size_t[]){7, 17}) == NULL, "Reshape to another length is rejected");
+
+    tensor *C = tensor_contiguous(R);
+    tensor *D = tensor_contiguous(P);
+    test_assert(C == R && D != P && tensor_is_contiguous(D) && tensor_is_equal(D, P) == 1,
+                "Only views which aren't contiguous are materialized");
+    number_unref((number*)C);
+    number_unref((number*)D);
+
+    matrix *A = matrix_create(6, 4);
+    void *values = ((vector*)A->number.values)->number.values;
+    test_assert(matrix_reshape(A, 3, 8) && A->rows == 3 && A->columns == 8
+                && ((vector*)A->number.values)->number.values == values,
+                "Matrix reshape of the same length keeps the elements in place");
+    test_assert(matrix_reshape(A, 4, 8) && ((vector*)A->number.values)->length == 32,
+                "Matrix reshape to another length resizes the storage");
+
+    number_delete((number*)T);
+    number_delete((number*)P);
+    number_delete((number*)R);
+    number_delete((number*)S);
+    number_delete((number*)F);
+    number_delete((number*)A);
+
+    return 0;
+}
+
+// Test element-wise operations on dense tensors and on views
+int test_tensor_operations() {
+    printf("\n=== Testing Tensor Operations ===\n");
+
+    size_t shape[] = {4, 3, 16, 17, 5};
+    tensor *T = tensor_create(5, shape);
+    for (size_t i = 0; i < T->length; i++) {
+        VECTOR(T->number.values, i) = (NN_TYPE)(i % 7);
+    }
+    tensor *U = tensor_clone(T);
+
+    tensor_addition(T, number_create(2));
+    tensor_multiplication(T, (number*)tensor_clone(U));
+    int matches = 1;
+    for (size_t i = 0; i < T->length; i++) {
+        NN_TYPE x = (NN_TYPE)(i % 7);
+        matches &= VECTOR(T->number.values, i) == (x + 2) * x;
+    }
+    test_assert(matches, "Dense operations with a scalar and a tensor");
+
+    // Every other element along the last three dimensions, long enough to run in parallel
+    size_t view_shape[] = {4, 3, 8, 9, 3};
+    size_t view_strides[] = {T->strides[0], T->strides[1], 2 * T->strides[2],
+                             2 * T->strides[3], 2};
+    tensor *V = tensor_view(U, 5, view_shape, view_strides, 0);
+    tensor *W = tensor_clone(V);
+
+    tensor_subtraction(V, (number*)tensor_clone(W));
+    tensor_addition(V, integer_create(1));
+    tensor_division(W, number_create(2));
+
+    matches = 1;
+    for (size_t i = 0; i < U->length; i++) {
+        size_t rest = i, indexes[5];
+        for (size_t axis = 5; axis-- > 0;) {
+            indexes[axis] = rest % shape[axis];
+            rest /= shape[axis];
+        }
+        int is_viewed = indexes[2] % 2 == 0 && indexes[3] % 2 == 0 && indexes[4] % 2 == 0;
+        matches &= VECTOR(U->number.values, i) == (is_viewed ? 1 : (NN_TYPE)(i % 7));
+    }
+    test_assert(matches, "Operations on a view change the viewed elements only");
+
+    size_t at[] = {3, 2, 7, 8, 2};
+    size_t source = (((3 * 3 + 2) * 16 + 14) * 17 + 16) * 5 + 4;
+    test_assert(tensor_get(W, at) == (NN_TYPE)(source % 7) / 2, "Division of a contiguous copy");
+
+    tensor_seed(W, 4);
+    tensor_map_builtin(W, NN_SQRT, NN_PRECISE);
+    test_assert(tensor_get(W, at) == 2, "Built-in map of a tensor");
+
+    tensor_map_builtin(V, NN_EXP, NN_PRECISE);
+    test_assert(fabs(tensor_get(V, at) - expf(1)) < 1e-5, "Built-in map of a strided view");
+
+    tensor_addition(T, (number*)U);
+    test_assert(tensor_addition(T, (number*)W) == NULL, "Shapes must match");
+
+    number_delete((number*)T);
+    number_delete((number*)V);
+    number_delete((number*)W);
+
+    return 0;
+}
+
+// Test the rank-specialized accessors and iterators against tensor_get()
+int test_tensor_accessors() {
+    printf("\n=== Testing Tensor Accessors ===\n");
+
+    size_t shape[] = {2, 3, 4, 5, 2, 3};
+    tensor *T = tensor_create(6, shape);
+    for (size_t i = 0; i < T->length; i++) {
+        VECTOR(T->number.values, i) = (NN_TYPE)i;
+    }
+
+    size_t at[] = {1, 2, 3, 4, 1, 2};
+    test_assert(TENSOR6(T, 1, 2, 3, 4, 1, 2) == tensor_get(T, at), "6-D accessor");
+
+    TENSOR6(T, 1, 2, 3, 4, 1, 2) = -1;
+    test_assert(tensor_get(T, at) == -1, "Accessors are assignable");
+
+    // Transposed 3-D view: H x W x C of the first sample
+    size_t view_shape[] = {4, 5, 3};
+    size_t view_strides[] = {30, 6, 120};
+    size_t view_at[3];
+    tensor *V = tensor_view(T, 3, view_shape, view_strides, 0);
+    int matches = 1;
+    size_t visited = 0;
+    TENSOR_FOREACH3(V, i, j, k, position) {
+        view_at[0] = i;
+        view_at[1] = j;
+        view_at[2] = k;
+        matches &= VECTOR(V->number.values, position) == TENSOR3(V, i, j, k)
+                   && TENSOR3(V, i, j, k) == tensor_get(V, view_at);
+        matches &= visited++ == (i * 5 + j) * 3 + k;
+    }
+    test_assert(matches && visited == 60, "3-D iterator over a transposed view");
+
+    NN_TYPE sum = 0, expected = 0;
+    TENSOR_FOREACH6(T, i, j, k, l, m, n, position) {
+        sum += VECTOR(T->number.values, position);
+        expected += TENSOR6(T, i, j, k, l, m, n);
+    }
+    test_assert(sum == expected, "6-D iterator visits every element");
+
+    tensor *M = tensor_view(T, 2, (size_t[]){6, 120}, NULL, 0);
+    TENSOR_FOREACH2(M, row, column, position) {
+        VECTOR(M->number.values, position) = (NN_TYPE)row;
+    }
+    tensor *F = tensor_view(T, 1, (size_t[]){T->length}, NULL, 0);
+    test_assert(TENSOR1(F, 0) == 0 && TENSOR1(F, 719) == 5,
+                "2-D iterator writes through a reshaped view");
+
+    number_delete((number*)T);
+    number_delete((number*)V);
+    number_delete((number*)M);
+    number_delete((number*)F);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Tensor Test ===\n");
+
+    int result = 0;
+    result |= test_tensor_create();
+    result |= test_tensor_view();
+    result |= test_tensor_permute_reshape();
+    result |= test_tensor_operations();
+    result |= test_tensor_accessors();
+
+    if (result == 0) {
+        printf("\nAll tensor tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
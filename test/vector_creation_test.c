@@ -60,6 +60,9 @@ int test_vector_creation() {
     test_assert((VECTOR(v4, 0) - 1.1) < NN_TYPE_EPSILON, "vector_reshape preserves existing values");
     test_assert((VECTOR(v4, 4) - 5.5) < NN_TYPE_EPSILON, "vector_reshape preserves last original value");
     test_assert((VECTOR(v4, 5) - 0.0) < NN_TYPE_EPSILON, "vector_reshape initializes new values to 0");
+    void *elements = v4->number.values;
+    test_assert(vector_reshape(v4, 8) == v4 && v4->number.values == elements,
+                "vector_reshape to the same length keeps the elements in place");
     
     // Clean up
     number_delete((number*)v1);
@@ -371,6 +371,73 @@ int test_vector_map_performance() {
     return 0;
 }
 
+// Test the built-in operations against the C library, at both accuracies
+int test_builtin_vector_map() {
+    printf("\n=== Testing Built-in Vector Map ===\n");
+
+    enum nn_map operations[] = {NN_EXP, NN_LOG, NN_TANH, NN_SIGMOID, NN_SQRT};
+    const char *names[] = {"exp", "log", "tanh", "sigmoid", "sqrt"};
+    double tolerances[] = {1e-6, 2e-4};
+
+    for (size_t op = 0; op < 5; op++) {
+        for (int accuracy = NN_PRECISE; accuracy <= NN_FAST; accuracy++) {
+            vector *v = vector_create(1003);
+            for (size_t i = 0; i < v->length; i++) {
+                VECTOR(v, i) = operations[op] == NN_LOG || operations[op] == NN_SQRT
+                                   ? (NN_TYPE)exp(-20.0 + 40.0 * i / v->length)
+                                   : (NN_TYPE)(-20.0 + 40.0 * i / v->length);
+            }
+
+            vector *mapped = vector_map_builtin(vector_clone(v), operations[op], accuracy);
+            double worst = 0;
+
+            for (size_t i = 0; i < v->length; i++) {
+                double x = VECTOR(v, i);
+                double expected = operations[op] == NN_EXP ? exp(x)
+                                : operations[op] == NN_LOG ? log(x)
+                                : operations[op] == NN_TANH ? tanh(x)
+                                : operations[op] == NN_SIGMOID ? 1 / (1 + exp(-x))
+                                : sqrt(x);
+                double error = fabs(VECTOR(mapped, i) - expected) / fmax(fabs(expected), 1e-3);
+
+                worst = fmax(worst, error);
+            }
+            test_assert(worst < tolerances[accuracy], "Built-in %s at %s accuracy within %g (%g)",
+                        names[op], accuracy == NN_PRECISE ? "precise" : "fast", tolerances[accuracy], worst);
+
+            number_delete((number*)v);
+            number_delete((number*)mapped);
+        }
+    }
+
+    vector *special = vector_from_list(4, (NN_TYPE[]){0, -1, INFINITY, 200});
+    vector_map_builtin(special, NN_LOG, NN_PRECISE);
+    test_assert(isinf(VECTOR(special, 0)) && VECTOR(special, 0) < 0, "log(0) is -inf");
+    test_assert(isnan(VECTOR(special, 1)), "log(-1) is NaN");
+    test_assert(isinf(VECTOR(special, 2)), "log(inf) is inf");
+    number_delete((number*)special);
+
+    special = vector_from_list(3, (NN_TYPE[]){200, -200, NAN});
+    vector_map_builtin(special, NN_EXP, NN_PRECISE);
+    test_assert(isinf(VECTOR(special, 0)) && VECTOR(special, 1) == 0 && isnan(VECTOR(special, 2)),
+                "exp overflows to inf, underflows to 0 and keeps NaN");
+    number_delete((number*)special);
+
+    vector *powers = vector_pow(vector_from_list(5, (NN_TYPE[]){2, -2, 0, 0.5, 10}), 3, NN_PRECISE);
+    test_assert(fabs(VECTOR(powers, 0) - 8) < 1e-5 && fabs(VECTOR(powers, 1) + 8) < 1e-5,
+                "Odd powers keep the sign");
+    test_assert(VECTOR(powers, 2) == 0 && fabs(VECTOR(powers, 3) - 0.125) < 1e-6
+                && fabs(VECTOR(powers, 4) - 1000) < 1e-3, "Powers of 0, fractions and tens");
+    number_delete((number*)powers);
+
+    powers = vector_pow(vector_from_list(2, (NN_TYPE[]){4, -4}), 0.5, NN_PRECISE);
+    test_assert(fabs(VECTOR(powers, 0) - 2) < 1e-6 && isnan(VECTOR(powers, 1)),
+                "Fractional powers of negative values are NaN");
+    number_delete((number*)powers);
+
+    return 0;
+}
+
 int main() {
     printf("=== Naive Numbers Vector Map Test ===\n");
     
@@ -388,6 +455,7 @@ int main() {
     result |= test_threshold_vector_map();
     result |= test_rounding_vector_map();
     result |= test_vector_map_performance();
+    result |= test_builtin_vector_map();
     
     if (result == 0) {
         printf("\nAll vector_map tests passed successfully!\n");
@@ -0,0 +1,125 @@
+/**
+ * Test for the prefix sums in the Naive Numbers library
+ *
+ * This test verifies the inclusive and exclusive scans, the range sums and
+ * the cached prefix sums with their invalidation.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+// Test the scans against a running sum, short and long enough to run in parallel
+int test_vector_scan() {
+    printf("\n=== Testing Vector Scan ===\n");
+
+    size_t lengths[] = {1, 7, 13, 200000};
+
+    for (size_t test = 0; test < sizeof(lengths) / sizeof(lengths[0]); test++) {
+        vector *v = vector_create(lengths[test]);
+        for (size_t i = 0; i < v->length; i++) {
+            VECTOR(v, i) = (NN_TYPE)(i % 5);
+        }
+
+        vector *inclusive = vector_scan_inclusive(v, NULL);
+        vector *exclusive = vector_scan_exclusive(v, NULL);
+        NN_TYPE sum = 0;
+        int matches = 1;
+
+        for (size_t i = 0; i < v->length; i++) {
+            matches &= VECTOR(exclusive, i) == sum;
+            sum += VECTOR(v, i);
+            matches &= VECTOR(inclusive, i) == sum;
+        }
+        test_assert(matches, "Scans of %zu elements match the running sum", v->length);
+
+        vector_scan_exclusive(v, v);
+        test_assert(VECTOR(v, 0) == 0 && VECTOR(v, v->length - 1) == VECTOR(exclusive, v->length - 1),
+                    "Exclusive scan of %zu elements works in place", v->length);
+
+        number_delete(inclusive);
+        number_delete(exclusive);
+        number_delete(v);
+    }
+
+    return 0;
+}
+
+// Test the range sums with and without cached prefix sums
+int test_vector_prefix_cache() {
+    printf("\n=== Testing Vector Prefix Cache ===\n");
+
+    vector *v = vector_from_list(6, (NN_TYPE[]) {1, 2, 3, 4, 5, 6});
+
+    test_assert(vector_sum(v) == 21, "Sum without cache");
+    test_assert(vector_sum_to(v, 2) == 6, "Sum to an index includes it");
+    test_assert(vector_sum_to(v, 100) == 21, "Sum to an index past the end");
+    test_assert(vector_sum_between(v, 1, 4) == 9, "Sum between excludes the last index");
+    test_assert(vector_sum_between(v, 4, 4) == 0, "Empty range sums to 0");
+
+    test_assert(vector_prefix_cache(v) == v && v->prefix, "Prefix sums cached");
+    test_assert(vector_sum_to(v, 2) == 6, "Cached sum to an index");
+    test_assert(vector_sum_to(v, 100) == 21, "Cached sum to an index past the end");
+    test_assert(vector_sum_between(v, 1, 4) == 9, "Cached sum between");
+    test_assert(vector_sum_between(v, 0, 6) == 21, "Cached sum of the whole vector");
+
+    vector_seed(v, 2);
+    test_assert(!v->prefix, "Seeding drops the cache");
+    test_assert(vector_sum_between(v, 1, 4) == 6, "Sum between after seeding");
+
+    vector_prefix_cache(v);
+    vector_sort(v);
+    test_assert(!v->prefix, "Sorting drops the cache");
+
+    vector_prefix_cache(v);
+    VECTOR(v, 0) = 100;
+    vector_prefix_invalidate(v);
+    test_assert(vector_sum_to(v, 0) == 100, "Manual invalidation after a direct write");
+
+    vector_prefix_cache(v);
+    number_delete(v);
+
+    matrix *m = matrix_create_from_list(2, 2, (NN_TYPE[]) {1, 2, 3, 4});
+    vector *values = m->number.values;
+
+    vector_prefix_cache(values);
+    matrix_softmax_rows(m);
+    test_assert(!values->prefix, "Row softmax drops the cache");
+    vector_prefix_cache(values);
+    matrix_normalize_rows(m, 1);
+    test_assert(!values->prefix, "Row normalization drops the cache");
+    vector_prefix_cache(values);
+    matrix_permute_rows(m, (size_t[]) {1, 0});
+    test_assert(!values->prefix, "Row permutation drops the cache");
+    test_assert(fabs(vector_sum_to(values, 1) - 1) < 1e-6, "Sum of a permuted row");
+
+    number_delete(m);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Vector Scan Test ===\n");
+
+    int result = 0;
+    result |= test_vector_scan();
+    result |= test_vector_prefix_cache();
+
+    if (result == 0) {
+        printf("\nAll vector scan tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
@@ -0,0 +1,121 @@
+/**
+ * Test for the search methods in the Naive Numbers library
+ *
+ * This test verifies vector_index_of, vector_index_of_batch and the sorted
+ * searches, vector_lower_bound and the Eytzinger layout.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+// Test finding single values
+int test_vector_index_of() {
+    printf("\n=== Testing Vector Index Of ===\n");
+
+    vector *v = vector_create(11);
+    for (size_t i = 0; i < v->length; i++) {
+        VECTOR(v, i) = (NN_TYPE)(i % 6);
+    }
+
+    test_assert(vector_index_of(v, 0) == 0, "First element found");
+    test_assert(vector_index_of(v, 3) == 3, "Element in the first block found");
+    test_assert(vector_index_of(v, 5) == 5, "Element in the second block found");
+    VECTOR(v, 10) = 42;
+    test_assert(vector_index_of(v, 42) == 10, "Element in the tail found");
+    test_assert(vector_index_of(v, 7) == -1, "Missing element not found");
+    number_delete(v);
+
+    return 0;
+}
+
+// Test finding many values at once
+int test_vector_index_of_batch() {
+    printf("\n=== Testing Vector Index Of Batch ===\n");
+
+    vector *v = vector_create(1000);
+    for (size_t i = 0; i < v->length; i++) {
+        VECTOR(v, i) = (NN_TYPE)((i * 37) % 500);
+    }
+
+    for (size_t length = 3; length <= 300; length *= 100) {
+        vector *needles = vector_create(length);
+        for (size_t i = 0; i < length; i++) {
+            VECTOR(needles, i) = (NN_TYPE)i * 2 - 1;
+        }
+
+        int *found = vector_index_of_batch(v, needles, NULL);
+        test_assert(found != NULL, "Batch of %zu needles searched", length);
+        int matches = 1;
+        for (size_t i = 0; i < length; i++) {
+            matches &= found[i] == vector_index_of(v, VECTOR(needles, i));
+        }
+        test_assert(matches, "Batch of %zu needles matches single searches", length);
+
+        free(found);
+        number_delete(needles);
+    }
+    number_delete(v);
+
+    return 0;
+}
+
+// Test the sorted searches
+int test_vector_sorted_search() {
+    printf("\n=== Testing Sorted Search ===\n");
+
+    vector *sorted = vector_create(1000);
+    for (size_t i = 0; i < sorted->length; i++) {
+        VECTOR(sorted, i) = (NN_TYPE)(i / 2) * 3;
+    }
+
+    test_assert(vector_lower_bound(sorted, -5) == 0, "Lower bound before every element");
+    test_assert(vector_lower_bound(sorted, 30) == 20, "Lower bound on equal elements is the first one");
+    test_assert(vector_lower_bound(sorted, 31) == 22, "Lower bound between elements");
+    test_assert(vector_lower_bound(sorted, 5000) == 1000, "Lower bound after every element");
+
+    vector *layout = vector_eytzinger(sorted, NULL);
+    test_assert(layout != NULL, "Eytzinger layout built");
+    int matches = 1;
+    for (NN_TYPE needle = -2; needle < 1500; needle += 0.5) {
+        size_t rank = vector_lower_bound(sorted, needle);
+        size_t node = vector_eytzinger_lower_bound(layout, needle);
+
+        matches &= rank == sorted->length ? node == layout->length
+                                          : node < layout->length && VECTOR(layout, node) == VECTOR(sorted, rank);
+    }
+    test_assert(matches, "Eytzinger search matches the binary search");
+
+    number_delete(layout);
+    number_delete(sorted);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Vector Search Test ===\n");
+
+    int result = 0;
+    result |= test_vector_index_of();
+    result |= test_vector_index_of_batch();
+    result |= test_vector_sorted_search();
+
+    if (result == 0) {
+        printf("\nAll vector search tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}
@@ -0,0 +1,171 @@
+/**
+ * Test for the sorting and selection methods in the Naive Numbers library
+ *
+ * This test verifies vector_sort, vector_argsort, vector_nth, vector_top_k
+ * and vector_quantiles, on short vectors and on vectors long enough for the
+ * parallel paths.
+ */
+
+#include <nn.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <math.h>
+
+// Simple test assertion macro
+#define test_assert(test, message, ...)                                        \
+    if (!(test)) {                                                             \
+        printf("ERROR: " message "\n", ##__VA_ARGS__);                         \
+        return 1;                                                              \
+    } else {                                                                   \
+        printf("OK: " message "\n", ##__VA_ARGS__);                            \
+    }
+
+// Test sorting short and long vectors
+int test_vector_sort() {
+    printf("\n=== Testing Vector Sort ===\n");
+
+    NN_TYPE values[] = {3.5, -1, 0, -0.25, 7, -INFINITY, 2, -1, INFINITY, 0.5};
+    vector *v = vector_from_list(10, values);
+    test_assert(vector_sort(v) == v, "Short vector sorted");
+    NN_TYPE sorted[] = {-INFINITY, -1, -1, -0.25, 0, 0.5, 2, 3.5, 7, INFINITY};
+    for (size_t i = 0; i < 10; i++) {
+        test_assert(VECTOR(v, i) == sorted[i], "Element %zu is %f", i, VECTOR(v, i));
+    }
+    number_delete(v);
+
+    vector *nans = vector_from_list(4, (NN_TYPE[]){1, -NAN, -2, NAN});
+    test_assert(vector_sort(nans) == nans, "Vector with NaNs sorted");
+    test_assert(VECTOR(nans, 0) == -2 && VECTOR(nans, 1) == 1 && isnan(VECTOR(nans, 2)) && isnan(VECTOR(nans, 3)),
+                "NaNs go last whatever their sign");
+    number_delete(nans);
+
+    vector *large = vector_create(1000003);
+    vector_random_normal(large, 0, 100);
+    test_assert(vector_sort(large) == large, "Long vector sorted");
+    int ordered = 1;
+    for (size_t i = 1; i < large->length; i++) {
+        ordered &= VECTOR(large, i - 1) <= VECTOR(large, i);
+    }
+    test_assert(ordered, "Long vector is in ascending order");
+    number_delete(large);
+
+    return 0;
+}
+
+// Test argsort keeps equal elements in order
+int test_vector_argsort() {
+    printf("\n=== Testing Vector Argsort ===\n");
+
+    NN_TYPE values[] = {2, 1, 2, 0, 1};
+    vector *v = vector_from_list(5, values);
+    size_t *order = vector_argsort(v, NULL);
+    test_assert(order != NULL, "Order found");
+    size_t expected[] = {3, 1, 4, 0, 2};
+    for (size_t i = 0; i < 5; i++) {
+        test_assert(order[i] == expected[i], "Rank %zu is index %zu", i, order[i]);
+    }
+    free(order);
+    number_delete(v);
+
+    vector *large = vector_create(200000);
+    vector_random_uniform(large, -1, 1);
+    order = vector_argsort(large, NULL);
+    int ordered = 1;
+    for (size_t i = 1; i < large->length; i++) {
+        ordered &= VECTOR(large, order[i - 1]) <= VECTOR(large, order[i]);
+    }
+    test_assert(ordered, "Long vector order is ascending");
+    free(order);
+    number_delete(large);
+
+    return 0;
+}
+
+// Test selection, top-k and quantiles
+int test_vector_selection() {
+    printf("\n=== Testing Vector Selection ===\n");
+
+    vector *v = vector_create(1001);
+    for (size_t i = 0; i < v->length; i++) {
+        VECTOR(v, i) = (NN_TYPE)((i * 7919) % 1001);
+    }
+
+    test_assert(vector_nth(v, 500) == 500, "Median selected");
+    int partitioned = 1;
+    for (size_t i = 0; i < v->length; i++) {
+        partitioned &= i < 500 ? VECTOR(v, i) <= 500 : VECTOR(v, i) >= 500;
+    }
+    test_assert(partitioned, "Vector partitioned around the median");
+    test_assert(vector_nth(v, 0) == 0, "Minimum selected");
+    test_assert(vector_nth(v, 1000) == 1000, "Maximum selected");
+
+    size_t top[3];
+    test_assert(vector_top_k(v, 3, top) == top, "Top 3 found");
+    test_assert(VECTOR(v, top[0]) == 1000 && VECTOR(v, top[1]) == 999 && VECTOR(v, top[2]) == 998,
+                "Top 3 from the largest down");
+
+    NN_TYPE p[] = {0, 0.25, 0.5, 0.999, 1};
+    vector *probabilities = vector_from_list(5, p);
+    vector *quantiles = vector_quantiles(v, probabilities, NULL);
+    test_assert(quantiles != NULL, "Quantiles calculated");
+    test_assert(VECTOR(quantiles, 0) == 0 && VECTOR(quantiles, 2) == 500 && VECTOR(quantiles, 4) == 1000,
+                "Quantiles at exact ranks");
+    test_assert(fabs(VECTOR(quantiles, 3) - 999) < 1e-3, "Quantile interpolated: %f", VECTOR(quantiles, 3));
+    number_delete(quantiles);
+    number_delete(probabilities);
+
+    vector *outside = vector_from_list(2, (NN_TYPE[]){0.5, 1.5});
+    vector *undefined = vector_from_list(1, (NN_TYPE[]){NAN});
+    test_assert(vector_quantiles(v, outside, NULL) == NULL, "Probabilities above 1 are rejected");
+    test_assert(vector_quantiles(v, undefined, NULL) == NULL, "NaN probabilities are rejected");
+    number_delete(outside);
+    number_delete(undefined);
+    number_delete(v);
+
+    /* NaNs rank last, as in vector_sort() */
+    NN_TYPE nans[][5]   = {{NAN, 3, 1, 2, 0}, {3, 2, NAN, NAN, 1}, {1, NAN, 0, NAN, 2}};
+    NN_TYPE sorted[][5] = {{0, 1, 2, 3, NAN}, {1, 2, 3, NAN, NAN}, {0, 1, 2, NAN, NAN}};
+    for (size_t c = 0; c < 3; c++) {
+        for (size_t n = 0; n < 5; n++) {
+            vector *w = vector_from_list(5, nans[c]);
+            NN_TYPE nth = vector_nth(w, n);
+            test_assert(isnan(sorted[c][n]) ? isnan(nth) : nth == sorted[c][n],
+                        "Element %zu of case %zu ranked with NaNs last: %f", n, c, nth);
+            number_delete(w);
+        }
+    }
+
+    vector *large = vector_create(300000);
+    for (size_t i = 0; i < large->length; i++) {
+        VECTOR(large, i) = (NN_TYPE)((i * 104729) % large->length);
+    }
+    size_t *best = vector_top_k(large, 5, NULL);
+    test_assert(best != NULL, "Top 5 of a long vector found");
+    int is_top = 1;
+    for (size_t i = 0; i < 5; i++) {
+        is_top &= VECTOR(large, best[i]) == large->length - 1 - i;
+    }
+    test_assert(is_top, "Top 5 merged from every thread");
+    free(best);
+    number_delete(large);
+
+    return 0;
+}
+
+int main() {
+    printf("=== Naive Numbers Vector Sort Test ===\n");
+
+    int result = 0;
+    result |= test_vector_sort();
+    result |= test_vector_argsort();
+    result |= test_vector_selection();
+
+    if (result == 0) {
+        printf("\nAll vector sort tests passed successfully!\n");
+    } else {
+        printf("\nSome tests failed!\n");
+    }
+
+    return result;
+}